@@ -0,0 +1,71 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+namespace im {
+
+/**
+ * 性能基准的公共工具：计时、命令行参数、临时目录
+ *
+ * 基准不加入 ctest，由人手动运行；输出为便于贴进提交说明的纯文本表格
+ */
+class Stopwatch {
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+    void reset() { start_ = std::chrono::steady_clock::now(); }
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    double millis() const { return seconds() * 1000.0; }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * 第 index 个命令行参数（从 1 开始），未给出时返回 fallback
+ */
+inline size_t argOr(int argc, char* argv[], int index, size_t fallback) {
+    return argc > index ? std::stoul(argv[index]) : fallback;
+}
+
+/**
+ * 在 /tmp 下创建独占的临时目录，析构时连同内容一起删除
+ */
+class TempDirectory {
+public:
+    TempDirectory() {
+        char pattern[] = "/tmp/imbench.XXXXXX";
+        if (mkdtemp(pattern)) {
+            path_ = pattern;
+        }
+    }
+
+    ~TempDirectory() {
+        if (!path_.empty()) {
+            std::error_code ec;
+            std::filesystem::remove_all(path_, ec);
+        }
+    }
+
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+
+    bool valid() const { return !path_.empty(); }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+}  // namespace im
+
+#endif  // BENCH_H
@@ -0,0 +1,680 @@
+#include "bench.h"
+#include "test_client.h"
+#include "database/group_roster_cache.h"
+#include "protocol/decoder.h"
+#include "protocol/encoder.h"
+#include "protocol/json_reader.h"
+#include "server/session_index.h"
+#include "server/timer_wheel.h"
+#include "store/message_store.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 组件级微基准，每个子命令测一个组件的单次操作耗时
+ *
+ * 用法：bench_components logger [条数=200000]
+ *   运行期被过滤的日志调用与实际写出（异步写文件）的日志调用各自的单次耗时，并核对写出条数
+ *       bench_components json [次数=200000]
+ *   解析一条典型 SEND_MESSAGE 数据体的单次耗时：JsonReader 单遍解析 vs 原先逐字段 regex_search
+ *       bench_components sessions [在线连接数=100000] [群成员数=500] [轮数=2000]
+ *   群消息扇出时为全部成员定位连接的耗时：SessionIndex::lookup vs 原先逐个成员遍历全部连接
+ *       bench_components roster [群数=1000] [每群成员数=2000] [发送次数=1000000]
+ *   群成员缓存下每秒群消息数：冷缓存（发送前 erase 该群，未命中后 put 重新填充）vs 热缓存（find 命中）；
+ *   冷缓存只含缓存本身的开销（排序、建快照），不含 MySQL 查询 group_members 的耗时
+ *       bench_components history [群消息数=1000000] [每页条数=50] [采样次数=1000]
+ *   从一个群会话向前翻页：第 1 页与第 1000 页（不足时取最后一页）各采样若干次 readBefore，输出 p50/p99
+ *       bench_components decoder [每档总字节=64MB] [帧体字节...=64 1024 65536]
+ *   按 4096 字节分块喂入 recv 数据，测量解码吞吐：连续缓冲区原地解码 vs 原先的复制式解码
+ *       bench_components fanout [群成员数=2000] [消息体字节=300] [消息数=200]
+ *   群消息放入每个成员连接的发送队列：共享同一编码帧 vs 原先每个成员各编码一次，输出耗时与每条消息复制的字节数
+ *       bench_components timers [定时器数=1000000]
+ *   时间轮：添加（30~90 秒随机延时，与连接超时相当）、全部重设、取消一半，再逐刻度推进到全部到期，
+ *   输出每次操作耗时、最慢的一个刻度（含整槽下放），并核对每个定时器都在预期刻度触发
+ *       bench_components heartbeat [每连接心跳数=20000] [每批=1] [连接数...=1 64]
+ *   回环连接按批发送 HEARTBEAT 并等齐应答：Reactor 线程直接应答（当前）vs 线程池应答（原先）。
+ *   线程池路径在每批前加一个 DELIVERY_ACK（无应答），使 Reactor 的心跳快速路径不生效；
+ *   输出每秒心跳数与服务端每 CPU 秒应答的心跳数（进程 CPU 时间减去客户端线程的 CPU 时间）
+ */
+namespace im {
+
+namespace {
+
+int benchLogger(size_t count) {
+    TempDirectory directory;
+    Logger::Options options;
+    options.level = Logger::Level::WARN;
+    options.filePath = directory.path() + "/bench.log";
+    Logger::init(options);
+
+    // 运行期过滤：级别高于 WARN 时 LOG_WARN 只做一次原子读，参数不求值
+    Logger::setLevel(Logger::Level::ERROR);
+    Stopwatch watch;
+    for (size_t i = 0; i < count; ++i) {
+        LOG_WARN("[基准] 被过滤的日志: i=", i, ", user_id=", "10001");
+    }
+    double suppressedNs = watch.seconds() * 1e9 / count;
+
+    Logger::setLevel(Logger::Level::WARN);
+    watch.reset();
+    for (size_t i = 0; i < count; ++i) {
+        LOG_WARN("[基准] 写出的日志: i=", i, ", user_id=", "10001");
+    }
+    double emittedNs = watch.seconds() * 1e9 / count;
+    Logger::shutdown();
+
+    size_t lines = 0;
+    std::ifstream file(options.filePath);
+    for (std::string line; std::getline(file, line);) {
+        lines += line.find("[基准] 写出的日志") != std::string::npos;
+    }
+    std::printf("logger: %zu 条, 被过滤 %.2f ns/次, 写出 %.1f ns/次, 文件中 %zu 条%s\n", count, suppressedNs,
+                emittedNs, lines, lines == count ? "" : "（有丢失）");
+    return lines == count ? 0 : 1;
+}
+
+struct SendFields {
+    std::string toUserId, content, messageType, conversationType, groupId, clientMsgId;
+};
+
+/**
+ * 与 MessageHandler::handle 相同的字段提取
+ */
+void parseWithReader(std::string_view body, SendFields& fields) {
+    JsonReader reader(body);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key == "to_user_id") {
+            value.copyTo(fields.toUserId);
+        } else if (key == "content") {
+            value.copyTo(fields.content);
+        } else if (key == "message_type") {
+            value.copyTo(fields.messageType);
+        } else if (key == "conversation_type") {
+            value.copyTo(fields.conversationType);
+        } else if (key == "group_id") {
+            value.copyTo(fields.groupId);
+        } else if (key == "client_msg_id") {
+            value.copyTo(fields.clientMsgId);
+        }
+    }
+}
+
+/**
+ * 改用 JsonReader 之前的做法：每个字段一个 regex，每条消息重新构造并各扫描一遍
+ */
+void parseWithRegex(const std::string& body, SendFields& fields) {
+    std::regex toUserIdRegex(R"(\"to_user_id\"\s*:\s*\"([^\"]+)\")");
+    std::regex contentRegex(R"(\"content\"\s*:\s*\"([^\"]+)\")");
+    std::regex messageTypeRegex(R"(\"message_type\"\s*:\s*\"([^\"]+)\")");
+    std::regex conversationTypeRegex(R"(\"conversation_type\"\s*:\s*\"([^\"]+)\")");
+    std::regex groupIdRegex(R"(\"group_id\"\s*:\s*\"([^\"]+)\")");
+    std::smatch match;
+    if (std::regex_search(body, match, toUserIdRegex)) {
+        fields.toUserId = match[1];
+    }
+    if (std::regex_search(body, match, contentRegex)) {
+        fields.content = match[1];
+    }
+    if (std::regex_search(body, match, messageTypeRegex)) {
+        fields.messageType = match[1];
+    }
+    if (std::regex_search(body, match, conversationTypeRegex)) {
+        fields.conversationType = match[1];
+    }
+    if (std::regex_search(body, match, groupIdRegex)) {
+        fields.groupId = match[1];
+    }
+}
+
+int benchJson(size_t count) {
+    const std::string body = R"({"to_user_id":"10002","conversation_type":"single","message_type":"text",)"
+                             R"("client_msg_id":"c-1700000000-42","content":"晚上一起吃饭吗？七点在老地方见，)"
+                             R"(记得带上上次借的书"})";
+    SendFields reader;
+    Stopwatch watch;
+    for (size_t i = 0; i < count; ++i) {
+        reader = SendFields();
+        parseWithReader(body, reader);
+    }
+    double readerNs = watch.seconds() * 1e9 / count;
+
+    // regex 每条要重新构造 5 个正则，慢三个数量级左右，次数缩小以免运行过久
+    size_t regexCount = std::max<size_t>(1, count / 100);
+    SendFields regex;
+    watch.reset();
+    for (size_t i = 0; i < regexCount; ++i) {
+        regex = SendFields();
+        parseWithRegex(body, regex);
+    }
+    double regexNs = watch.seconds() * 1e9 / regexCount;
+
+    bool same = reader.toUserId == regex.toUserId && reader.content == regex.content &&
+                reader.messageType == regex.messageType && reader.conversationType == regex.conversationType;
+    std::printf("json: %zu 字节, JsonReader %.0f ns/条 (%zu 次), regex %.0f ns/条 (%zu 次), %.1fx%s\n", body.size(),
+                readerNs, count, regexNs, regexCount, regexNs / readerNs, same ? "" : "（解析结果不一致）");
+    return same ? 0 : 1;
+}
+
+/**
+ * 改用 SessionIndex 之前的做法：每个成员遍历一遍 fd -> 连接表
+ */
+struct ScannedConnection {
+    bool authenticated = true;
+    std::string userId;
+};
+
+int scanForUser(std::mutex& mutex, const std::unordered_map<int, ScannedConnection>& connections,
+                const std::string& userId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [fd, connection] : connections) {
+        if (connection.authenticated && connection.userId == userId) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+int benchSessions(size_t sessionCount, size_t memberCount, size_t rounds) {
+    SessionIndex index;
+    std::mutex mutex;
+    std::unordered_map<int, ScannedConnection> connections;
+    for (size_t i = 0; i < sessionCount; ++i) {
+        std::string userId = std::to_string(100000 + i);
+        index.bind(userId, static_cast<int>(i) + 3);
+        connections[static_cast<int>(i) + 3].userId = std::move(userId);
+    }
+    // 成员一半在线（均匀分布在全部连接中），一半离线
+    std::vector<std::string> members;
+    for (size_t i = 0; i < memberCount; ++i) {
+        members.push_back(i % 2 ? std::to_string(100000 + i * sessionCount / memberCount)
+                                : "offline_" + std::to_string(i));
+    }
+
+    size_t online = 0;
+    Stopwatch watch;
+    for (size_t r = 0; r < rounds; ++r) {
+        online = 0;
+        for (int fd : index.lookup(members)) {
+            online += fd >= 0;
+        }
+    }
+    double lookupUs = watch.seconds() * 1e6 / rounds;
+
+    // 遍历方式每轮是 成员数 x 连接数，只测一轮
+    size_t scannedOnline = 0;
+    watch.reset();
+    for (const auto& userId : members) {
+        scannedOnline += scanForUser(mutex, connections, userId) >= 0;
+    }
+    double scanUs = watch.seconds() * 1e6;
+
+    std::printf("sessions: %zu 个连接, %zu 个成员 (在线 %zu), lookup %.1f us/次 (%zu 次), 遍历 %.0f us/次, %.0fx%s\n",
+                sessionCount, memberCount, online, lookupUs, rounds, scanUs, scanUs / lookupUs,
+                online == scannedOnline ? "" : "（结果不一致）");
+    return online == scannedOnline ? 0 : 1;
+}
+
+int benchRoster(size_t groupCount, size_t memberCount, size_t sends) {
+    GroupRosterCache& cache = GroupRosterCache::getInstance();
+    cache.setMemoryLimit(size_t(1) << 40);
+
+    // 数据库返回的顺序与 userId 字典序无关，按逆序构造以包含排序开销
+    std::vector<std::string> groupIds;
+    std::vector<GroupRoster> loaded(groupCount);
+    for (size_t g = 0; g < groupCount; ++g) {
+        for (size_t i = memberCount; i > 0; --i) {
+            loaded[g].userIds.push_back(std::to_string(100000 + g * memberCount + i));
+            loaded[g].roles.push_back(i == 1 ? GroupRoster::OWNER : GroupRoster::MEMBER);
+        }
+        groupIds.push_back("g" + std::to_string(g));
+    }
+    auto senderOf = [memberCount](size_t g, size_t i) {
+        return std::to_string(100000 + g * memberCount + 1 + i % memberCount);
+    };
+
+    // 冷缓存：每条消息的群都不在缓存中，未命中后用加载结果重新填充；每个群发一条
+    size_t coldSends = groupCount;
+    size_t misses = 0;
+    size_t accepted = 0;
+    Stopwatch watch;
+    for (size_t g = 0; g < coldSends; ++g) {
+        cache.erase(groupIds[g]);
+        GroupRosterPtr roster = cache.find(groupIds[g]);
+        if (!roster) {
+            ++misses;
+            cache.put(groupIds[g], loaded[g]);
+            roster = cache.find(groupIds[g]);
+        }
+        accepted += roster && roster->contains(senderOf(g, g));
+    }
+    double coldSeconds = watch.seconds();
+
+    // 热缓存：名单已在缓存中
+    watch.reset();
+    for (size_t i = 0; i < sends; ++i) {
+        size_t g = i % groupCount;
+        GroupRosterPtr roster = cache.find(groupIds[g]);
+        accepted += roster && roster->contains(senderOf(g, i));
+    }
+    double warmSeconds = watch.seconds();
+
+    GroupRosterCacheStats stats = cache.getStats();
+    std::printf("roster: %zu 个群 x %zu 人, 缓存约 %.1f MB\n", groupCount, memberCount,
+                stats.memoryBytes / double(1 << 20));
+    std::printf("  冷缓存: %zu 条 (未命中 %zu 次), %.0f 条/s (%.1f us/条, 不含查库)\n", coldSends, misses,
+                coldSends / coldSeconds, coldSeconds * 1e6 / coldSends);
+    std::printf("  热缓存: %zu 条, %.0f 条/s (%.0f ns/条)%s\n", sends, sends / warmSeconds, warmSeconds * 1e9 / sends,
+                accepted == coldSends + sends ? "" : "  (成员校验不符)");
+    return accepted == coldSends + sends ? 0 : 1;
+}
+
+int benchHistory(size_t total, size_t pageSize, size_t samples) {
+    TempDirectory directory;
+    MessageStoreOptions options;
+    options.directory = directory.path();
+    options.retention = std::chrono::hours(0);
+    MessageStore& store = MessageStore::getInstance();
+    if (!directory.valid() || !store.open(options)) {
+        std::fprintf(stderr, "消息存储打开失败\n");
+        return 1;
+    }
+
+    const std::string conversation = MessageStore::groupKey("bench");
+    const std::string body(200, 'x');
+    for (size_t i = 1; i < total; ++i) {
+        store.append(conversation, body);
+    }
+    std::promise<void> durable;
+    store.append(conversation, body, [&durable](uint64_t, bool) { durable.set_value(); });
+    durable.get_future().wait();
+
+    // 逐页向前走到第 1000 页，记下每页的 before_seq 游标
+    std::vector<uint64_t> cursors{UINT64_MAX};
+    while (cursors.size() < 1000) {
+        auto page = store.readBefore(conversation, cursors.back(), pageSize);
+        if (page.size() < pageSize || page.front().sequence <= 1) {
+            break;
+        }
+        cursors.push_back(page.front().sequence);
+    }
+
+    std::printf("history: 群会话 %zu 条, 每页 %zu 条, 每页采样 %zu 次\n", total, pageSize, samples);
+    std::printf("%8s %8s %10s %10s\n", "page", "msgs", "p50_us", "p99_us");
+    bool complete = true;
+    for (size_t index : {size_t(0), cursors.size() - 1}) {
+        std::vector<double> latencies;
+        size_t count = 0;
+        for (size_t s = 0; s < samples; ++s) {
+            Stopwatch watch;
+            count = store.readBefore(conversation, cursors[index], pageSize).size();
+            latencies.push_back(watch.seconds() * 1e6);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("%8zu %8zu %10.1f %10.1f\n", index + 1, count, latencies[latencies.size() / 2],
+                    latencies[latencies.size() * 99 / 100]);
+        complete = complete && count == std::min(pageSize, total - index * pageSize);
+    }
+    store.close();
+    return complete ? 0 : 1;
+}
+
+/**
+ * 原先的复制式解码（去掉了其中的日志）：每块追加到 vector，每包复制数据体并从头部 erase，
+ * 结果放进按值返回的队列
+ */
+class CopyingDecoder {
+public:
+    struct Packet {
+        MessageType type;
+        std::string data;
+    };
+
+    std::queue<Packet> addData(const uint8_t* data, size_t length) {
+        buffer_.insert(buffer_.end(), data, data + length);
+        std::queue<Packet> packets;
+        while (buffer_.size() >= HEADER_SIZE) {
+            uint16_t type;
+            uint32_t bodyLength;
+            std::memcpy(&type, buffer_.data() + 4, 2);
+            std::memcpy(&bodyLength, buffer_.data() + 6, 4);
+            bodyLength = ntohl(bodyLength);
+            if (buffer_.size() < HEADER_SIZE + bodyLength) {
+                break;
+            }
+            Packet packet{static_cast<MessageType>(ntohs(type)),
+                          std::string(buffer_.begin() + HEADER_SIZE, buffer_.begin() + HEADER_SIZE + bodyLength)};
+            packets.push(packet);
+            buffer_.erase(buffer_.begin(), buffer_.begin() + HEADER_SIZE + bodyLength);
+        }
+        return packets;
+    }
+
+private:
+    std::vector<uint8_t> buffer_;
+};
+
+constexpr size_t RECV_CHUNK_SIZE = 4096;  // 与 Reactor 每次 recv 的初始读缓冲区相同
+
+int benchDecoder(size_t totalBytes, const std::vector<size_t>& bodySizes) {
+    std::printf("decoder: 每档约 %zu 字节, 每次喂入 %zu 字节\n", totalBytes, RECV_CHUNK_SIZE);
+    std::printf("%10s %10s %14s %14s %14s %14s\n", "body", "frames", "view MB/s", "view pkts/s", "copy MB/s",
+                "copy pkts/s");
+    bool complete = true;
+    for (size_t bodySize : bodySizes) {
+        std::vector<uint8_t> frame = MessageEncoder::encode(MessageType::SEND_MESSAGE, std::string(bodySize, 'x'));
+        size_t frames = std::max<size_t>(1, totalBytes / frame.size());
+        std::vector<uint8_t> stream;
+        stream.reserve(frames * frame.size());
+        for (size_t i = 0; i < frames; ++i) {
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        MessageDecoder decoder;
+        size_t viewFrames = 0;
+        Stopwatch watch;
+        for (size_t offset = 0; offset < stream.size();) {
+            size_t length = std::min(stream.size() - offset, decoder.prepareWrite(RECV_CHUNK_SIZE));
+            std::memcpy(decoder.writeData(), stream.data() + offset, length);
+            decoder.commitWrite(length);
+            offset += length;
+            PacketView packet;
+            while (decoder.nextPacket(packet)) {
+                viewFrames += packet.data.size() == bodySize;
+                decoder.consume();
+            }
+        }
+        double viewSeconds = watch.seconds();
+
+        CopyingDecoder copying;
+        size_t copyFrames = 0;
+        watch.reset();
+        for (size_t offset = 0; offset < stream.size(); offset += RECV_CHUNK_SIZE) {
+            std::queue<CopyingDecoder::Packet> packets =
+                copying.addData(stream.data() + offset, std::min(RECV_CHUNK_SIZE, stream.size() - offset));
+            for (; !packets.empty(); packets.pop()) {
+                copyFrames += packets.front().data.size() == bodySize;
+            }
+        }
+        double copySeconds = watch.seconds();
+
+        double megabytes = stream.size() / double(1 << 20);
+        std::printf("%10zu %10zu %14.1f %14.0f %14.1f %14.0f%s\n", bodySize, frames, megabytes / viewSeconds,
+                    frames / viewSeconds, megabytes / copySeconds, frames / copySeconds,
+                    viewFrames == frames && copyFrames == frames ? "" : "  (帧数不符)");
+        complete = complete && viewFrames == frames && copyFrames == frames;
+    }
+    return complete ? 0 : 1;
+}
+
+int benchFanout(size_t members, size_t bodySize, size_t messages) {
+    const std::string body(bodySize, 'x');
+    const size_t frameSize = HEADER_SIZE + bodySize;
+
+    // 每轮结束时清空队列，相当于连接已把帧写出
+    std::vector<std::deque<Frame>> sharedQueues(members);
+    Stopwatch watch;
+    for (size_t m = 0; m < messages; ++m) {
+        Frame frame = makeFrame(MessageEncoder::encode(MessageType::RECEIVE_MESSAGE, body));
+        for (auto& queue : sharedQueues) {
+            queue.push_back(frame);
+        }
+        for (auto& queue : sharedQueues) {
+            queue.clear();
+        }
+    }
+    double sharedUs = watch.seconds() * 1e6 / messages;
+
+    std::vector<std::deque<std::vector<uint8_t>>> copiedQueues(members);
+    watch.reset();
+    for (size_t m = 0; m < messages; ++m) {
+        for (auto& queue : copiedQueues) {
+            queue.push_back(MessageEncoder::encode(MessageType::RECEIVE_MESSAGE, body));
+        }
+        for (auto& queue : copiedQueues) {
+            queue.clear();
+        }
+    }
+    double copiedUs = watch.seconds() * 1e6 / messages;
+
+    std::printf("fanout: %zu 个成员, 帧 %zu 字节, %zu 条消息\n", members, frameSize, messages);
+    std::printf("  共享帧: %.1f us/条, 每条编码 1 次, 复制 %zu 字节\n", sharedUs, frameSize);
+    std::printf("  逐个编码: %.1f us/条, 每条编码 %zu 次, 复制 %zu 字节\n", copiedUs, members, frameSize * members);
+    return 0;
+}
+
+struct TimerProbe {
+    uint64_t currentTick = 0;
+    size_t fired = 0;
+    size_t early = 0;  // 不在预期刻度触发的定时器数
+};
+
+int benchTimers(size_t count) {
+    using Clock = TimerWheel::Clock;
+    const std::chrono::milliseconds tickLength(100);
+    const Clock::time_point start = Clock::now();
+    TimerWheel wheel(tickLength, start);
+    TimerProbe probe;
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> delays(30000, 90000);
+    std::vector<TimerWheel::TimerId> ids(count);
+    std::vector<uint64_t> expected(count);  // 重设后的到期刻度
+    std::vector<std::chrono::milliseconds> renewals(count);
+    for (auto& renewal : renewals) {
+        renewal = std::chrono::milliseconds(delays(random));
+    }
+
+    Stopwatch watch;
+    for (size_t i = 0; i < count; ++i) {
+        std::chrono::milliseconds delay(delays(random));
+        ids[i] = wheel.add(delay, [&probe, &expected, i] {
+            ++probe.fired;
+            probe.early += probe.currentTick != expected[i];
+        });
+    }
+    double addNs = watch.seconds() * 1e9 / count;
+
+    // 全部重设为新的随机延时（连接续期的开销），定时器通常换到另一个槽
+    for (size_t i = 0; i < count; ++i) {
+        expected[i] = (renewals[i].count() + tickLength.count() - 1) / tickLength.count();
+    }
+    watch.reset();
+    size_t rescheduled = 0;
+    for (size_t i = 0; i < count; ++i) {
+        rescheduled += wheel.reschedule(ids[i], renewals[i]);
+    }
+    double rescheduleNs = watch.seconds() * 1e9 / count;
+
+    watch.reset();
+    size_t cancelled = 0;
+    for (size_t i = 0; i < count; i += 2) {
+        cancelled += wheel.cancel(ids[i]);
+    }
+    double cancelNs = watch.seconds() * 1e9 / std::max<size_t>(1, (count + 1) / 2);
+
+    double worstTickMs = 0;
+    uint64_t worstTick = 0;
+    watch.reset();
+    for (uint64_t tick = 1; wheel.size() > 0; ++tick) {
+        probe.currentTick = tick;
+        Stopwatch tickWatch;
+        wheel.advance(start + tick * tickLength);
+        double tickMs = tickWatch.millis();
+        if (tickMs > worstTickMs) {
+            worstTickMs = tickMs;
+            worstTick = tick;
+        }
+    }
+    double advanceSeconds = watch.seconds();
+
+    size_t remaining = count - cancelled;
+    std::printf("timers: %zu 个, 刻度 %lld ms\n", count, static_cast<long long>(tickLength.count()));
+    std::printf("  添加 %.0f ns/个, 重设 %.0f ns/个, 取消 %.0f ns/个\n", addNs, rescheduleNs, cancelNs);
+    std::printf("  推进: 触发 %zu 个, %.0f ns/个, 最慢刻度 %.2f ms (第 %llu 个刻度), 非预期刻度触发 %zu 个\n",
+                probe.fired, advanceSeconds * 1e9 / std::max<size_t>(1, probe.fired), worstTickMs,
+                static_cast<unsigned long long>(worstTick), probe.early);
+    bool ok = rescheduled == count && probe.fired == remaining && probe.early == 0;
+    return ok ? 0 : 1;
+}
+
+double cpuSeconds(clockid_t clock) {
+    timespec now{};
+    clock_gettime(clock, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+struct HeartbeatRun {
+    double seconds = 0;
+    double serverCpuSeconds = 0;
+    size_t answered = 0;
+};
+
+HeartbeatRun runHeartbeats(size_t connections, size_t perConnection, size_t batch, bool inlinePath) {
+    TestServer server;
+    std::vector<std::unique_ptr<TestClient>> clients;
+    for (size_t i = 0; i < connections; ++i) {
+        clients.push_back(std::make_unique<TestClient>(server.port()));
+        if (server.authenticateNext("hb" + std::to_string(i)) < 0) {
+            return {};
+        }
+    }
+
+    std::vector<uint8_t> payload;
+    if (!inlinePath) {
+        payload = MessageEncoder::encode(MessageType::DELIVERY_ACK, R"({"msg_id":0})");
+    }
+    std::vector<uint8_t> heartbeat = MessageEncoder::encode(MessageType::HEARTBEAT, "{}");
+    for (size_t i = 0; i < batch; ++i) {
+        payload.insert(payload.end(), heartbeat.begin(), heartbeat.end());
+    }
+    size_t rounds = std::max<size_t>(1, perConnection / batch);
+
+    std::atomic<size_t> answered{0};
+    std::atomic<uint64_t> clientCpuNs{0};
+    double processCpu = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID);
+    Stopwatch watch;
+    std::vector<std::thread> threads;
+    for (auto& client : clients) {
+        threads.emplace_back([&, client = client.get()] {
+            double threadCpu = cpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+            size_t count = 0;
+            PacketView packet;
+            for (size_t r = 0; r < rounds && client->sendRaw(payload.data(), payload.size()); ++r) {
+                for (size_t pending = batch; pending > 0 && client->receive(packet);) {
+                    if (packet.type == MessageType::HEARTBEAT_RESPONSE) {
+                        --pending;
+                        ++count;
+                    }
+                }
+            }
+            answered += count;
+            clientCpuNs += static_cast<uint64_t>((cpuSeconds(CLOCK_THREAD_CPUTIME_ID) - threadCpu) * 1e9);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    HeartbeatRun run;
+    run.seconds = watch.seconds();
+    run.serverCpuSeconds = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID) - processCpu - clientCpuNs / 1e9;
+    run.answered = answered;
+    return run;
+}
+
+int benchHeartbeat(size_t perConnection, size_t batch, const std::vector<size_t>& connectionCounts) {
+    Logger::setLevel(Logger::Level::WARN);
+    std::printf("heartbeat: 每连接 %zu 个心跳, 每批 %zu 个, CPU 核数 %u\n", perConnection, batch,
+                std::thread::hardware_concurrency());
+    std::printf("%8s %8s %12s %14s %16s\n", "conns", "path", "answered", "heartbeats/s", "per server cpu-s");
+    bool complete = true;
+    for (size_t connections : connectionCounts) {
+        for (bool inlinePath : {false, true}) {
+            HeartbeatRun run = runHeartbeats(connections, perConnection, batch, inlinePath);
+            size_t expected = connections * std::max<size_t>(1, perConnection / batch) * batch;
+            std::printf("%8zu %8s %12zu %14.0f %16.0f%s\n", connections, inlinePath ? "reactor" : "pool",
+                        run.answered, run.answered / run.seconds,
+                        run.serverCpuSeconds > 0 ? run.answered / run.serverCpuSeconds : 0.0,
+                        run.answered == expected ? "" : "  (应答缺失)");
+            complete = complete && run.answered == expected;
+        }
+    }
+    return complete ? 0 : 1;
+}
+
+}  // namespace
+
+}  // namespace im
+
+int main(int argc, char* argv[]) {
+    using namespace im;
+    const char* command = argc > 1 ? argv[1] : "";
+    if (std::strcmp(command, "logger") == 0) {
+        return benchLogger(argOr(argc, argv, 2, 200000));
+    }
+    if (std::strcmp(command, "json") == 0) {
+        return benchJson(std::max<size_t>(1, argOr(argc, argv, 2, 200000)));
+    }
+    if (std::strcmp(command, "sessions") == 0) {
+        return benchSessions(std::max<size_t>(1, argOr(argc, argv, 2, 100000)), argOr(argc, argv, 3, 500),
+                             std::max<size_t>(1, argOr(argc, argv, 4, 2000)));
+    }
+    if (std::strcmp(command, "roster") == 0) {
+        return benchRoster(std::max<size_t>(1, argOr(argc, argv, 2, 1000)),
+                           std::max<size_t>(1, argOr(argc, argv, 3, 2000)),
+                           std::max<size_t>(1, argOr(argc, argv, 4, 1000000)));
+    }
+    if (std::strcmp(command, "history") == 0) {
+        return benchHistory(std::max<size_t>(1, argOr(argc, argv, 2, 1000000)),
+                            std::max<size_t>(1, argOr(argc, argv, 3, 50)),
+                            std::max<size_t>(1, argOr(argc, argv, 4, 1000)));
+    }
+    if (std::strcmp(command, "decoder") == 0) {
+        std::vector<size_t> bodySizes;
+        for (int i = 3; i < argc; ++i) {
+            bodySizes.push_back(std::stoul(argv[i]));
+        }
+        if (bodySizes.empty()) {
+            bodySizes = {64, 1024, 65536};
+        }
+        return benchDecoder(argOr(argc, argv, 2, 64 << 20), bodySizes);
+    }
+    if (std::strcmp(command, "fanout") == 0) {
+        return benchFanout(std::max<size_t>(1, argOr(argc, argv, 2, 2000)), argOr(argc, argv, 3, 300),
+                           std::max<size_t>(1, argOr(argc, argv, 4, 200)));
+    }
+    if (std::strcmp(command, "timers") == 0) {
+        return benchTimers(std::max<size_t>(1, argOr(argc, argv, 2, 1000000)));
+    }
+    if (std::strcmp(command, "heartbeat") == 0) {
+        std::vector<size_t> connectionCounts;
+        for (int i = 4; i < argc; ++i) {
+            connectionCounts.push_back(std::max<size_t>(1, std::stoul(argv[i])));
+        }
+        if (connectionCounts.empty()) {
+            connectionCounts = {1, 64};
+        }
+        return benchHeartbeat(std::max<size_t>(1, argOr(argc, argv, 2, 20000)),
+                              std::max<size_t>(1, argOr(argc, argv, 3, 1)), connectionCounts);
+    }
+    std::fprintf(stderr, "用法: %s logger|json|sessions|roster|history|decoder|fanout|timers|heartbeat [参数...]\n",
+                 argv[0]);
+    return 1;
+}
@@ -0,0 +1,144 @@
+#include "bench.h"
+#include "test_client.h"
+#include "protocol/json_reader.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * 建群延迟随成员数的变化：从发出 GROUP_CREATE_REQUEST 到收到 GROUP_CREATE_RESPONSE
+ *
+ * 用法：bench_group_create <端口> [每档重复次数=3] [成员数...=0 10 50 100 500]
+ * 连接本机运行中的 imserver（需要可用的 MySQL）。首次运行会注册 bench_owner 与 bench_m<i> 测试账号
+ * （之后直接登录），每次建的群测完即解散，不留下群数据
+ */
+namespace im {
+
+namespace {
+
+const std::string BENCH_PASSWORD = "bench_password";
+
+/**
+ * 接收直到出现指定类型的帧，跳过期间的其他推送（离线同步、在线状态等）
+ */
+bool waitFor(TestClient& client, MessageType type, PacketView& packet) {
+    while (client.receive(packet, std::chrono::seconds(30))) {
+        if (packet.type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 取出响应中的 success 与 idKey（可在嵌套的 objectKey 对象内）
+ */
+bool parseResult(std::string_view body, std::string_view idKey, std::string& id, std::string_view objectKey = {}) {
+    bool success = false;
+    JsonReader reader(body);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key == "success") {
+            value.getBool(success);
+        } else if (key == idKey) {
+            value.copyTo(id);
+        } else if (!objectKey.empty() && key == objectKey && value.type() == JsonValue::Type::OBJECT) {
+            parseResult(value.raw(), idKey, id);
+        }
+    }
+    return success;
+}
+
+/**
+ * 以 username 登录，账号不存在时注册；返回 user_id，失败返回空
+ */
+std::string signIn(TestClient& client, const std::string& username) {
+    std::string credentials = R"({"username":")" + username + R"(","password":")" + BENCH_PASSWORD + R"("})";
+    PacketView packet;
+    std::string userId;
+    if (client.send(MessageType::LOGIN_REQUEST, credentials) && waitFor(client, MessageType::LOGIN_RESPONSE, packet) &&
+        parseResult(packet.data, "user_id", userId)) {
+        return userId;
+    }
+    if (client.send(MessageType::REGISTER_REQUEST, credentials) &&
+        waitFor(client, MessageType::REGISTER_RESPONSE, packet) && parseResult(packet.data, "user_id", userId)) {
+        return userId;
+    }
+    return {};
+}
+
+}  // namespace
+
+}  // namespace im
+
+int main(int argc, char* argv[]) {
+    using namespace im;
+    Logger::setLevel(Logger::Level::WARN);
+
+    if (argc < 2) {
+        std::fprintf(stderr, "用法: %s <端口> [每档重复次数] [成员数...]\n", argv[0]);
+        return 1;
+    }
+    int port = std::stoi(argv[1]);
+    size_t repeats = std::max<size_t>(1, argOr(argc, argv, 2, 3));
+    std::vector<size_t> memberCounts;
+    for (int i = 3; i < argc; ++i) {
+        memberCounts.push_back(std::stoul(argv[i]));
+    }
+    if (memberCounts.empty()) {
+        memberCounts = {0, 10, 50, 100, 500};
+    }
+
+    // 准备成员账号：同一连接依次切换登录
+    size_t maxMembers = *std::max_element(memberCounts.begin(), memberCounts.end());
+    std::vector<std::string> memberIds;
+    {
+        TestClient registrar(port);
+        for (size_t i = 0; i < maxMembers; ++i) {
+            std::string userId = signIn(registrar, "bench_m" + std::to_string(i));
+            if (userId.empty()) {
+                std::fprintf(stderr, "准备测试账号失败: bench_m%zu\n", i);
+                return 1;
+            }
+            memberIds.push_back(std::move(userId));
+        }
+    }
+
+    TestClient owner(port);
+    if (signIn(owner, "bench_owner").empty()) {
+        std::fprintf(stderr, "登录 bench_owner 失败\n");
+        return 1;
+    }
+
+    std::printf("%8s %10s %10s\n", "members", "best_ms", "median_ms");
+    PacketView packet;
+    for (size_t count : memberCounts) {
+        std::string request = R"({"group_name":"bench","member_user_ids":[)";
+        for (size_t i = 0; i < count; ++i) {
+            request += (i ? ",\"" : "\"") + memberIds[i] + "\"";
+        }
+        request += "]}";
+
+        std::vector<double> latencies;
+        for (size_t r = 0; r < repeats; ++r) {
+            Stopwatch watch;
+            std::string groupId;
+            if (!owner.send(MessageType::GROUP_CREATE_REQUEST, request) ||
+                !waitFor(owner, MessageType::GROUP_CREATE_RESPONSE, packet) ||
+                !parseResult(packet.data, "group_id", groupId, "group")) {
+                std::fprintf(stderr, "建群失败: members=%zu\n", count);
+                return 1;
+            }
+            latencies.push_back(watch.millis());
+
+            owner.send(MessageType::GROUP_DISMISS_REQUEST, R"({"group_id":")" + groupId + R"("})");
+            waitFor(owner, MessageType::GROUP_DISMISS_RESPONSE, packet);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("%8zu %10.2f %10.2f\n", count, latencies.front(), latencies[latencies.size() / 2]);
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "bench.h"
+#include "test_client.h"
+#include "handler/offline_handler.h"
+#include "protocol/encoder.h"
+#include "protocol/json_reader.h"
+#include "store/message_store.h"
+#include "utils/logger.h"
+#include <cstdio>
+#include <future>
+#include <string>
+#include <vector>
+
+/**
+ * 离线消息登录同步：收件箱积压 N 条时，从登录推送第一页到客户端按页拉完的耗时
+ *
+ * 用法：bench_offline_sync [积压条数=10000] [每页条数...=200 1000]
+ * 经由真实的 OfflineHandler 与回环连接（登录直接认证，不访问数据库），消息存储写在临时目录
+ */
+namespace im {
+
+namespace {
+
+struct PageInfo {
+    size_t count = 0;
+    int64_t lastSeq = 0;
+    bool hasMore = false;
+};
+
+PageInfo parsePage(std::string_view body) {
+    PageInfo page;
+    JsonReader reader(body);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key == "messages") {
+            JsonArrayReader messages(value);
+            JsonValue element;
+            while (messages.next(element)) {
+                ++page.count;
+            }
+        } else if (key == "last_seq") {
+            value.getInt(page.lastSeq);
+        } else if (key == "has_more") {
+            value.getBool(page.hasMore);
+        }
+    }
+    return page;
+}
+
+/**
+ * 与 MessageHandler 写入收件箱的 RECEIVE_MESSAGE 数据体大小相当
+ */
+std::string messageBody(size_t index) {
+    return R"({"msg_id":")" + std::to_string(1000000000000 + index) +
+           R"(","conversation_type":"single","from_user_id":"10001","from_username":"sender",)"
+           R"("content":"offline message number )" + std::to_string(index) +
+           R"( with some padding text","message_type":"text","timestamp":1700000000,"to_user_id":"10002"})";
+}
+
+}  // namespace
+
+}  // namespace im
+
+int main(int argc, char* argv[]) {
+    using namespace im;
+    Logger::setLevel(Logger::Level::WARN);
+
+    size_t pending = argOr(argc, argv, 1, 10000);
+    std::vector<size_t> pageSizes;
+    for (int i = 2; i < argc; ++i) {
+        pageSizes.push_back(std::stoul(argv[i]));
+    }
+    if (pageSizes.empty()) {
+        pageSizes = {OfflineHandler::DEFAULT_PAGE_SIZE, OfflineHandler::MAX_PAGE_SIZE};
+    }
+
+    TempDirectory directory;
+    MessageStoreOptions options;
+    options.directory = directory.path();
+    MessageStore& store = MessageStore::getInstance();
+    if (!directory.valid() || !store.open(options)) {
+        std::fprintf(stderr, "消息存储打开失败\n");
+        return 1;
+    }
+
+    TestServer server;
+    bool complete = true;
+    std::printf("%10s %8s %8s %10s %12s %12s\n", "page_size", "pages", "msgs", "bytes", "first_ms", "total_ms");
+    for (size_t pageSize : pageSizes) {
+        std::string userId = "bench_" + std::to_string(pageSize);
+        for (size_t i = 0; i < pending; ++i) {
+            OfflineHandler::store(server.server(), userId, messageBody(i));
+        }
+        // 写线程按序号顺序落盘，标记消息落盘后收件箱已全部可读
+        std::promise<void> durable;
+        store.append("u:bench:marker", "{}", [&durable](uint64_t, bool) { durable.set_value(); });
+        durable.get_future().wait();
+
+        TestClient client(server.port());
+        int fd = server.authenticateNext(userId);
+        if (fd < 0) {
+            std::fprintf(stderr, "认证测试连接失败\n");
+            return 1;
+        }
+
+        Stopwatch watch;
+        OfflineHandler::syncOnLogin(server.server(), fd, userId, std::nullopt);
+        size_t pages = 0;
+        size_t messages = 0;
+        size_t bytes = 0;
+        double firstMs = 0;
+        PacketView packet;
+        while (client.receive(packet)) {
+            if (packet.type != MessageType::OFFLINE_SYNC_RESPONSE) {
+                continue;
+            }
+            PageInfo page = parsePage(packet.data);
+            if (pages++ == 0) {
+                firstMs = watch.millis();
+            }
+            messages += page.count;
+            bytes += HEADER_SIZE + packet.data.size();
+            if (!page.hasMore) {
+                break;
+            }
+            client.send(MessageType::OFFLINE_SYNC_REQUEST, R"({"after_seq":)" + std::to_string(page.lastSeq) +
+                                                              R"(,"limit":)" + std::to_string(pageSize) + "}");
+        }
+        double totalMs = watch.millis();
+        std::printf("%10zu %8zu %8zu %10zu %12.2f %12.2f%s\n", pageSize, pages, messages, bytes, firstMs, totalMs,
+                    messages == pending ? "" : "  (条数不符)");
+        complete = complete && messages == pending;
+    }
+
+    store.close();
+    return complete ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+#include "bench.h"
+#include "test_client.h"
+#include "protocol/json_reader.h"
+#include "utils/logger.h"
+#include <sys/resource.h>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 在线状态：客户端轮询 USER_LIST_REQUEST 与服务端推送 PRESENCE_NOTIFY 每分钟发出的字节数
+ *
+ * 用法：bench_presence [在线用户数=10000] [每人联系人数=250] [每分钟上下线次数=100] [轮询间隔秒=30]
+ * N 个回环连接直接认证为在线用户（不访问数据库）。轮询：抽样若干连接发 USER_LIST_REQUEST，
+ * 按实际收到的响应字节数折算全体用户每分钟的流量；推送：一半次数下线、一半重新上线，
+ * 受众由注入的联系人表代替查库（用户 i 的联系人为 i+1 .. i+联系人数），统计实际发出的
+ * PRESENCE_NOTIFY 字节数并与客户端收到的字节数核对。每个用户占两个 fd，需要 ulimit -n 足够大
+ */
+namespace im {
+
+namespace {
+
+constexpr std::chrono::milliseconds PRESENCE_WINDOW(200);
+constexpr size_t POLL_SAMPLES = 20;
+
+std::string userIdOf(size_t index) {
+    return std::to_string(100000 + index);
+}
+
+size_t countUsers(std::string_view body) {
+    size_t count = 0;
+    JsonReader reader(body);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key == "users") {
+            JsonArrayReader users(value);
+            JsonValue element;
+            while (users.next(element)) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * 等待推送批次处理完 expected 个状态变化
+ */
+bool waitForChanges(EpollServer& server, uint64_t expected) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (server.getPresenceStats().changes < expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+/**
+ * 读出连接上已到达的全部帧，返回其中 PRESENCE_NOTIFY 的字节数
+ */
+size_t drainNotifies(TestClient& client) {
+    size_t bytes = 0;
+    PacketView packet;
+    while (client.receive(packet, std::chrono::milliseconds(0))) {
+        if (packet.type == MessageType::PRESENCE_NOTIFY) {
+            bytes += HEADER_SIZE + packet.data.size();
+        }
+    }
+    return bytes;
+}
+
+}  // namespace
+
+}  // namespace im
+
+int main(int argc, char* argv[]) {
+    using namespace im;
+    Logger::setLevel(Logger::Level::WARN);
+
+    size_t users = std::max<size_t>(2, argOr(argc, argv, 1, 10000));
+    size_t contacts = std::min(users - 1, argOr(argc, argv, 2, 250));
+    size_t churn = std::max<size_t>(2, argOr(argc, argv, 3, 100)) / 2 * 2;
+    size_t pollSeconds = std::max<size_t>(1, argOr(argc, argv, 4, 30));
+
+    // 客户端与服务端各占一个 fd
+    rlimit limit{};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    if (users * 2 + 64 > limit.rlim_cur) {
+        std::fprintf(stderr, "fd 上限 %llu 不足以容纳 %zu 个用户（需要约 %zu）\n",
+                     static_cast<unsigned long long>(limit.rlim_cur), users, users * 2 + 64);
+        return 1;
+    }
+
+    // 建立连接期间的上线事件不推送，只测量之后的上下线
+    std::atomic<bool> measuring{false};
+    auto audience = [&measuring, users, contacts](const std::string& userId) {
+        std::vector<std::string> recipients;
+        if (measuring.load(std::memory_order_acquire)) {
+            size_t index = std::stoul(userId) - 100000;
+            for (size_t k = 1; k <= contacts; ++k) {
+                recipients.push_back(userIdOf((index + k) % users));
+            }
+        }
+        return recipients;
+    };
+    TestServer server(2, PRESENCE_WINDOW, audience);
+
+    Stopwatch watch;
+    std::vector<std::unique_ptr<TestClient>> clients;
+    for (size_t i = 0; i < users; ++i) {
+        clients.push_back(std::make_unique<TestClient>(server.port()));
+        if (server.authenticateNext(userIdOf(i), "user_" + userIdOf(i)) < 0) {
+            std::fprintf(stderr, "认证第 %zu 个连接失败\n", i);
+            return 1;
+        }
+    }
+    if (!waitForChanges(server.server(), users)) {
+        std::fprintf(stderr, "等待上线事件处理超时\n");
+        return 1;
+    }
+    std::printf("presence: %zu 个在线用户, 每人 %zu 个联系人, 建立连接 %.1f s\n", users, contacts, watch.seconds());
+
+    // 轮询：抽样连接各拉一次完整在线列表
+    size_t samples = std::min(users, POLL_SAMPLES);
+    size_t pollBytes = 0;
+    PacketView packet;
+    for (size_t s = 0; s < samples; ++s) {
+        TestClient& client = *clients[s * users / samples];
+        client.send(MessageType::USER_LIST_REQUEST, "{}");
+        bool received = false;
+        while (client.receive(packet)) {
+            if (packet.type == MessageType::USER_LIST_RESPONSE) {
+                received = countUsers(packet.data) == users;
+                pollBytes += HEADER_SIZE + packet.data.size();
+                break;
+            }
+        }
+        if (!received) {
+            std::fprintf(stderr, "在线列表响应缺失或人数不符\n");
+            return 1;
+        }
+    }
+    double responseBytes = static_cast<double>(pollBytes) / samples;
+    double pollPerMinute = users * (60.0 / pollSeconds) * responseBytes;
+
+    // 推送：一半下线，处理完后再重新上线
+    measuring.store(true, std::memory_order_release);
+    PresenceStats before = server.server().getPresenceStats();
+    std::vector<size_t> churned;
+    for (size_t c = 0; c < churn / 2; ++c) {
+        churned.push_back(c * users / (churn / 2));
+    }
+    for (size_t index : churned) {
+        clients[index].reset();
+    }
+    bool flushed = waitForChanges(server.server(), before.changes + churned.size());
+    for (size_t index : churned) {
+        clients[index] = std::make_unique<TestClient>(server.port());
+        flushed = flushed && server.authenticateNext(userIdOf(index), "user_" + userIdOf(index)) >= 0;
+    }
+    flushed = flushed && waitForChanges(server.server(), before.changes + churn);
+    if (!flushed) {
+        std::fprintf(stderr, "等待上下线推送超时\n");
+        return 1;
+    }
+    PresenceStats after = server.server().getPresenceStats();
+    uint64_t pushBytes = after.bytes - before.bytes;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    size_t receivedBytes = 0;
+    for (auto& client : clients) {
+        receivedBytes += drainNotifies(*client);
+    }
+
+    std::printf("  轮询: USER_LIST_RESPONSE 平均 %.0f 字节 (%zu 次采样), 每 %zu 秒一次: %.1f MB/分钟\n",
+                responseBytes, samples, pollSeconds, pollPerMinute / (1 << 20));
+    std::printf("  推送: 每分钟上下线 %zu 次, %llu 个批次, %llu 帧 PRESENCE_NOTIFY, 发出 %llu 字节, "
+                "客户端收到 %zu 字节: %.3f MB/分钟\n",
+                churn, static_cast<unsigned long long>(after.flushes - before.flushes),
+                static_cast<unsigned long long>(after.notifies - before.notifies),
+                static_cast<unsigned long long>(pushBytes), receivedBytes,
+                static_cast<double>(pushBytes) / (1 << 20));
+    std::printf("  轮询 / 推送 = %.0fx\n", pushBytes ? pollPerMinute / pushBytes : 0.0);
+    return receivedBytes == pushBytes ? 0 : 1;
+}
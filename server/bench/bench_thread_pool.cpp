@@ -0,0 +1,201 @@
+#include "bench.h"
+#include "thread_pool/thread_pool.h"
+#include "utils/logger.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * 线程池吞吐
+ *
+ * 用法：bench_thread_pool submit [工作线程=4] [任务数=2000000] [生产者数...=1 2 4 8 16 32 64]
+ *   多个外部线程并发提交捕获 shared_ptr 的小任务（与 Reactor 提交的读任务相当），测量每秒完成的任务数；
+ *   对比原先的 std::function + 互斥锁队列与当前的无锁环形队列
+ *       bench_thread_pool spawn [工作线程=4] [父任务数=200] [子任务数...=1000 10000]
+ *   每个父任务在工作线程中再提交 N 个子任务，对比全局队列与工作窃取两种模式
+ */
+namespace im {
+
+namespace {
+
+/**
+ * 任务全部执行完时兑现 promise
+ */
+struct Completion {
+    explicit Completion(size_t total) : total(total) {}
+
+    void done() {
+        if (finished.fetch_add(1, std::memory_order_acq_rel) + 1 == total) {
+            promise.set_value();
+        }
+    }
+
+    size_t total;
+    std::atomic<size_t> finished{0};
+    std::promise<void> promise;
+};
+
+/**
+ * 原先的线程池：std::queue<std::function> + 互斥锁 + 条件变量，作为对比基线
+ */
+class LockedThreadPool {
+public:
+    explicit LockedThreadPool(size_t numThreads) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            workers_.emplace_back([this] { worker(); });
+        }
+    }
+
+    ~LockedThreadPool() { stop(); }
+
+    template <typename F>
+    void submit(F&& task) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            if (stop_) {
+                return;
+            }
+            tasks_.emplace(std::forward<F>(task));
+        }
+        condition_.notify_one();
+    }
+
+    void stop() {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            if (stop_) {
+                return;
+            }
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+    }
+
+private:
+    void worker() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex_);
+                condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex queueMutex_;
+    std::condition_variable condition_;
+    bool stop_ = false;
+};
+
+template <typename Pool>
+double runSubmit(size_t workers, size_t tasks, size_t producers) {
+    Pool pool(workers);
+    auto completion = std::make_shared<Completion>(tasks);
+    std::future<void> finished = completion->promise.get_future();
+
+    Stopwatch watch;
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        size_t count = tasks / producers + (p < tasks % producers ? 1 : 0);
+        threads.emplace_back([&pool, completion, count] {
+            for (size_t i = 0; i < count; ++i) {
+                pool.submit([completion] { completion->done(); });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    finished.wait();
+    double seconds = watch.seconds();
+    pool.stop();
+    return tasks / seconds;
+}
+
+double runSpawn(size_t workers, bool workStealing, size_t parents, size_t children) {
+    ThreadPool pool(workers, workStealing);
+    auto completion = std::make_shared<Completion>(parents * (children + 1));
+    std::future<void> finished = completion->promise.get_future();
+
+    Stopwatch watch;
+    for (size_t p = 0; p < parents; ++p) {
+        pool.submit([&pool, completion, children] {
+            for (size_t i = 0; i < children; ++i) {
+                pool.submit([completion] { completion->done(); });
+            }
+            completion->done();
+        });
+    }
+    finished.wait();
+    double seconds = watch.seconds();
+    pool.stop();
+    return completion->total / seconds;
+}
+
+std::vector<size_t> listArgs(int argc, char* argv[], int from, std::vector<size_t> fallback) {
+    std::vector<size_t> values;
+    for (int i = from; i < argc; ++i) {
+        values.push_back(std::stoul(argv[i]));
+    }
+    return values.empty() ? fallback : values;
+}
+
+}  // namespace
+
+}  // namespace im
+
+int main(int argc, char* argv[]) {
+    using namespace im;
+    Logger::setLevel(Logger::Level::WARN);
+
+    if (argc >= 2 && std::strcmp(argv[1], "spawn") == 0) {
+        size_t workers = argOr(argc, argv, 2, 4);
+        size_t parents = argOr(argc, argv, 3, 200);
+        std::printf("spawn: %zu 个工作线程, %zu 个父任务, CPU 核数 %u\n", workers, parents,
+                    std::thread::hardware_concurrency());
+        std::printf("%10s %16s %16s\n", "children", "global tasks/s", "stealing tasks/s");
+        for (size_t children : listArgs(argc, argv, 4, {1000, 10000})) {
+            double global = runSpawn(workers, false, parents, children);
+            double stealing = runSpawn(workers, true, parents, children);
+            std::printf("%10zu %16.0f %16.0f\n", children, global, stealing);
+        }
+        return 0;
+    }
+    if (argc < 2 || std::strcmp(argv[1], "submit") != 0) {
+        std::fprintf(stderr, "用法: %s submit|spawn [工作线程] ...\n", argv[0]);
+        return 1;
+    }
+
+    size_t workers = argOr(argc, argv, 2, 4);
+    size_t tasks = argOr(argc, argv, 3, 2000000);
+    std::printf("submit: %zu 个工作线程, %zu 个任务, CPU 核数 %u\n", workers, tasks,
+                std::thread::hardware_concurrency());
+    std::printf("%10s %16s %16s\n", "producers", "locked tasks/s", "ring tasks/s");
+    for (size_t producers : listArgs(argc, argv, 4, {1, 2, 4, 8, 16, 32, 64})) {
+        producers = std::max<size_t>(1, producers);
+        double locked = runSubmit<LockedThreadPool>(workers, tasks, producers);
+        double ring = runSubmit<ThreadPool>(workers, tasks, producers);
+        std::printf("%10zu %16.0f %16.0f\n", producers, locked, ring);
+    }
+    return 0;
+}
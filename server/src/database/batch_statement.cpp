@@ -0,0 +1,98 @@
+#include "batch_statement.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace im {
+
+Transaction::~Transaction() {
+    if (active_) {
+        rollback();
+    }
+}
+
+bool Transaction::begin() {
+    static constexpr char SQL[] = "START TRANSACTION";
+    if (mysql_real_query(conn_.get(), SQL, sizeof(SQL) - 1) != 0) {
+        LOG_ERROR("开始事务失败: ", mysql_error(conn_.get()));
+        conn_.markBroken();
+        return false;
+    }
+    active_ = true;
+    return true;
+}
+
+bool Transaction::commit() {
+    active_ = false;
+    if (mysql_commit(conn_.get()) != 0) {
+        LOG_ERROR("提交事务失败: ", mysql_error(conn_.get()));
+        conn_.markBroken();
+        return false;
+    }
+    return true;
+}
+
+void Transaction::rollback() {
+    active_ = false;
+    if (mysql_rollback(conn_.get()) != 0) {
+        LOG_ERROR("回滚事务失败: ", mysql_error(conn_.get()));
+        conn_.markBroken();
+    }
+}
+
+BatchStatement::BatchStatement(std::string_view prefix, std::string_view row, std::string_view suffix)
+    : columns_(std::count(row.begin(), row.end(), '?')) {
+    for (size_t tier = 0; tier < CHUNK_SIZES.size(); ++tier) {
+        std::string& sql = sql_[tier];
+        sql.reserve(prefix.size() + CHUNK_SIZES[tier] * (row.size() + 2) + suffix.size());
+        sql.append(prefix);
+        for (size_t i = 0; i < CHUNK_SIZES[tier]; ++i) {
+            if (i > 0) {
+                sql.append(", ");
+            }
+            sql.append(row);
+        }
+        sql.append(suffix);
+    }
+}
+
+bool BatchStatement::execute(PooledConnection& conn, const std::vector<std::string_view>& params,
+                             const std::function<void(PreparedStatement&)>& onChunk) const {
+    if (columns_ == 0 || params.size() % columns_ != 0) {
+        LOG_ERROR("批量语句参数个数不是每行参数数的整数倍: ", params.size(), ", sql=", sql_[0]);
+        return false;
+    }
+
+    std::vector<std::string_view> chunk;
+    size_t rows = params.size() / columns_;
+    size_t done = 0;
+    while (done < rows) {
+        // 剩余行数不少于最大档位时取最大档位，否则取能容纳剩余行数的最小档位
+        size_t remaining = rows - done;
+        size_t tier = 0;
+        while (tier + 1 < CHUNK_SIZES.size() && CHUNK_SIZES[tier] < remaining) {
+            ++tier;
+        }
+        size_t taken = std::min(remaining, CHUNK_SIZES[tier]);
+
+        chunk.assign(params.begin() + done * columns_, params.begin() + (done + taken) * columns_);
+        size_t lastRow = (taken - 1) * columns_;
+        for (size_t pad = taken; pad < CHUNK_SIZES[tier]; ++pad) {
+            for (size_t column = 0; column < columns_; ++column) {
+                std::string_view value = chunk[lastRow + column];
+                chunk.push_back(value);
+            }
+        }
+
+        PreparedStatement* stmt = conn.prepare(sql_[tier]);
+        if (!stmt || !stmt->executeParams(chunk)) {
+            return false;
+        }
+        if (onChunk) {
+            onChunk(*stmt);
+        }
+        done += taken;
+    }
+    return true;
+}
+
+}  // namespace im
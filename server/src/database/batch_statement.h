@@ -0,0 +1,78 @@
+#ifndef BATCH_STATEMENT_H
+#define BATCH_STATEMENT_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "database/connection_pool.h"
+#include "database/prepared_statement.h"
+
+namespace im {
+
+/**
+ * 事务（RAII）：begin 成功后未 commit 即析构时回滚
+ *
+ * 开始、提交或回滚失败时连接状态不可信，标记为失效，归还后由连接池重连。
+ */
+class Transaction {
+public:
+    explicit Transaction(PooledConnection& conn) : conn_(conn) {}
+    ~Transaction();
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    bool begin();
+    bool commit();
+    void rollback();
+
+private:
+    PooledConnection& conn_;
+    bool active_ = false;
+};
+
+/**
+ * 分块批量语句：前缀 + N 个行模板 + 后缀拼成一条预处理语句，一次往返处理 N 行
+ *
+ *     INSERT IGNORE INTO t (a, b) VALUES (?, ?), (?, ?), ...
+ *     SELECT id FROM t WHERE id IN (?, ?, ...)
+ *
+ * N 只取 CHUNK_SIZES 中的档位，最后一块不足时重复末行补齐（对 IN 和 INSERT IGNORE 不改变结果），
+ * 这样同一模板在每个连接的语句缓存中最多只占 CHUNK_SIZES.size() 条语句。
+ */
+class BatchStatement {
+public:
+    static constexpr std::array<size_t, 5> CHUNK_SIZES = {1, 4, 16, 64, 256};
+
+    /**
+     * @param prefix 语句开头，如 "SELECT user_id FROM users WHERE user_id IN ("
+     * @param row 行模板，如 "?" 或 "(?, ?, 'member')"，行之间以逗号分隔
+     * @param suffix 语句结尾，如 ")"
+     */
+    BatchStatement(std::string_view prefix, std::string_view row, std::string_view suffix = {});
+
+    /**
+     * 每行的参数个数（行模板中的占位符数）
+     */
+    size_t columns() const { return columns_; }
+
+    /**
+     * 分块执行
+     *
+     * @param params 按行展开的参数，个数须为 columns() 的整数倍；为空时不执行任何语句
+     * @param onChunk 每块执行成功后调用（可在其中 fetch 查询结果或累加影响行数）
+     * @return 所有块是否都执行成功
+     */
+    bool execute(PooledConnection& conn, const std::vector<std::string_view>& params,
+                 const std::function<void(PreparedStatement&)>& onChunk = nullptr) const;
+
+private:
+    size_t columns_ = 0;
+    std::array<std::string, CHUNK_SIZES.size()> sql_;
+};
+
+}  // namespace im
+
+#endif  // BATCH_STATEMENT_H
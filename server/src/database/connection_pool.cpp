@@ -0,0 +1,308 @@
+#include "connection_pool.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <mysql/errmsg.h>
+
+namespace im {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * 使用 MySQL 客户端库的线程需要各自初始化线程局部状态，线程退出时释放
+ */
+struct MysqlThreadGuard {
+    MysqlThreadGuard() { mysql_thread_init(); }
+    ~MysqlThreadGuard() { mysql_thread_end(); }
+};
+
+/**
+ * 线程亲和：记录当前线程上次使用的连接槽位
+ */
+struct ThreadAffinity {
+    const ConnectionPool* pool = nullptr;
+    size_t slot = 0;
+};
+
+thread_local ThreadAffinity t_affinity;
+
+bool isConnectionLost(MYSQL* mysql) {
+    unsigned int err = mysql_errno(mysql);
+    return err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST;
+}
+
+}  // namespace
+
+PooledConnection::PooledConnection(PooledConnection&& other) noexcept
+    : pool_(other.pool_), slot_(other.slot_), mysql_(other.mysql_),
+      statements_(other.statements_), broken_(other.broken_) {
+    other.pool_ = nullptr;
+    other.mysql_ = nullptr;
+}
+
+PooledConnection& PooledConnection::operator=(PooledConnection&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        slot_ = other.slot_;
+        mysql_ = other.mysql_;
+        statements_ = other.statements_;
+        broken_ = other.broken_;
+        other.pool_ = nullptr;
+        other.mysql_ = nullptr;
+    }
+    return *this;
+}
+
+void PooledConnection::release() {
+    if (pool_ && mysql_) {
+        pool_->release(slot_, broken_ || isConnectionLost(mysql_) || statements_->connectionLost());
+    }
+    pool_ = nullptr;
+    mysql_ = nullptr;
+    statements_ = nullptr;
+    broken_ = false;
+}
+
+ConnectionPool::~ConnectionPool() {
+    close();
+}
+
+bool ConnectionPool::init(const ConnectionPoolOptions& options) {
+    mysql_library_init(0, nullptr, nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+        options_.maxSize = std::max<size_t>(options_.maxSize, 1);
+        slots_.clear();
+        slots_.resize(options_.maxSize);
+        idleSlots_.clear();
+        for (size_t i = options_.maxSize; i > 0; --i) {
+            idleSlots_.push_back(i - 1);
+        }
+        inUse_ = 0;
+        stats_ = ConnectionPoolStats();
+        open_ = true;
+    }
+
+    // 先建立一个连接，配置错误时尽早失败
+    MYSQL* mysql = connect();
+    if (!mysql) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[0].mysql = mysql;
+    slots_[0].statements = std::make_unique<StatementCache>(mysql);
+    slots_[0].lastUsed = Clock::now();
+    stats_.size = 1;
+    // 已建立连接的槽位放在栈顶，优先借出
+    idleSlots_.erase(std::find(idleSlots_.begin(), idleSlots_.end(), 0));
+    idleSlots_.push_back(0);
+
+    LOG_INFO("MySQL 数据库连接成功: ", options_.host, ":", options_.port, "/", options_.database,
+             "，连接池上限: ", options_.maxSize);
+    return true;
+}
+
+void ConnectionPool::close() {
+    std::vector<std::pair<MYSQL*, std::unique_ptr<StatementCache>>> toClose;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!open_) {
+            return;
+        }
+        open_ = false;
+        for (size_t slot : idleSlots_) {
+            std::unique_ptr<StatementCache> statements;
+            if (MYSQL* mysql = detach(slots_[slot], statements)) {
+                toClose.emplace_back(mysql, std::move(statements));
+            }
+        }
+    }
+    available_.notify_all();
+
+    for (auto& [mysql, statements] : toClose) {
+        // 语句依赖连接，必须先于 mysql_close 释放
+        statements.reset();
+        mysql_close(mysql);
+    }
+    LOG_INFO("MySQL 数据库连接已关闭");
+}
+
+bool ConnectionPool::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_;
+}
+
+PooledConnection ConnectionPool::acquire() {
+    thread_local MysqlThreadGuard threadGuard;
+
+    auto waitStart = Clock::now();
+    size_t slot = 0;
+    MYSQL* mysql = nullptr;
+    Clock::time_point lastUsed;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool waited = false;
+        while (open_ && idleSlots_.empty()) {
+            waited = true;
+            if (available_.wait_until(lock, waitStart + options_.acquireTimeout) == std::cv_status::timeout &&
+                idleSlots_.empty()) {
+                stats_.timeoutCount++;
+                LOG_WARN("获取数据库连接超时: 已借出=", inUse_, ", 上限=", options_.maxSize);
+                return PooledConnection();
+            }
+        }
+        if (!open_) {
+            return PooledConnection();
+        }
+
+        // 优先借回本线程上次使用的连接，否则取最近归还的
+        auto it = idleSlots_.end() - 1;
+        if (t_affinity.pool == this && slots_[t_affinity.slot].idle) {
+            it = std::find(idleSlots_.begin(), idleSlots_.end(), t_affinity.slot);
+        }
+        slot = *it;
+        idleSlots_.erase(it);
+
+        Slot& s = slots_[slot];
+        s.idle = false;
+        mysql = s.mysql;
+        lastUsed = s.lastUsed;
+        inUse_++;
+        stats_.acquireCount++;
+        if (waited) {
+            auto waitMicros = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - waitStart).count());
+            stats_.waitCount++;
+            stats_.totalWaitMicros += waitMicros;
+            stats_.maxWaitMicros = std::max(stats_.maxWaitMicros, waitMicros);
+        }
+    }
+
+    mysql = prepare(slot, mysql, lastUsed);
+    if (!mysql) {
+        release(slot, true);
+        return PooledConnection();
+    }
+    t_affinity.pool = this;
+    t_affinity.slot = slot;
+    // 槽位已借出，语句缓存只由持有者访问
+    return PooledConnection(this, slot, mysql, slots_[slot].statements.get());
+}
+
+MYSQL* ConnectionPool::prepare(size_t slot, MYSQL* mysql, Clock::time_point lastUsed) {
+    bool reconnect = false;
+    if (mysql && Clock::now() - lastUsed >= options_.pingIdleThreshold && mysql_ping(mysql) != 0) {
+        LOG_WARN("数据库连接空闲后失效，重新连接: slot=", slot, ", error=", mysql_error(mysql));
+        std::unique_ptr<StatementCache> statements;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            detach(slots_[slot], statements);
+        }
+        statements.reset();
+        mysql_close(mysql);
+        mysql = nullptr;
+        reconnect = true;
+    }
+
+    if (!mysql) {
+        mysql = connect();
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& s = slots_[slot];
+        s.mysql = mysql;
+        if (mysql) {
+            s.statements = std::make_unique<StatementCache>(mysql);
+            stats_.size++;
+            if (reconnect) {
+                stats_.reconnectCount++;
+            }
+        }
+    }
+    return mysql;
+}
+
+void ConnectionPool::release(size_t slot, bool broken) {
+    MYSQL* toClose = nullptr;
+    std::unique_ptr<StatementCache> statements;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& s = slots_[slot];
+        if (broken || !open_) {
+            // 失效连接直接关闭，下次借出该槽位时重连
+            toClose = detach(s, statements);
+        }
+        s.idle = true;
+        s.lastUsed = Clock::now();
+        // 没有连接的槽位放到栈底，优先借出仍然可用的连接
+        if (s.mysql) {
+            idleSlots_.push_back(slot);
+        } else {
+            idleSlots_.insert(idleSlots_.begin(), slot);
+        }
+        inUse_--;
+    }
+    available_.notify_one();
+
+    if (toClose) {
+        if (broken) {
+            LOG_WARN("数据库连接已断开，关闭并等待重连: slot=", slot);
+        }
+        statements.reset();
+        mysql_close(toClose);
+    }
+}
+
+MYSQL* ConnectionPool::detach(Slot& slot, std::unique_ptr<StatementCache>& statements) {
+    MYSQL* mysql = slot.mysql;
+    if (mysql) {
+        statements = std::move(slot.statements);
+        slot.mysql = nullptr;
+        stats_.size--;
+    }
+    return mysql;
+}
+
+MYSQL* ConnectionPool::connect() {
+    MYSQL* mysql = mysql_init(nullptr);
+    if (!mysql) {
+        LOG_ERROR("初始化 MySQL 失败");
+        return nullptr;
+    }
+
+    // 设置字符集
+    mysql_options(mysql, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+
+    // 连接数据库（使用 TCP 连接，不使用 socket）
+    // 如果 host 是 "localhost"，MySQL 默认使用 socket，需要明确指定为 "127.0.0.1"
+    std::string connectHost = (options_.host == "localhost") ? "127.0.0.1" : options_.host;
+
+    MYSQL* result = mysql_real_connect(mysql,
+                                       connectHost.c_str(),
+                                       options_.user.c_str(),
+                                       options_.password.c_str(),
+                                       options_.database.c_str(),
+                                       options_.port,
+                                       nullptr,
+                                       CLIENT_FOUND_ROWS);
+    if (!result) {
+        LOG_ERROR("连接 MySQL 失败: ", mysql_error(mysql));
+        mysql_close(mysql);
+        return nullptr;
+    }
+    return mysql;
+}
+
+ConnectionPoolStats ConnectionPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ConnectionPoolStats stats = stats_;
+    stats.inUse = inUse_;
+    return stats;
+}
+
+}  // namespace im
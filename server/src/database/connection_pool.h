@@ -0,0 +1,175 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mysql/mysql.h>
+#include "database/prepared_statement.h"
+
+namespace im {
+
+class ConnectionPool;
+
+/**
+ * 连接池配置
+ */
+struct ConnectionPoolOptions {
+    std::string host;
+    std::string user;
+    std::string password;
+    std::string database;
+    unsigned int port = 3306;
+    size_t maxSize = 8;                                        // 连接数上限
+    std::chrono::milliseconds acquireTimeout{3000};            // 等待空闲连接的超时时间
+    std::chrono::seconds pingIdleThreshold{30};                // 空闲超过该时长的连接借出前先 ping
+};
+
+/**
+ * 连接池统计
+ */
+struct ConnectionPoolStats {
+    size_t size = 0;              // 已建立的连接数
+    size_t inUse = 0;             // 已借出的连接数
+    uint64_t acquireCount = 0;    // 累计借出次数
+    uint64_t timeoutCount = 0;    // 累计等待超时次数
+    uint64_t waitCount = 0;       // 需要等待才借到连接的次数
+    uint64_t totalWaitMicros = 0; // 累计等待时间
+    uint64_t maxWaitMicros = 0;   // 最长一次等待时间
+    uint64_t reconnectCount = 0;  // 累计重连次数
+};
+
+/**
+ * 借出连接的 RAII 句柄，析构时归还连接池
+ *
+ * 归还时若最后一次调用的错误为 CR_SERVER_GONE_ERROR / CR_SERVER_LOST，
+ * 连接被标记为失效，下次借出时再重连。
+ */
+class PooledConnection {
+public:
+    PooledConnection() = default;
+    ~PooledConnection() { release(); }
+
+    PooledConnection(PooledConnection&& other) noexcept;
+    PooledConnection& operator=(PooledConnection&& other) noexcept;
+    PooledConnection(const PooledConnection&) = delete;
+    PooledConnection& operator=(const PooledConnection&) = delete;
+
+    MYSQL* get() const { return mysql_; }
+    explicit operator bool() const { return mysql_ != nullptr; }
+
+    /**
+     * 获取该连接上缓存的预处理语句（首次使用时预处理）
+     *
+     * @return 语句；预处理失败时返回 nullptr（已记录日志）
+     */
+    PreparedStatement* prepare(std::string_view sql) { return statements_->get(sql); }
+
+    /**
+     * 主动标记连接失效（例如事务中途出错，连接状态不可信）
+     */
+    void markBroken() { broken_ = true; }
+
+    /**
+     * 提前归还连接
+     */
+    void release();
+
+private:
+    friend class ConnectionPool;
+    PooledConnection(ConnectionPool* pool, size_t slot, MYSQL* mysql, StatementCache* statements)
+        : pool_(pool), slot_(slot), mysql_(mysql), statements_(statements) {}
+
+    ConnectionPool* pool_ = nullptr;
+    size_t slot_ = 0;
+    MYSQL* mysql_ = nullptr;
+    StatementCache* statements_ = nullptr;
+    bool broken_ = false;
+};
+
+/**
+ * 有界 MySQL 连接池
+ *
+ * - 连接按需建立，数量不超过 maxSize；没有空闲连接时等待，超时返回空句柄
+ * - 线程优先借回自己上次使用的连接（线程亲和），减少连接在线程间来回迁移
+ * - 只对空闲超过阈值的连接做 ping，失效连接在下次借出时惰性重连
+ */
+class ConnectionPool {
+public:
+    ConnectionPool() = default;
+    ~ConnectionPool();
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    /**
+     * 初始化连接池并建立第一个连接以校验配置
+     *
+     * @return 第一个连接是否建立成功
+     */
+    bool init(const ConnectionPoolOptions& options);
+
+    /**
+     * 关闭所有空闲连接，之后 acquire 返回空句柄
+     */
+    void close();
+
+    /**
+     * 借出一个可用连接
+     *
+     * @return 连接句柄；等待超时或无法建立连接时为空
+     */
+    PooledConnection acquire();
+
+    bool isOpen() const;
+
+    ConnectionPoolStats getStats() const;
+
+private:
+    friend class PooledConnection;
+
+    struct Slot {
+        MYSQL* mysql = nullptr;
+        std::unique_ptr<StatementCache> statements;  // 随连接创建，关闭连接前先销毁
+        bool idle = true;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    void release(size_t slot, bool broken);
+
+    /**
+     * 建立新连接，失败返回 nullptr（在锁外调用）
+     */
+    MYSQL* connect();
+
+    /**
+     * 确保借出的连接可用：必要时 ping 或重连（在锁外调用）
+     */
+    MYSQL* prepare(size_t slot, MYSQL* mysql, std::chrono::steady_clock::time_point lastUsed);
+
+    /**
+     * 从槽位上摘下连接及其语句缓存（调用方持有锁）
+     *
+     * 调用方在锁外先释放 statements，再 mysql_close 返回的连接
+     */
+    MYSQL* detach(Slot& slot, std::unique_ptr<StatementCache>& statements);
+
+    ConnectionPoolOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<Slot> slots_;       // 下标即槽位号，大小固定为 maxSize
+    std::vector<size_t> idleSlots_; // 空闲槽位（含尚未建立连接的槽位），后进先出
+    size_t inUse_ = 0;
+    bool open_ = false;
+
+    ConnectionPoolStats stats_;
+};
+
+}  // namespace im
+
+#endif  // CONNECTION_POOL_H
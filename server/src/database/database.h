@@ -4,6 +4,7 @@
 #include <string>
 #include <memory>
 #include <mysql/mysql.h>
+#include "database/connection_pool.h"
 
 namespace im {
 
@@ -15,23 +16,25 @@ public:
     static Database& getInstance();
     
     /**
-     * 初始化数据库连接
+     * 初始化数据库连接池
      * 
      * @param host MySQL 主机地址
      * @param user MySQL 用户名
      * @param password MySQL 密码
      * @param database 数据库名
      * @param port MySQL 端口（默认3306）
+     * @param poolSize 连接池连接数上限（默认8）
      * @return 是否成功
      */
     bool init(const std::string& host, 
               const std::string& user, 
               const std::string& password,
               const std::string& database,
-              unsigned int port = 3306);
+              unsigned int port = 3306,
+              size_t poolSize = 8);
     
     /**
-     * 关闭数据库连接
+     * 关闭数据库连接池
      */
     void close();
     
@@ -43,6 +46,14 @@ public:
      */
     bool userExists(const std::string& username);
     
+    /**
+     * 检查用户ID是否存在
+     * 
+     * @param userId 用户ID
+     * @return 是否存在
+     */
+    bool userIdExists(const std::string& userId);
+        
     /**
      * 验证用户登录
      * 
@@ -72,23 +83,23 @@ public:
                      std::string& userId);
     
     /**
-     * 检查数据库是否已连接
+     * 检查数据库连接池是否已初始化
      * 
      * @return 是否已连接
      */
-    bool isConnected() const { return mysql_ != nullptr && connected_; }
+    bool isConnected() const { return pool_.isOpen(); }
     
     /**
-     * 确保数据库连接有效（如果断开则自动重连）
+     * 从连接池借出一个连接，句柄析构时自动归还
      * 
-     * @return 连接是否有效
+     * @return 连接句柄；等待超时或无法连接时为空，调用方应返回数据库错误
      */
-    bool ensureConnected();
+    PooledConnection acquire() { return pool_.acquire(); }
     
     /**
-     * 执行 SQL 查询（内部使用）
+     * 获取连接池统计
      */
-    MYSQL* getConnection();
+    ConnectionPoolStats getPoolStats() const { return pool_.getStats(); }
 
 private:
     Database() = default;
@@ -96,20 +107,12 @@ private:
     Database(const Database&) = delete;
     Database& operator=(const Database&) = delete;
     
-    MYSQL* mysql_;
-    bool connected_;
-    
-    // 保存连接参数以便重连
-    std::string host_;
-    std::string user_;
-    std::string password_;
-    std::string database_;
-    unsigned int port_;
+    ConnectionPool pool_;
     
     /**
-     * 转义 SQL 字符串，防止 SQL 注入
+     * 检查用户名是否存在（使用调用方已借出的连接）
      */
-    std::string escapeString(const std::string& str);
+    bool userExists(PooledConnection& conn, const std::string& username);
 };
 
 }  // namespace im
@@ -0,0 +1,96 @@
+#include "db_executor.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace im {
+
+DbExecutor& DbExecutor::getInstance() {
+    static DbExecutor instance;
+    return instance;
+}
+
+DbExecutor::~DbExecutor() {
+    stop();
+}
+
+void DbExecutor::start(size_t threads, size_t queueCapacity) {
+    if (running_.exchange(true)) {
+        return;
+    }
+    capacity_ = std::max<size_t>(1, queueCapacity);
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this] { worker(); });
+    }
+    LOG_INFO("[数据库执行器] 已启动: 线程数=", threads, ", 队列上限=", capacity_);
+}
+
+void DbExecutor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    LOG_INFO("[数据库执行器] 已停止");
+}
+
+bool DbExecutor::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || queue_.size() >= capacity_) {
+            ++rejected_;
+            return false;
+        }
+        queue_.push_back({std::move(task), std::chrono::steady_clock::now()});
+    }
+    condition_.notify_one();
+    return true;
+}
+
+DbExecutorStats DbExecutor::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DbExecutorStats stats;
+    stats.threads = threads_.size();
+    stats.capacity = capacity_;
+    stats.queued = queue_.size();
+    stats.running = active_;
+    stats.executed = executed_;
+    stats.rejected = rejected_;
+    stats.totalWaitMicros = totalWaitMicros_;
+    stats.maxWaitMicros = maxWaitMicros_;
+    return stats;
+}
+
+void DbExecutor::worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        condition_.wait(lock, [this] { return !queue_.empty() || !running_; });
+        if (queue_.empty()) {
+            return;  // 已停止且队列已取完
+        }
+        Entry entry = std::move(queue_.front());
+        queue_.pop_front();
+        uint64_t waitMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - entry.enqueued).count();
+        totalWaitMicros_ += waitMicros;
+        maxWaitMicros_ = std::max(maxWaitMicros_, waitMicros);
+        ++active_;
+
+        lock.unlock();
+        entry.task();
+        entry.task.reset();
+        lock.lock();
+
+        --active_;
+        ++executed_;
+    }
+}
+
+}  // namespace im
@@ -0,0 +1,94 @@
+#ifndef DB_EXECUTOR_H
+#define DB_EXECUTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "thread_pool/task.h"
+
+namespace im {
+
+/**
+ * 数据库执行器统计
+ */
+struct DbExecutorStats {
+    size_t threads = 0;
+    size_t capacity = 0;          // 队列上限
+    size_t queued = 0;            // 排队中的任务数
+    size_t running = 0;           // 正在执行的任务数
+    uint64_t executed = 0;        // 累计执行次数
+    uint64_t rejected = 0;        // 队列满被拒绝的次数
+    uint64_t totalWaitMicros = 0; // 累计排队时间
+    uint64_t maxWaitMicros = 0;   // 最长排队时间
+};
+
+/**
+ * 数据库执行器：访问 MySQL 的任务在独立的线程上执行
+ *
+ * - 与解包、应答心跳的业务线程池隔离，数据库卡顿时只阻塞这里的线程
+ * - 线程数即并发上限，通常不超过连接池大小
+ * - 队列有界，满时 submit 立即返回 false，由调用方回“服务器繁忙”而不是让请求堆积
+ * - 任务以毫秒计，队列用互斥锁保护即可
+ */
+class DbExecutor {
+public:
+    static DbExecutor& getInstance();
+
+    /**
+     * 启动执行线程
+     *
+     * @param threads 执行线程数（并发上限）
+     * @param queueCapacity 排队任务数上限
+     */
+    void start(size_t threads, size_t queueCapacity);
+
+    /**
+     * 停止：已入队的任务执行完后线程退出，之后 submit 返回 false
+     */
+    void stop();
+
+    bool isRunning() const { return running_; }
+
+    /**
+     * 提交任务，队列已满或执行器未运行时返回 false
+     */
+    bool submit(Task task);
+
+    DbExecutorStats getStats();
+
+private:
+    DbExecutor() = default;
+    ~DbExecutor();
+    DbExecutor(const DbExecutor&) = delete;
+    DbExecutor& operator=(const DbExecutor&) = delete;
+
+    struct Entry {
+        Task task;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    void worker();
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Entry> queue_;
+    size_t capacity_ = 0;
+    size_t active_ = 0;  // 正在执行的任务数
+    std::atomic<bool> running_{false};
+
+    uint64_t executed_ = 0;
+    uint64_t rejected_ = 0;
+    uint64_t totalWaitMicros_ = 0;
+    uint64_t maxWaitMicros_ = 0;
+};
+
+}  // namespace im
+
+#endif  // DB_EXECUTOR_H
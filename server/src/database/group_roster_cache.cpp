@@ -0,0 +1,258 @@
+#include "group_roster_cache.h"
+#include "database/database.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <numeric>
+
+namespace im {
+
+namespace {
+
+/**
+ * 按 userId 排序，角色随之重排；已有序时不做处理
+ */
+void sortByUserId(GroupRoster& roster) {
+    if (std::is_sorted(roster.userIds.begin(), roster.userIds.end())) {
+        return;
+    }
+    std::vector<size_t> order(roster.userIds.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return roster.userIds[a] < roster.userIds[b]; });
+    GroupRoster sorted;
+    sorted.userIds.reserve(order.size());
+    sorted.roles.reserve(order.size());
+    for (size_t i : order) {
+        sorted.userIds.push_back(std::move(roster.userIds[i]));
+        sorted.roles.push_back(roster.roles[i]);
+    }
+    roster = std::move(sorted);
+}
+
+}  // namespace
+
+bool GroupRoster::contains(const std::string& userId) const {
+    return std::binary_search(userIds.begin(), userIds.end(), userId);
+}
+
+std::string_view GroupRoster::roleOf(const std::string& userId) const {
+    auto it = std::lower_bound(userIds.begin(), userIds.end(), userId);
+    if (it == userIds.end() || *it != userId) {
+        return {};
+    }
+    return roleName(roles[it - userIds.begin()]);
+}
+
+GroupRoster::Role GroupRoster::parseRole(std::string_view role) {
+    if (role == "owner") {
+        return OWNER;
+    }
+    if (role == "admin") {
+        return ADMIN;
+    }
+    return MEMBER;
+}
+
+std::string_view GroupRoster::roleName(uint8_t role) {
+    switch (role) {
+        case OWNER: return "owner";
+        case ADMIN: return "admin";
+        default:    return "member";
+    }
+}
+
+GroupRosterCache& GroupRosterCache::getInstance() {
+    static GroupRosterCache instance;
+    return instance;
+}
+
+void GroupRosterCache::setMemoryLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memoryLimit_ = bytes;
+    evictLocked();
+}
+
+GroupRosterPtr GroupRosterCache::find(const std::string& groupId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(groupId);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    hits_++;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->roster;
+}
+
+GroupRosterPtr GroupRosterCache::get(const std::string& groupId, PooledConnection* conn) {
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(groupId);
+        if (it != index_.end()) {
+            hits_++;
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->roster;
+        }
+        misses_++;
+        generation = generation_;
+    }
+
+    // 在锁外查库
+    GroupRosterPtr roster;
+    if (conn) {
+        roster = load(*conn, groupId);
+    } else {
+        PooledConnection ownConn = Database::getInstance().acquire();
+        if (ownConn) {
+            roster = load(ownConn, groupId);
+        }
+    }
+    if (!roster) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 加载期间有修改时，查到的名单可能已过期，只返回不缓存
+    if (generation_ == generation && index_.find(groupId) == index_.end()) {
+        storeLocked(groupId, roster);
+    }
+    return roster;
+}
+
+void GroupRosterCache::put(const std::string& groupId, GroupRoster roster) {
+    sortByUserId(roster);
+    auto sorted = std::make_shared<const GroupRoster>(std::move(roster));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_++;
+    storeLocked(groupId, std::move(sorted));
+}
+
+void GroupRosterCache::addMembers(const std::string& groupId, const std::vector<std::string>& userIds,
+                                  GroupRoster::Role role) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_++;
+    auto it = index_.find(groupId);
+    if (it == index_.end() || userIds.empty()) {
+        return;
+    }
+    const GroupRoster& current = *it->second->roster;
+    auto updated = std::make_shared<GroupRoster>(current);
+    for (const auto& userId : userIds) {
+        auto pos = std::lower_bound(current.userIds.begin(), current.userIds.end(), userId);
+        if (pos != current.userIds.end() && *pos == userId) {
+            updated->roles[pos - current.userIds.begin()] = role;
+        } else {
+            updated->userIds.push_back(userId);
+            updated->roles.push_back(role);
+        }
+    }
+    sortByUserId(*updated);
+    storeLocked(groupId, std::move(updated));
+}
+
+void GroupRosterCache::removeMember(const std::string& groupId, const std::string& userId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_++;
+    auto it = index_.find(groupId);
+    if (it == index_.end()) {
+        return;
+    }
+    const GroupRoster& current = *it->second->roster;
+    auto pos = std::lower_bound(current.userIds.begin(), current.userIds.end(), userId);
+    if (pos == current.userIds.end() || *pos != userId) {
+        return;
+    }
+    size_t offset = pos - current.userIds.begin();
+    auto updated = std::make_shared<GroupRoster>(current);
+    updated->userIds.erase(updated->userIds.begin() + offset);
+    updated->roles.erase(updated->roles.begin() + offset);
+    storeLocked(groupId, std::move(updated));
+}
+
+void GroupRosterCache::erase(const std::string& groupId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_++;
+    auto it = index_.find(groupId);
+    if (it == index_.end()) {
+        return;
+    }
+    memoryBytes_ -= it->second->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+}
+
+GroupRosterCacheStats GroupRosterCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GroupRosterCacheStats stats;
+    stats.groups = index_.size();
+    stats.memoryBytes = memoryBytes_;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.evictions = evictions_;
+    return stats;
+}
+
+GroupRosterPtr GroupRosterCache::load(PooledConnection& conn, const std::string& groupId) {
+    PreparedStatement* stmt = conn.prepare(
+        "SELECT user_id, role FROM group_members WHERE group_id = ? ORDER BY user_id");
+    if (!stmt || !stmt->execute(groupId)) {
+        LOG_ERROR("[群成员缓存] 加载群成员失败: group_id=", groupId);
+        return nullptr;
+    }
+    auto roster = std::make_shared<GroupRoster>();
+    roster->userIds.reserve(stmt->rowCount());
+    roster->roles.reserve(stmt->rowCount());
+    while (stmt->fetch()) {
+        if (stmt->isNull(0)) {
+            continue;
+        }
+        roster->userIds.emplace_back(stmt->getString(0));
+        roster->roles.push_back(GroupRoster::parseRole(stmt->getString(1)));
+    }
+    // 数据库排序规则与字节序不一定一致，按 std::string 比较再确认一次
+    sortByUserId(*roster);
+    return roster;
+}
+
+size_t GroupRosterCache::estimateBytes(const std::string& groupId, const GroupRoster& roster) {
+    // 条目、链表节点与哈希节点的固定开销按 128 字节估算
+    size_t bytes = 128 + sizeof(GroupRoster) + groupId.capacity();
+    bytes += roster.userIds.capacity() * sizeof(std::string) + roster.roles.capacity();
+    for (const auto& userId : roster.userIds) {
+        // 超出短字符串优化容量的部分在堆上
+        if (userId.capacity() > 15) {
+            bytes += userId.capacity() + 1;
+        }
+    }
+    return bytes;
+}
+
+void GroupRosterCache::storeLocked(const std::string& groupId, GroupRosterPtr roster) {
+    size_t bytes = estimateBytes(groupId, *roster);
+    auto it = index_.find(groupId);
+    if (it != index_.end()) {
+        memoryBytes_ -= it->second->bytes;
+        it->second->roster = std::move(roster);
+        it->second->bytes = bytes;
+        lru_.splice(lru_.begin(), lru_, it->second);
+    } else {
+        lru_.push_front(Entry{groupId, std::move(roster), bytes});
+        index_.emplace(groupId, lru_.begin());
+    }
+    memoryBytes_ += bytes;
+    evictLocked();
+}
+
+void GroupRosterCache::evictLocked() {
+    // 至少保留最近使用的一个群，避免超大群反复加载
+    while (memoryBytes_ > memoryLimit_ && lru_.size() > 1) {
+        Entry& victim = lru_.back();
+        memoryBytes_ -= victim.bytes;
+        index_.erase(victim.groupId);
+        lru_.pop_back();
+        evictions_++;
+    }
+}
+
+}  // namespace im
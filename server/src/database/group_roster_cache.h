@@ -0,0 +1,143 @@
+#ifndef GROUP_ROSTER_CACHE_H
+#define GROUP_ROSTER_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace im {
+
+class PooledConnection;
+
+/**
+ * 群成员名单（不可变快照）
+ *
+ * 成员按 userId 排序存放，角色用单字节编码与之一一对应，查找为二分。
+ */
+struct GroupRoster {
+    enum Role : uint8_t {
+        MEMBER = 0,
+        ADMIN = 1,
+        OWNER = 2
+    };
+
+    std::vector<std::string> userIds;  // 有序
+    std::vector<uint8_t> roles;        // 与 userIds 下标对应
+
+    bool contains(const std::string& userId) const;
+
+    /**
+     * @return "owner" / "admin" / "member"，不是成员时返回空
+     */
+    std::string_view roleOf(const std::string& userId) const;
+
+    static Role parseRole(std::string_view role);
+    static std::string_view roleName(uint8_t role);
+};
+
+using GroupRosterPtr = std::shared_ptr<const GroupRoster>;
+
+/**
+ * 群成员缓存统计
+ */
+struct GroupRosterCacheStats {
+    size_t groups = 0;          // 缓存的群数
+    size_t memoryBytes = 0;     // 估算的占用内存
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;     // 因超过内存上限被淘汰的群数
+};
+
+/**
+ * 进程内群成员缓存：group_id -> 成员名单
+ *
+ * - 首次访问时从 group_members 加载（惰性），之后群消息扇出与权限检查不再查库
+ * - 写穿：GroupHandler 在数据库修改成功后调用 addMembers / removeMember / erase 原地更新；
+ *   未缓存的群不做处理，下次访问时再加载
+ * - 名单是写时复制的不可变快照，调用方拿到后无需加锁
+ * - 按估算内存上限做 LRU 淘汰
+ *
+ * 只对本进程内的修改保持一致，直接修改数据库的外部变更不会反映到缓存中。
+ */
+class GroupRosterCache {
+public:
+    static GroupRosterCache& getInstance();
+
+    /**
+     * 设置内存上限（字节），超过时淘汰最久未使用的群
+     */
+    void setMemoryLimit(size_t bytes);
+
+    /**
+     * 获取群成员名单，未缓存时从数据库加载
+     *
+     * @param conn 调用方已借出的连接；为空时未命中才从连接池借出
+     * @return 名单（群不存在时为空名单）；数据库不可用或查询失败时返回 nullptr
+     */
+    GroupRosterPtr get(const std::string& groupId, PooledConnection* conn = nullptr);
+
+    /**
+     * 只查缓存，不访问数据库；未缓存时返回 nullptr
+     */
+    GroupRosterPtr find(const std::string& groupId);
+
+    /**
+     * 新建群后写入完整名单
+     */
+    void put(const std::string& groupId, GroupRoster roster);
+
+    /**
+     * 批量加入成员（已是成员的只更新角色），整批只复制一次名单
+     */
+    void addMembers(const std::string& groupId, const std::vector<std::string>& userIds, GroupRoster::Role role);
+    void removeMember(const std::string& groupId, const std::string& userId);
+
+    /**
+     * 群解散后删除
+     */
+    void erase(const std::string& groupId);
+
+    GroupRosterCacheStats getStats() const;
+
+private:
+    GroupRosterCache() = default;
+    GroupRosterCache(const GroupRosterCache&) = delete;
+    GroupRosterCache& operator=(const GroupRosterCache&) = delete;
+
+    struct Entry {
+        std::string groupId;
+        GroupRosterPtr roster;
+        size_t bytes = 0;
+    };
+    using LruList = std::list<Entry>;
+
+    static GroupRosterPtr load(PooledConnection& conn, const std::string& groupId);
+    static size_t estimateBytes(const std::string& groupId, const GroupRoster& roster);
+
+    /**
+     * 替换或插入条目并移到 LRU 头部，必要时淘汰（调用方持有锁）
+     */
+    void storeLocked(const std::string& groupId, GroupRosterPtr roster);
+    void evictLocked();
+
+    mutable std::mutex mutex_;
+    LruList lru_;  // 头部为最近使用
+    std::unordered_map<std::string, LruList::iterator> index_;
+    size_t memoryBytes_ = 0;
+    size_t memoryLimit_ = 64 << 20;
+    uint64_t generation_ = 0;  // 每次修改递增，用于丢弃加载期间已过期的结果
+
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+}  // namespace im
+
+#endif  // GROUP_ROSTER_CACHE_H
@@ -0,0 +1,249 @@
+#include "prepared_statement.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <charconv>
+#include <mysql/errmsg.h>
+
+namespace im {
+
+namespace {
+
+// 结果列缓冲区的初始大小，超出时按实际长度扩容
+constexpr size_t INITIAL_COLUMN_BUFFER_SIZE = 64;
+
+}  // namespace
+
+PreparedStatement::PreparedStatement(StatementCache& owner, MYSQL* mysql, std::string sql)
+    : owner_(owner), sql_(std::move(sql)) {
+    stmt_ = mysql_stmt_init(mysql);
+    if (!stmt_) {
+        LOG_ERROR("初始化预处理语句失败: ", mysql_error(mysql));
+        return;
+    }
+    if (mysql_stmt_prepare(stmt_, sql_.data(), sql_.size()) != 0) {
+        LOG_ERROR("预处理 SQL 失败: ", mysql_stmt_error(stmt_), ", sql=", sql_);
+        checkConnectionLost();
+        mysql_stmt_close(stmt_);
+        stmt_ = nullptr;
+        return;
+    }
+
+    paramCount_ = mysql_stmt_param_count(stmt_);
+    params_.resize(paramCount_);
+    paramLengths_.resize(paramCount_);
+    paramIntegers_.resize(paramCount_);
+    paramNulls_.reset(new BindBool[paramCount_ ? paramCount_ : 1]());
+}
+
+PreparedStatement::~PreparedStatement() {
+    if (stmt_) {
+        if (hasResult_) {
+            mysql_stmt_free_result(stmt_);
+        }
+        mysql_stmt_close(stmt_);
+    }
+}
+
+void PreparedStatement::bindParam(size_t index, std::string_view value) {
+    MYSQL_BIND& bind = params_[index];
+    bind = MYSQL_BIND{};
+    paramLengths_[index] = static_cast<unsigned long>(value.size());
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = const_cast<char*>(value.data() ? value.data() : "");
+    bind.buffer_length = static_cast<unsigned long>(value.size());
+    bind.length = &paramLengths_[index];
+    bind.is_null = &paramNulls_[index];
+}
+
+void PreparedStatement::bindParam(size_t index, std::nullptr_t) {
+    MYSQL_BIND& bind = params_[index];
+    bind = MYSQL_BIND{};
+    bind.buffer_type = MYSQL_TYPE_NULL;
+}
+
+void PreparedStatement::bindParam(size_t index, const std::optional<std::string_view>& value) {
+    if (value) {
+        bindParam(index, *value);
+    } else {
+        bindParam(index, nullptr);
+    }
+}
+
+void PreparedStatement::bindInteger(size_t index, long long value, bool isUnsigned) {
+    MYSQL_BIND& bind = params_[index];
+    bind = MYSQL_BIND{};
+    paramIntegers_[index] = value;
+    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+    bind.buffer = &paramIntegers_[index];
+    bind.is_unsigned = isUnsigned;
+    bind.is_null = &paramNulls_[index];
+}
+
+bool PreparedStatement::executeParams(const std::vector<std::string_view>& params) {
+    if (params.size() != paramCount_) {
+        return reportParamCountMismatch(params.size());
+    }
+    for (size_t index = 0; index < params.size(); ++index) {
+        bindParam(index, params[index]);
+    }
+    return executeBound();
+}
+
+bool PreparedStatement::reportParamCountMismatch(size_t given) {
+    LOG_ERROR("SQL 参数个数不匹配: 需要 ", paramCount_, " 个，传入 ", given, " 个, sql=", sql_);
+    return false;
+}
+
+bool PreparedStatement::executeBound() {
+    if (hasResult_) {
+        mysql_stmt_free_result(stmt_);
+        hasResult_ = false;
+    }
+
+    if (paramCount_ > 0 && mysql_stmt_bind_param(stmt_, params_.data())) {
+        LOG_ERROR("绑定 SQL 参数失败: ", mysql_stmt_error(stmt_), ", sql=", sql_);
+        return false;
+    }
+    if (mysql_stmt_execute(stmt_) != 0) {
+        LOG_ERROR("执行 SQL 失败: ", mysql_stmt_error(stmt_), ", sql=", sql_);
+        checkConnectionLost();
+        return false;
+    }
+
+    if (mysql_stmt_field_count(stmt_) == 0) {
+        return true;
+    }
+    if (!bindResult()) {
+        return false;
+    }
+    // 结果整体缓存到客户端，遍历期间连接可以继续执行其他语句
+    if (mysql_stmt_store_result(stmt_) != 0) {
+        LOG_ERROR("获取 SQL 结果失败: ", mysql_stmt_error(stmt_), ", sql=", sql_);
+        checkConnectionLost();
+        return false;
+    }
+    hasResult_ = true;
+    return true;
+}
+
+bool PreparedStatement::bindResult() {
+    // 同一语句的结果列固定，缓冲区只在首次执行时分配，之后复用
+    if (columns_.empty()) {
+        size_t fieldCount = mysql_stmt_field_count(stmt_);
+        columns_.resize(fieldCount);
+        results_.resize(fieldCount);
+        for (size_t i = 0; i < fieldCount; ++i) {
+            ResultColumn& column = columns_[i];
+            column.buffer.resize(INITIAL_COLUMN_BUFFER_SIZE);
+            MYSQL_BIND& bind = results_[i];
+            bind = MYSQL_BIND{};
+            bind.buffer_type = MYSQL_TYPE_STRING;
+            bind.buffer = column.buffer.data();
+            bind.buffer_length = static_cast<unsigned long>(column.buffer.size());
+            bind.length = &column.length;
+            bind.is_null = &column.isNull;
+            bind.error = &column.truncated;
+        }
+    }
+    if (mysql_stmt_bind_result(stmt_, results_.data())) {
+        LOG_ERROR("绑定 SQL 结果失败: ", mysql_stmt_error(stmt_), ", sql=", sql_);
+        return false;
+    }
+    return true;
+}
+
+bool PreparedStatement::fetch() {
+    if (!hasResult_) {
+        return false;
+    }
+    int rc = mysql_stmt_fetch(stmt_);
+    if (rc == MYSQL_NO_DATA) {
+        return false;
+    }
+    if (rc == 1) {
+        LOG_ERROR("读取 SQL 结果失败: ", mysql_stmt_error(stmt_), ", sql=", sql_);
+        checkConnectionLost();
+        return false;
+    }
+    if (rc == MYSQL_DATA_TRUNCATED) {
+        // 被截断的列按实际长度扩容后单独重取，并重新绑定供后续行使用
+        bool rebind = false;
+        for (size_t i = 0; i < columns_.size(); ++i) {
+            ResultColumn& column = columns_[i];
+            if (!column.truncated || column.length <= column.buffer.size()) {
+                continue;
+            }
+            column.buffer.resize(column.length);
+            MYSQL_BIND& bind = results_[i];
+            bind.buffer = column.buffer.data();
+            bind.buffer_length = static_cast<unsigned long>(column.buffer.size());
+            if (mysql_stmt_fetch_column(stmt_, &bind, static_cast<unsigned int>(i), 0) != 0) {
+                LOG_ERROR("读取被截断的列失败: column=", i, ", sql=", sql_);
+                return false;
+            }
+            rebind = true;
+        }
+        if (rebind && mysql_stmt_bind_result(stmt_, results_.data())) {
+            LOG_ERROR("重新绑定 SQL 结果失败: ", mysql_stmt_error(stmt_), ", sql=", sql_);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view PreparedStatement::getString(size_t column) const {
+    const ResultColumn& col = columns_[column];
+    if (col.isNull) {
+        return std::string_view();
+    }
+    return std::string_view(col.buffer.data(), std::min<size_t>(col.length, col.buffer.size()));
+}
+
+int64_t PreparedStatement::getInt(size_t column, int64_t defaultValue) const {
+    std::string_view text = getString(column);
+    int64_t value = defaultValue;
+    if (text.empty() || std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc()) {
+        return defaultValue;
+    }
+    return value;
+}
+
+uint64_t PreparedStatement::rowCount() const {
+    return hasResult_ ? mysql_stmt_num_rows(stmt_) : 0;
+}
+
+uint64_t PreparedStatement::affectedRows() const {
+    return mysql_stmt_affected_rows(stmt_);
+}
+
+uint64_t PreparedStatement::insertId() const {
+    return mysql_stmt_insert_id(stmt_);
+}
+
+const char* PreparedStatement::error() const {
+    return mysql_stmt_error(stmt_);
+}
+
+void PreparedStatement::checkConnectionLost() {
+    unsigned int err = mysql_stmt_errno(stmt_);
+    if (err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST) {
+        owner_.markConnectionLost();
+    }
+}
+
+PreparedStatement* StatementCache::get(std::string_view sql) {
+    auto it = statements_.find(sql);
+    if (it != statements_.end()) {
+        return it->second.get();
+    }
+
+    auto stmt = std::make_unique<PreparedStatement>(*this, mysql_, std::string(sql));
+    if (!stmt->isPrepared()) {
+        return nullptr;
+    }
+    PreparedStatement* result = stmt.get();
+    statements_.emplace(result->sql(), std::move(stmt));
+    return result;
+}
+
+}  // namespace im
@@ -0,0 +1,173 @@
+#ifndef PREPARED_STATEMENT_H
+#define PREPARED_STATEMENT_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <mysql/mysql.h>
+
+namespace im {
+
+class StatementCache;
+
+// MYSQL_BIND::is_null 指向的布尔类型：MySQL 8 为 bool，旧版本与 MariaDB 为 my_bool
+using BindBool = std::remove_pointer_t<decltype(MYSQL_BIND::is_null)>;
+
+/**
+ * 预处理语句（mysql_stmt_*）封装
+ *
+ * 参数按位置绑定：字符串类按指针绑定（执行期间必须有效），整数按值拷贝，
+ * std::nullopt / nullptr 绑定为 NULL。
+ * 查询结果在客户端完整缓存（mysql_stmt_store_result），遍历期间可以在同一连接上执行其他语句；
+ * 每列绑定到语句自带的可复用缓冲区，列值被截断时扩容后重新取该列。
+ *
+ * 用法：
+ *     PreparedStatement* stmt = conn.prepare("SELECT nickname FROM users WHERE user_id = ?");
+ *     if (stmt && stmt->execute(userId)) {
+ *         while (stmt->fetch()) {
+ *             std::string_view nickname = stmt->getString(0);
+ *         }
+ *     }
+ */
+class PreparedStatement {
+public:
+    PreparedStatement(StatementCache& owner, MYSQL* mysql, std::string sql);
+    ~PreparedStatement();
+    PreparedStatement(const PreparedStatement&) = delete;
+    PreparedStatement& operator=(const PreparedStatement&) = delete;
+
+    /**
+     * 服务端是否已成功预处理
+     */
+    bool isPrepared() const { return stmt_ != nullptr; }
+
+    const std::string& sql() const { return sql_; }
+
+    /**
+     * 绑定参数并执行；参数个数必须与占位符个数一致
+     *
+     * @return 是否执行成功，失败时已记录错误日志
+     */
+    template <typename... Args>
+    bool execute(const Args&... args) {
+        if (sizeof...(Args) != paramCount_) {
+            return reportParamCountMismatch(sizeof...(Args));
+        }
+        size_t index = 0;
+        (bindParam(index++, args), ...);
+        return executeBound();
+    }
+
+    /**
+     * 按运行时给定的参数列表绑定并执行（参数个数编译期未知时使用，如批量语句）
+     */
+    bool executeParams(const std::vector<std::string_view>& params);
+
+    /**
+     * 取下一行结果
+     *
+     * @return 是否取到一行；没有更多结果或出错时返回 false
+     */
+    bool fetch();
+
+    /**
+     * 当前行某列是否为 NULL
+     */
+    bool isNull(size_t column) const { return columns_[column].isNull; }
+
+    /**
+     * 当前行某列的值（NULL 时为空），视图在下一次 fetch/execute 前有效
+     */
+    std::string_view getString(size_t column) const;
+
+    /**
+     * 当前行某列按整数解析（NULL 或非数字时返回 defaultValue）
+     */
+    int64_t getInt(size_t column, int64_t defaultValue = 0) const;
+
+    /**
+     * 结果集行数（仅查询语句）
+     */
+    uint64_t rowCount() const;
+
+    uint64_t affectedRows() const;
+    uint64_t insertId() const;
+    const char* error() const;
+
+private:
+    struct ResultColumn {
+        std::vector<char> buffer;
+        unsigned long length = 0;
+        BindBool isNull = 0;
+        BindBool truncated = 0;
+    };
+
+    void bindParam(size_t index, std::string_view value);
+    void bindParam(size_t index, const std::string& value) { bindParam(index, std::string_view(value)); }
+    void bindParam(size_t index, const char* value) { bindParam(index, std::string_view(value)); }
+    void bindParam(size_t index, std::nullptr_t);
+    void bindParam(size_t index, const std::optional<std::string_view>& value);
+
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>> bindParam(size_t index, T value) {
+        bindInteger(index, static_cast<long long>(value), std::is_unsigned_v<T>);
+    }
+
+    void bindInteger(size_t index, long long value, bool isUnsigned);
+    bool reportParamCountMismatch(size_t given);
+    bool executeBound();
+    bool bindResult();
+    void checkConnectionLost();
+
+    StatementCache& owner_;
+    MYSQL_STMT* stmt_ = nullptr;
+    std::string sql_;
+    size_t paramCount_ = 0;
+
+    std::vector<MYSQL_BIND> params_;
+    std::vector<unsigned long> paramLengths_;
+    std::vector<long long> paramIntegers_;
+    std::unique_ptr<BindBool[]> paramNulls_;  // 不用 vector：BindBool 为 bool 时无法取元素地址
+
+    std::vector<MYSQL_BIND> results_;
+    std::vector<ResultColumn> columns_;
+    bool hasResult_ = false;
+};
+
+/**
+ * 单个连接上的预处理语句缓存，按 SQL 文本复用
+ *
+ * 随连接一起创建和销毁；连接断开重连后语句需要重新预处理。
+ */
+class StatementCache {
+public:
+    explicit StatementCache(MYSQL* mysql) : mysql_(mysql) {}
+
+    /**
+     * 获取（必要时预处理）语句
+     *
+     * @return 语句；预处理失败时返回 nullptr
+     */
+    PreparedStatement* get(std::string_view sql);
+
+    /**
+     * 执行语句时遇到 CR_SERVER_GONE_ERROR / CR_SERVER_LOST
+     */
+    void markConnectionLost() { connectionLost_ = true; }
+    bool connectionLost() const { return connectionLost_; }
+
+private:
+    MYSQL* mysql_;
+    // 键指向语句自身保存的 SQL 文本，查找时无需构造 std::string
+    std::unordered_map<std::string_view, std::unique_ptr<PreparedStatement>> statements_;
+    bool connectionLost_ = false;
+};
+
+}  // namespace im
+
+#endif  // PREPARED_STATEMENT_H
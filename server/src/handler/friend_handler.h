@@ -2,37 +2,39 @@
 #define FRIEND_HANDLER_H
 
 #include <string>
+#include <string_view>
 
 namespace im {
 
 class EpollServer;
+struct Session;
 
 class FriendHandler {
 public:
     /**
      * 处理发送好友申请
      */
-    static void handleApply(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleApply(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理好友申请的同意 / 拒绝
      */
-    static void handleApplyAction(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleApplyAction(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 获取好友列表
      */
-    static void handleFriendList(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleFriendList(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 删除好友
      */
-    static void handleDelete(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleDelete(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 拉黑 / 取消拉黑好友
      */
-    static void handleBlock(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleBlock(EpollServer& server, const Session& session, std::string_view jsonData);
 };
 
 }  // namespace im
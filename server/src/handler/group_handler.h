@@ -2,52 +2,54 @@
 #define GROUP_HANDLER_H
 
 #include <string>
+#include <string_view>
 
 namespace im {
 
 class EpollServer;
+struct Session;
 
 class GroupHandler {
 public:
     /**
      * 处理创建群请求
      */
-    static void handleCreate(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleCreate(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理获取群列表请求
      */
-    static void handleGroupList(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleGroupList(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理获取群成员列表请求
      */
-    static void handleMemberList(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleMemberList(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理邀请成员入群请求
      */
-    static void handleInvite(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleInvite(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理踢人请求
      */
-    static void handleKick(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleKick(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理退群请求
      */
-    static void handleQuit(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleQuit(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理解散群请求
      */
-    static void handleDismiss(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleDismiss(EpollServer& server, const Session& session, std::string_view jsonData);
 
     /**
      * 处理更新群信息请求
      */
-    static void handleUpdateInfo(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleUpdateInfo(EpollServer& server, const Session& session, std::string_view jsonData);
 };
 
 }  // namespace im
@@ -0,0 +1,101 @@
+#include "history_handler.h"
+#include "server/epoll_server.h"
+#include "protocol/message.h"
+#include "protocol/json_reader.h"
+#include "protocol/json_writer.h"
+#include "database/group_roster_cache.h"
+#include "store/message_store.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace im {
+
+void HistoryHandler::handle(EpollServer& server, const Session& session, std::string_view jsonData) {
+    std::string conversationType, peerUserId, groupId;
+    uint64_t beforeSeq = UINT64_MAX;
+    size_t limit = DEFAULT_PAGE_SIZE;
+
+    JsonReader reader(jsonData);
+    std::string_view key;
+    JsonValue value;
+    int64_t number = 0;
+    while (reader.next(key, value)) {
+        if (key == "conversation_type") {
+            value.copyTo(conversationType);
+        } else if (key == "peer_user_id") {
+            value.copyTo(peerUserId);
+        } else if (key == "group_id") {
+            value.copyTo(groupId);
+        } else if (key == "before_seq" && value.getInt(number) && number > 0) {
+            beforeSeq = static_cast<uint64_t>(number);
+        } else if (key == "limit" && value.getInt(number) && number > 0) {
+            limit = std::min(static_cast<size_t>(number), MAX_PAGE_SIZE);
+        }
+    }
+
+    bool isGroup = (conversationType == "group");
+    std::string conversation;
+    if (isGroup) {
+        if (groupId.empty()) {
+            server.sendMessage(session.fd, MessageType::HISTORY_RESPONSE,
+                               R"({"success":false,"error_code":3002,"error_message":"group_id 不能为空"})");
+            return;
+        }
+        // 只有群成员可以查看群历史
+        GroupRosterPtr roster = GroupRosterCache::getInstance().get(groupId);
+        if (!roster || !roster->contains(session.userId)) {
+            server.sendMessage(session.fd, MessageType::HISTORY_RESPONSE,
+                               R"({"success":false,"error_code":3100,"error_message":"您不是该群成员"})");
+            return;
+        }
+        conversation = MessageStore::groupKey(groupId);
+    } else {
+        if (peerUserId.empty()) {
+            server.sendMessage(session.fd, MessageType::HISTORY_RESPONSE,
+                               R"({"success":false,"error_code":1003,"error_message":"peer_user_id 不能为空"})");
+            return;
+        }
+        // 会话键由自己和对方的 ID 组成，只能读到自己参与的单聊
+        conversation = MessageStore::singleKey(session.userId, peerUserId);
+    }
+
+    // 多取一条用于判断是否还有更早的消息
+    auto messages = MessageStore::getInstance().readBefore(conversation, beforeSeq, limit + 1);
+    bool hasMore = messages.size() > limit;
+    if (hasMore) {
+        messages.erase(messages.begin());
+    }
+
+    size_t bytes = 128;
+    for (const auto& message : messages) {
+        bytes += message.body.size() + 40;
+    }
+    JsonWriter response(MessageType::HISTORY_RESPONSE, bytes);
+    response.beginObject()
+            .field("success", true)
+            .field("conversation_type", isGroup ? "group" : "single");
+    if (isGroup) {
+        response.field("group_id", groupId);
+    } else {
+        response.field("peer_user_id", peerUserId);
+    }
+    // 按序号升序，message 为写入时的 RECEIVE_MESSAGE 数据体
+    response.key("messages").beginArray();
+    for (const auto& message : messages) {
+        response.beginObject()
+                .field("seq", message.sequence)
+                .key("message").rawValue(message.body)
+                .endObject();
+    }
+    response.endArray();
+    if (messages.empty()) {
+        response.field("first_seq", nullptr);
+    } else {
+        response.field("first_seq", messages.front().sequence);
+    }
+    response.field("has_more", hasMore).endObject();
+    server.sendFrame(session.fd, response.finish());
+    LOG_DEBUG("[历史消息] conversation=", conversation, ", before_seq=", beforeSeq, ", count=", messages.size());
+}
+
+}  // namespace im
@@ -0,0 +1,32 @@
+#ifndef HISTORY_HANDLER_H
+#define HISTORY_HANDLER_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace im {
+
+class EpollServer;
+struct Session;
+
+/**
+ * 历史消息：按会话从持久化消息存储向前分页
+ */
+class HistoryHandler {
+public:
+    static constexpr size_t DEFAULT_PAGE_SIZE = 50;
+    static constexpr size_t MAX_PAGE_SIZE = 200;
+
+    /**
+     * 处理历史消息请求
+     *
+     * 单聊：{"conversation_type":"single","peer_user_id":"2","before_seq":N,"limit":L}
+     * 群聊：{"conversation_type":"group","group_id":"1","before_seq":N,"limit":L}
+     * before_seq 不带时从最新一条开始；下一页以响应中的 first_seq 作为 before_seq
+     */
+    static void handle(EpollServer& server, const Session& session, std::string_view jsonData);
+};
+
+}  // namespace im
+
+#endif  // HISTORY_HANDLER_H
@@ -2,22 +2,24 @@
 #define LOGIN_HANDLER_H
 
 #include <string>
+#include <string_view>
 
 namespace im {
 
 class EpollServer;
+struct Session;
 
 class LoginHandler {
 public:
     /**
      * 处理登录请求
      */
-    static void handle(EpollServer& server, int fd, const std::string& jsonData);
+    static void handle(EpollServer& server, const Session& session, std::string_view jsonData);
     
     /**
      * 处理注册请求
      */
-    static void handleRegister(EpollServer& server, int fd, const std::string& jsonData);
+    static void handleRegister(EpollServer& server, const Session& session, std::string_view jsonData);
 };
 
 }  // namespace im
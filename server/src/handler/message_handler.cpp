@@ -1,226 +1,292 @@
 #include "message_handler.h"
+#include "offline_handler.h"
 #include "server/epoll_server.h"
 #include "protocol/message.h"
+#include "protocol/json_reader.h"
+#include "protocol/json_writer.h"
 #include "database/database.h"
+#include "database/db_executor.h"
+#include "database/group_roster_cache.h"
+#include "store/message_store.h"
+#include "utils/id_generator.h"
 #include "utils/logger.h"
-#include <regex>
-#include <sstream>
+#include <chrono>
 #include <ctime>
-#include <mysql/mysql.h>
 #include <vector>
 
 namespace im {
 
-// JSON 转义函数：转义特殊字符
-static std::string escapeJsonString(const std::string& str) {
-    std::ostringstream escaped;
-    for (char c : str) {
-        switch (c) {
-            case '"':  escaped << "\\\""; break;
-            case '\\': escaped << "\\\\"; break;
-            case '\b': escaped << "\\b"; break;
-            case '\f': escaped << "\\f"; break;
-            case '\n': escaped << "\\n"; break;
-            case '\r': escaped << "\\r"; break;
-            case '\t': escaped << "\\t"; break;
-            default:
-                // 控制字符（ASCII < 32）转义为 \uXXXX
-                if (static_cast<unsigned char>(c) < 32) {
-                    char buf[7];
-                    snprintf(buf, sizeof(buf), "\\u%04X", static_cast<unsigned char>(c));
-                    escaped << buf;
-                } else {
-                    escaped << c;
-                }
-                break;
-        }
-    }
-    return escaped.str();
+namespace {
+
+// 投递后多久仍未收到 DELIVERY_ACK 则重发一次
+constexpr std::chrono::seconds ACK_RETRANSMIT_DELAY{30};
+
+std::string frameBody(const Frame& frame) {
+    return std::string(reinterpret_cast<const char*>(frame->data()) + HEADER_SIZE, frame->size() - HEADER_SIZE);
 }
 
-// SQL 转义辅助函数
-static std::string escapeSql(MYSQL* conn, const std::string& value) {
-    if (!conn) return value;
-    std::string result;
-    result.resize(value.size() * 2 + 1);
-    unsigned long len = mysql_real_escape_string(conn, &result[0], value.c_str(), value.size());
-    result.resize(len);
-    return result;
+/**
+ * 写入消息存储：保存 RECEIVE_MESSAGE 的数据体，由存储的写线程异步落盘
+ */
+void persist(std::string conversation, const Frame& frame) {
+    MessageStore::getInstance().append(std::move(conversation), frameBody(frame));
 }
 
-void MessageHandler::handle(EpollServer& server, int fd, const std::string& jsonData) {
-    // 解析消息
-    std::regex toUserIdRegex(R"(\"to_user_id\"\s*:\s*\"([^\"]+)\")");
-    std::regex contentRegex(R"(\"content\"\s*:\s*\"([^\"]+)\")");
-    std::regex messageTypeRegex(R"(\"message_type\"\s*:\s*\"([^\"]+)\")");
-    std::regex conversationTypeRegex(R"(\"conversation_type\"\s*:\s*\"([^\"]+)\")");
-    std::regex groupIdRegex(R"(\"group_id\"\s*:\s*\"([^\"]+)\")");
-    
-    std::smatch toUserIdMatch, contentMatch, messageTypeMatch, convTypeMatch, groupIdMatch;
-    std::string toUserId, content, messageType, conversationType, groupId;
-    
-    if (std::regex_search(jsonData, toUserIdMatch, toUserIdRegex)) {
-        toUserId = toUserIdMatch[1].str();
+/**
+ * 发送确认：服务端已受理，msg_id 为接收方看到的 ID；duplicate 表示是重发，未再次转发
+ */
+void sendAck(EpollServer& server, int fd, std::string_view clientMsgId, uint64_t msgId, bool duplicate) {
+    JsonWriter ack(MessageType::SEND_MESSAGE_ACK);
+    ack.beginObject()
+       .field("success", true)
+       .fieldOrNull("client_msg_id", clientMsgId)
+       .field("msg_id", std::to_string(msgId))
+       .field("duplicate", duplicate)
+       .endObject();
+    server.sendFrame(fd, ack.finish());
+}
+
+/**
+ * 确认超时重发：对方在线但迟迟未确认时补发一次（帧可能卡在已失效的连接里），
+ * 仍未确认的等对方重连后整体重发
+ */
+void scheduleRetransmit(EpollServer& server, const std::string& userId, uint64_t msgId) {
+    server.runAfter(ACK_RETRANSMIT_DELAY, [&server, userId, msgId] {
+        Frame frame = server.deliveries().find(userId, msgId);
+        if (frame && server.sessions().isOnline(userId)) {
+            server.sendFrameToUser(userId, std::move(frame));
+            LOG_INFO("[投递确认] 确认超时，重发消息: user_id=", userId, ", msg_id=", msgId);
+        }
+    });
+}
+
+/**
+ * 已解析、通过基本校验的待发送消息
+ */
+struct OutgoingMessage {
+    std::string toUserId;
+    std::string content;
+    std::string messageType;
+    std::string groupId;
+    std::string clientMsgId;
+    bool isGroup = false;
+    bool targetExists = false;  // 受理时目标在线，无需再查库确认存在
+};
+
+/**
+ * 确定投递路径并转发；roster 为空的群消息、目标不在线的单聊消息会查库，
+ * 执行器启用时这两种情况已由 handle 交给数据库执行器
+ */
+void deliver(EpollServer& server, const Session& session, const OutgoingMessage& message, GroupRosterPtr roster) {
+    const std::string& toUserId = message.toUserId;
+    const std::string& content = message.content;
+    const std::string& messageType = message.messageType;
+    const std::string& groupId = message.groupId;
+    const std::string& clientMsgId = message.clientMsgId;
+    bool isGroupConversation = message.isGroup;
+
+    // 先确定投递路径，校验失败的消息不进入去重窗口，客户端可修正后重试
+    bool broadcast = !isGroupConversation && toUserId == "all";
+    bool targetOnline = false;
+    if (isGroupConversation) {
+        // 群聊消息：成员名单读缓存，未命中时才查库
+        if (!roster) {
+            roster = GroupRosterCache::getInstance().get(groupId);
+        }
+        if (!roster) {
+            LOG_ERROR("[群聊消息] 查询群成员失败: group_id=", groupId);
+            server.sendMessage(session.fd, MessageType::ERROR,
+                             R"({"error_code":5001,"error_message":"查询群成员失败"})");
+            return;
+        }
+
+        // 检查发送者是否是该群成员
+        if (!roster->contains(session.userId)) {
+            server.sendMessage(session.fd, MessageType::ERROR,
+                             R"({"error_code":3100,"error_message":"您不是该群成员，无法发送群消息"})");
+            return;
+        }
+    } else if (!broadcast) {
+        targetOnline = server.sessions().isOnline(toUserId);
+        if (!targetOnline && !message.targetExists && !Database::getInstance().userIdExists(toUserId)) {
+            // 用户不存在，给发送者返回错误
+            JsonWriter error(MessageType::ERROR);
+            error.beginObject()
+                 .field("error_code", 1004)
+                 .field("error_message", "目标用户不存在")
+                 .field("to_user_id", toUserId)
+                 .endObject();
+            server.sendFrame(session.fd, error.finish());
+            LOG_WARN("[消息转发] ✗ 目标用户不存在: sender=" + session.username + ", target=" + toUserId);
+            return;
+        }
     }
-    if (std::regex_search(jsonData, contentMatch, contentRegex)) {
-        content = contentMatch[1].str();
+
+    // 重发的消息（同一发送者、同一 client_msg_id）只回确认，不再转发
+    uint64_t msgId = IdGenerator::getInstance().next();
+    if (!clientMsgId.empty()) {
+        uint64_t original = server.sendDedup().insertIfAbsent(session.userId, clientMsgId, msgId);
+        if (original != 0) {
+            sendAck(server, session.fd, clientMsgId, original, true);
+            LOG_INFO("[消息转发] 重复发送，已忽略: sender=", session.username, ", client_msg_id=", clientMsgId);
+            return;
+        }
     }
-    if (std::regex_search(jsonData, messageTypeMatch, messageTypeRegex)) {
-        messageType = messageTypeMatch[1].str();
+    
+    // 构造接收消息（直接写入帧缓冲区，转义特殊字符），msg_id 供客户端去重、排序和确认
+    JsonWriter response(MessageType::RECEIVE_MESSAGE, 224 + content.size());
+    response.beginObject()
+            .field("msg_id", std::to_string(msgId))
+            .field("conversation_type", isGroupConversation ? "group" : "single")
+            .field("from_user_id", session.userId)
+            .field("from_username", session.username)
+            .field("content", content)
+            .field("message_type", messageType.empty() ? std::string_view("text") : std::string_view(messageType))
+            .field("timestamp", static_cast<int64_t>(time(nullptr)));
+
+    if (isGroupConversation) {
+        response.field("group_id", groupId);
+    } else if (!broadcast) {
+        response.field("to_user_id", toUserId);
     }
-    if (std::regex_search(jsonData, convTypeMatch, conversationTypeRegex)) {
-        conversationType = convTypeMatch[1].str();
+
+    response.endObject();
+    Frame frame = makeFrame(response.finish());  // 只编码一次，所有接收方共享
+    
+    // 转发消息
+    if (isGroupConversation) {
+        persist(MessageStore::groupKey(groupId), frame);
+
+        // 给所有在线成员发送（包括发送者自己，客户端可按需要过滤）
+        size_t delivered = server.sendFrameToUsers(roster->userIds, frame);
+        LOG_INFO("[群聊消息] 转发群聊消息: group_id=", groupId, ", from=", session.username,
+                 ", member_count=", roster->userIds.size(), ", online_count=", delivered);
+    } else if (broadcast) {
+        // 群发
+        server.broadcastFrame(frame, session.fd);
+        LOG_INFO("[消息转发] 群发消息: " + session.username + " -> all");
+    } else if (targetOnline) {
+        // 单发：记录待确认，对方重连后未确认的消息会重发
+        persist(MessageStore::singleKey(session.userId, toUserId), frame);
+        server.deliveries().track(toUserId, msgId, frame);
+        server.sendFrameToUser(toUserId, std::move(frame));
+        scheduleRetransmit(server, toUserId, msgId);
+        LOG_INFO("[消息转发] 私聊消息: " + session.username + " -> " + toUserId);
+    } else {
+        // 用户不在线：存入离线收件箱，登录后同步
+        persist(MessageStore::singleKey(session.userId, toUserId), frame);
+        OfflineHandler::store(server, toUserId, frameBody(frame));
+        LOG_INFO("[消息转发] 私聊消息存入离线收件箱: " + session.username + " -> " + toUserId);
     }
-    if (std::regex_search(jsonData, groupIdMatch, groupIdRegex)) {
-        groupId = groupIdMatch[1].str();
+
+    sendAck(server, session.fd, clientMsgId, msgId, false);
+}
+
+}  // namespace
+
+void MessageHandler::handle(EpollServer& server, const Session& session, std::string_view jsonData) {
+    // 解析消息（单遍，content 中的转义字符按 JSON 规则解码）
+    std::string toUserId, content, messageType, conversationType, groupId, clientMsgId;
+    
+    JsonReader reader(jsonData);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key == "to_user_id") {
+            value.copyTo(toUserId);
+        } else if (key == "content") {
+            value.copyTo(content);
+        } else if (key == "message_type") {
+            value.copyTo(messageType);
+        } else if (key == "conversation_type") {
+            value.copyTo(conversationType);
+        } else if (key == "group_id") {
+            value.copyTo(groupId);
+        } else if (key == "client_msg_id") {
+            value.copyTo(clientMsgId);
+        }
     }
     
     if (content.empty()) {
-        server.sendMessage(fd, MessageType::ERROR, 
+        server.sendMessage(session.fd, MessageType::ERROR, 
                          R"({"error_code":1002,"error_message":"消息内容不能为空"})");
         return;
     }
     
-    // 获取发送者信息
-    auto senderInfo = server.getClientInfo(fd);
-    if (!senderInfo) {
-        server.sendMessage(fd, MessageType::ERROR, 
-                         R"({"error_code":1001,"error_message":"请先登录"})");
-        return;
-    }
-
     bool isGroupConversation = (conversationType == "group");
     if (isGroupConversation && groupId.empty()) {
-        server.sendMessage(fd, MessageType::ERROR,
+        server.sendMessage(session.fd, MessageType::ERROR,
                          R"({"error_code":3002,"error_message":"group_id 不能为空"})");
         return;
     }
     
-    // 构造接收消息（转义特殊字符）
-    std::ostringstream response;
-    response << R"({"conversation_type":")" << (isGroupConversation ? "group" : "single") << R"(")"
-             << R"(,"from_user_id":")" << escapeJsonString(senderInfo->userId)
-             << R"(","from_username":")" << escapeJsonString(senderInfo->username)
-             << R"(","content":")" << escapeJsonString(content)
-             << R"(","message_type":")" << escapeJsonString(messageType.empty() ? "text" : messageType)
-             << R"(","timestamp":)" << time(nullptr);
-
-    if (isGroupConversation) {
-        response << R"(,"group_id":")" << escapeJsonString(groupId) << R"(")";
-    } else if (!toUserId.empty() && toUserId != "all") {
-        response << R"(,"to_user_id":")" << escapeJsonString(toUserId) << R"(")";
+    if (!isGroupConversation && toUserId.empty()) {
+        server.sendMessage(session.fd, MessageType::ERROR, 
+                         R"({"error_code":1003,"error_message":"目标用户ID不能为空"})");
+        LOG_WARN("[消息转发] ✗ 目标用户ID为空: sender=" + session.username);
+        return;
     }
 
-    response << "}";
-    
-    // 转发消息
-    if (isGroupConversation) {
-        // 群聊消息：检查群成员并向群成员广播
-        Database& db = Database::getInstance();
-        if (!db.isConnected()) {
-            server.sendMessage(fd, MessageType::ERROR,
-                             R"({"error_code":5000,"error_message":"服务器数据库未连接"})");
-            return;
-        }
-        MYSQL* conn = db.getConnection();
-
-        // 检查发送者是否是该群成员
-        std::string escapedGroupId = escapeSql(conn, groupId);
-        std::string escapedSenderId = escapeSql(conn, senderInfo->userId);
-        std::string checkMemberSql =
-            "SELECT COUNT(*) FROM group_members WHERE group_id = " + escapedGroupId +
-            " AND user_id = " + escapedSenderId;
-        if (mysql_query(conn, checkMemberSql.c_str()) != 0) {
-            Logger::error("[群聊消息] 查询成员失败: " + std::string(mysql_error(conn)));
-            server.sendMessage(fd, MessageType::ERROR,
-                             R"({"error_code":5001,"error_message":"查询群成员失败"})");
-            return;
-        }
-        MYSQL_RES* res = mysql_store_result(conn);
-        if (!res) {
-            Logger::error("[群聊消息] 获取查询结果失败: " + std::string(mysql_error(conn)));
-            server.sendMessage(fd, MessageType::ERROR,
-                             R"({"error_code":5001,"error_message":"查询群成员失败"})");
-            return;
-        }
-        MYSQL_ROW row = mysql_fetch_row(res);
-        bool isMember = row && std::atoi(row[0]) > 0;
-        mysql_free_result(res);
-
-        if (!isMember) {
-            server.sendMessage(fd, MessageType::ERROR,
-                             R"({"error_code":3100,"error_message":"您不是该群成员，无法发送群消息"})");
-            return;
-        }
+    OutgoingMessage message{std::move(toUserId), std::move(content), std::move(messageType),
+                            std::move(groupId), std::move(clientMsgId), isGroupConversation};
 
-        // 查询群内所有成员
-        std::string membersSql =
-            "SELECT user_id FROM group_members WHERE group_id = " + escapedGroupId;
-        if (mysql_query(conn, membersSql.c_str()) != 0) {
-            Logger::error("[群聊消息] 查询群成员列表失败: " + std::string(mysql_error(conn)));
-            server.sendMessage(fd, MessageType::ERROR,
-                             R"({"error_code":5002,"error_message":"查询群成员列表失败"})");
-            return;
-        }
-        res = mysql_store_result(conn);
-        if (!res) {
-            Logger::error("[群聊消息] 获取群成员列表结果失败: " + std::string(mysql_error(conn)));
-            server.sendMessage(fd, MessageType::ERROR,
-                             R"({"error_code":5002,"error_message":"查询群成员列表失败"})");
-            return;
-        }
+    // 群名单未缓存、目标不在线（需查库确认用户存在）时会访问数据库：交给数据库执行器继续处理，
+    // 业务线程不因 MySQL 卡顿而阻塞；执行期间该连接暂停处理，消息顺序不变
+    GroupRosterPtr roster;
+    bool needsDatabase = false;
+    if (message.isGroup) {
+        roster = GroupRosterCache::getInstance().find(message.groupId);
+        needsDatabase = !roster;
+    } else if (message.toUserId != "all") {
+        message.targetExists = server.sessions().isOnline(message.toUserId);
+        needsDatabase = !message.targetExists;
+    }
 
-        std::vector<std::string> memberIds;
-        while ((row = mysql_fetch_row(res)) != nullptr) {
-            if (row[0]) {
-                memberIds.emplace_back(row[0]);
-            }
+    if (needsDatabase && DbExecutor::getInstance().isRunning()) {
+        bool accepted = server.deferToDatabase(session, [&server, snapshot = Session(session),
+                                                         message = std::move(message)] {
+            deliver(server, snapshot, message, nullptr);
+        });
+        if (!accepted) {
+            server.sendMessage(session.fd, MessageType::ERROR,
+                               R"({"error_code":1006,"error_message":"服务器繁忙"})");
+            LOG_WARN("[消息转发] 数据库执行器繁忙，已拒绝: sender=", session.username);
         }
-        mysql_free_result(res);
+        return;
+    }
+    deliver(server, session, message, std::move(roster));
+}
 
-        // 给所有成员发送（包括发送者自己，客户端可按需要过滤）
-        std::string respStr = response.str();
-        for (const auto& uid : memberIds) {
-            server.sendMessageToUser(uid, MessageType::RECEIVE_MESSAGE, respStr);
-        }
-        Logger::info("[群聊消息] 转发群聊消息: group_id=" + groupId +
-                     ", from=" + senderInfo->username +
-                     ", member_count=" + std::to_string(memberIds.size()));
-    } else {
-        // 单聊 / 广播：保持兼容旧逻辑
-    if (toUserId == "all") {
-        // 群发
-        server.broadcastMessage(MessageType::RECEIVE_MESSAGE, response.str(), fd);
-        Logger::info("[消息转发] 群发消息: " + senderInfo->username + " -> all");
-    } else if (toUserId.empty()) {
-        // to_user_id 为空
-        server.sendMessage(fd, MessageType::ERROR, 
-                         R"({"error_code":1003,"error_message":"目标用户ID不能为空"})");
-        Logger::warn("[消息转发] ✗ 目标用户ID为空: sender=" + senderInfo->username);
-    } else {
-        // 单发
-        bool userFound = false;
-        {
-            // 先检查目标用户是否在线
-            auto onlineUsers = server.getOnlineUsers();
-            for (const auto& uid : onlineUsers) {
-                if (uid == toUserId) {
-                    userFound = true;
-                    break;
+void MessageHandler::handleDeliveryAck(EpollServer& server, const Session& session, std::string_view jsonData) {
+    // {"msg_id":"1"} 或批量 {"msg_ids":["1","2"]}
+    size_t acked = 0;
+    int64_t msgId = 0;
+    JsonReader reader(jsonData);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key == "msg_id" && value.getInt(msgId)) {
+            acked += server.deliveries().ack(session.userId, static_cast<uint64_t>(msgId));
+        } else if (key == "msg_ids") {
+            JsonArrayReader array(value);
+            JsonValue element;
+            while (array.next(element)) {
+                if (element.getInt(msgId)) {
+                    acked += server.deliveries().ack(session.userId, static_cast<uint64_t>(msgId));
                 }
             }
         }
-        
-        if (userFound) {
-            server.sendMessageToUser(toUserId, MessageType::RECEIVE_MESSAGE, response.str());
-            Logger::info("[消息转发] 私聊消息: " + senderInfo->username + " -> " + toUserId);
-        } else {
-            // 用户不在线，给发送者返回错误
-            server.sendMessage(fd, MessageType::ERROR, 
-                             R"({"error_code":1004,"error_message":"目标用户不在线","to_user_id":")" + toUserId + "\"}");
-            Logger::warn("[消息转发] ✗ 目标用户不在线: sender=" + senderInfo->username + ", target=" + toUserId);
-            }
-        }
+    }
+    LOG_DEBUG("[投递确认] user_id=", session.userId, ", acked=", acked);
+}
+
+void MessageHandler::retransmitPending(EpollServer& server, int fd, const std::string& userId) {
+    auto frames = server.deliveries().pending(userId);
+    for (auto& frame : frames) {
+        server.sendFrame(fd, std::move(frame));
+    }
+    if (!frames.empty()) {
+        LOG_INFO("[投递确认] 重发未确认消息: user_id=", userId, ", count=", frames.size());
     }
 }
 
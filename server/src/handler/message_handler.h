@@ -2,17 +2,31 @@
 #define MESSAGE_HANDLER_H
 
 #include <string>
+#include <string_view>
 
 namespace im {
 
 class EpollServer;
+struct Session;
 
 class MessageHandler {
 public:
     /**
      * 处理发送消息
+     *
+     * 受理后回 SEND_MESSAGE_ACK；带 client_msg_id 的重发在去重窗口内只回确认
      */
-    static void handle(EpollServer& server, int fd, const std::string& jsonData);
+    static void handle(EpollServer& server, const Session& session, std::string_view jsonData);
+
+    /**
+     * 处理接收方的投递确认（DELIVERY_ACK）
+     */
+    static void handleDeliveryAck(EpollServer& server, const Session& session, std::string_view jsonData);
+
+    /**
+     * 重连后重发仍未确认的消息
+     */
+    static void retransmitPending(EpollServer& server, int fd, const std::string& userId);
 };
 
 }  // namespace im
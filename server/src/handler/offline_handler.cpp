@@ -0,0 +1,177 @@
+#include "offline_handler.h"
+#include "server/epoll_server.h"
+#include "protocol/message.h"
+#include "protocol/json_reader.h"
+#include "protocol/json_writer.h"
+#include "store/message_store.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace im {
+
+namespace {
+
+// 已推送位置（内存中）：客户端未上报序号时从这里继续，避免每次登录重复推送同一页；
+// 推送不等于收到，收件箱只删除到客户端确认的位置，重启后从确认位置重新推送
+std::mutex pushedMutex;
+std::unordered_map<std::string, uint64_t> pushedThrough;  // userId -> 已推送到的序号
+
+/**
+ * 收件箱已删除到的序号，即客户端确认过的位置
+ */
+uint64_t ackedThrough(const std::string& userId) {
+    return MessageStore::getInstance().trimmedThrough(MessageStore::inboxKey(userId));
+}
+
+/**
+ * 客户端未上报序号时的起始位置：已推送与已确认中较大者
+ */
+uint64_t resumePosition(const std::string& userId) {
+    uint64_t acked = ackedThrough(userId);
+    std::lock_guard<std::mutex> lock(pushedMutex);
+    auto it = pushedThrough.find(userId);
+    return it == pushedThrough.end() ? acked : std::max(it->second, acked);
+}
+
+void markPushed(const std::string& userId, uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(pushedMutex);
+    uint64_t& pushed = pushedThrough[userId];
+    pushed = std::max(pushed, sequence);
+}
+
+/**
+ * 客户端确认已收到 sequence 及之前的消息：删除这部分收件箱记录（只前进不后退）；
+ * 上报的序号不超过已落盘的位置，避免把之后写入的消息提前删掉
+ */
+void acknowledge(const std::string& userId, uint64_t sequence) {
+    MessageStore& store = MessageStore::getInstance();
+    sequence = std::min(sequence, store.lastSequence());
+    if (sequence <= ackedThrough(userId)) {
+        return;
+    }
+    store.trim(MessageStore::inboxKey(userId), sequence);
+
+    std::lock_guard<std::mutex> lock(pushedMutex);
+    auto it = pushedThrough.find(userId);
+    if (it != pushedThrough.end() && it->second <= sequence) {
+        pushedThrough.erase(it);
+    }
+}
+
+/**
+ * 构造一页同步响应：{"success":true,"messages":[{"seq":N,"message":{...}}],"last_seq":N,"has_more":false}
+ *
+ * message 为写入时的 RECEIVE_MESSAGE 数据体，原样嵌入
+ */
+std::vector<uint8_t> buildPage(const std::string& userId, uint64_t afterSeq, size_t limit, size_t& count,
+                               uint64_t& lastSeq) {
+    // 多取一条用于判断是否还有下一页
+    auto messages = MessageStore::getInstance().readAfter(MessageStore::inboxKey(userId), afterSeq, limit + 1);
+    bool hasMore = messages.size() > limit;
+    if (hasMore) {
+        messages.pop_back();
+    }
+    count = messages.size();
+    lastSeq = messages.empty() ? afterSeq : messages.back().sequence;
+
+    size_t bytes = 64;
+    for (const auto& message : messages) {
+        bytes += message.body.size() + 40;
+    }
+    JsonWriter page(MessageType::OFFLINE_SYNC_RESPONSE, bytes);
+    page.beginObject().field("success", true).key("messages").beginArray();
+    for (const auto& message : messages) {
+        page.beginObject()
+            .field("seq", message.sequence)
+            .key("message").rawValue(message.body)
+            .endObject();
+    }
+    page.endArray()
+        .field("last_seq", lastSeq)
+        .field("has_more", hasMore)
+        .endObject();
+    return page.finish();
+}
+
+}  // namespace
+
+void OfflineHandler::store(EpollServer& server, const std::string& userId, std::string body) {
+    MessageStore::getInstance().append(
+        MessageStore::inboxKey(userId), std::move(body), [&server, userId](uint64_t sequence, bool ok) {
+            if (!ok) {
+                LOG_ERROR("[离线消息] 写入收件箱失败: user_id=", userId, ", seq=", sequence);
+                return;
+            }
+            // 对方在写入期间上线时补推尚未推送的消息，客户端按 seq 去重；
+            // 回调在存储写线程中执行，读取、编码交给线程池，不拖慢组提交
+            if (server.sessions().isOnline(userId)) {
+                server.post([&server, userId] {
+                    size_t count = 0;
+                    uint64_t lastSeq = 0;
+                    auto page = buildPage(userId, resumePosition(userId), DEFAULT_PAGE_SIZE, count, lastSeq);
+                    if (count > 0) {
+                        server.sendFrameToUser(userId, std::move(page));
+                        markPushed(userId, lastSeq);
+                    }
+                });
+            }
+        });
+}
+
+void OfflineHandler::syncOnLogin(EpollServer& server, int fd, const std::string& userId,
+                                 std::optional<uint64_t> lastSeq) {
+    // 客户端上报的位置视为确认，并从该位置续传（即使早于已推送位置，例如上一页未送达就断开）
+    uint64_t afterSeq = 0;
+    if (lastSeq) {
+        afterSeq = *lastSeq;
+        acknowledge(userId, afterSeq);
+    } else {
+        afterSeq = resumePosition(userId);
+    }
+
+    size_t count = 0;
+    uint64_t pageEnd = 0;
+    auto page = buildPage(userId, afterSeq, DEFAULT_PAGE_SIZE, count, pageEnd);
+    if (count == 0) {
+        return;
+    }
+    // 记录已推送位置：客户端不上报序号时不会每次登录重复收到同一页
+    server.sendFrame(fd, std::move(page));
+    markPushed(userId, pageEnd);
+    LOG_INFO("[离线消息] 登录同步: user_id=", userId, ", after_seq=", afterSeq, ", count=", count);
+}
+
+void OfflineHandler::handleSync(EpollServer& server, const Session& session, std::string_view jsonData) {
+    std::optional<uint64_t> afterSeq;
+    size_t limit = DEFAULT_PAGE_SIZE;
+
+    JsonReader reader(jsonData);
+    std::string_view key;
+    JsonValue value;
+    int64_t number = 0;
+    while (reader.next(key, value)) {
+        if (key == "after_seq" && value.getInt(number) && number >= 0) {
+            afterSeq = static_cast<uint64_t>(number);
+        } else if (key == "limit" && value.getInt(number) && number > 0) {
+            limit = std::min(static_cast<size_t>(number), MAX_PAGE_SIZE);
+        }
+    }
+
+    uint64_t from = 0;
+    if (afterSeq) {
+        from = *afterSeq;
+        acknowledge(session.userId, from);
+    } else {
+        from = resumePosition(session.userId);
+    }
+
+    size_t count = 0;
+    uint64_t pageEnd = 0;
+    server.sendFrame(session.fd, buildPage(session.userId, from, limit, count, pageEnd));
+    markPushed(session.userId, pageEnd);
+    LOG_DEBUG("[离线消息] 同步: user_id=", session.userId, ", after_seq=", from, ", count=", count);
+}
+
+}  // namespace im
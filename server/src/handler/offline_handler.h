@@ -0,0 +1,53 @@
+#ifndef OFFLINE_HANDLER_H
+#define OFFLINE_HANDLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace im {
+
+class EpollServer;
+struct Session;
+
+/**
+ * 离线消息：用户不在线时单聊消息写入其收件箱（持久化消息存储），
+ * 登录后按序号分页同步，客户端可从上次收到的序号续传
+ *
+ * 客户端上报的序号（登录的 last_seq、同步请求的 after_seq）即确认，收件箱只删除到确认的位置
+ * （MessageStore::trim）；页面总是从客户端上报的位置开始，推送后未送达的页面可以重新拉取。
+ * 客户端未上报序号时从内存中记录的已推送位置继续，不重复推送同一页
+ */
+class OfflineHandler {
+public:
+    static constexpr size_t DEFAULT_PAGE_SIZE = 200;
+    static constexpr size_t MAX_PAGE_SIZE = 1000;
+
+    /**
+     * 消息写入离线收件箱（body 为 RECEIVE_MESSAGE 的数据体）
+     *
+     * 落盘时对方若已上线（登录同步可能早于落盘），直接补推这一条
+     */
+    static void store(EpollServer& server, const std::string& userId, std::string body);
+
+    /**
+     * 登录成功后推送第一页离线消息，没有离线消息时不推送
+     *
+     * @param lastSeq 客户端上报的已收到序号（同时作为确认），未上报时从已推送位置继续
+     */
+    static void syncOnLogin(EpollServer& server, int fd, const std::string& userId,
+                            std::optional<uint64_t> lastSeq);
+
+    /**
+     * 处理离线消息同步请求：{"after_seq":N,"limit":L}
+     *
+     * after_seq 同时表示此前的消息已收到；未带时从已推送位置继续
+     */
+    static void handleSync(EpollServer& server, const Session& session, std::string_view jsonData);
+};
+
+}  // namespace im
+
+#endif  // OFFLINE_HANDLER_H
@@ -1,8 +1,8 @@
 #include "user_handler.h"
 #include "server/epoll_server.h"
 #include "protocol/message.h"
+#include "protocol/json_writer.h"
 #include "utils/logger.h"
-#include <sstream>
 #include <map>
 #include <mutex>
 
@@ -12,19 +12,13 @@ namespace im {
 static std::map<std::string, std::string> userNicknames;  // userId -> nickname
 static std::mutex nicknamesMutex_;
 
-void UserHandler::handleUserList(EpollServer& server, int fd) {
+void UserHandler::handleUserList(EpollServer& server, const Session& session, std::string_view /*jsonData*/) {
     auto onlineUsers = server.getOnlineUsersWithInfo();
     
-    std::ostringstream response;
-    response << R"({"users":[)";
+    JsonWriter response(MessageType::USER_LIST_RESPONSE, 16 + onlineUsers.size() * 96);
+    response.beginObject().key("users").beginArray();
     
-    bool first = true;
     for (const auto& [userId, username] : onlineUsers) {
-        if (!first) {
-            response << ",";
-        }
-        first = false;
-        
         // 获取昵称（优先使用存储的昵称，否则使用用户名）
         std::string nickname = username;
         {
@@ -34,16 +28,18 @@ void UserHandler::handleUserList(EpollServer& server, int fd) {
             }
         }
         
-        response << R"({"user_id":")" << userId
-                 << R"(","username":")" << username
-                 << R"(","nickname":")" << nickname
-                 << R"(","online":true})";
+        response.beginObject()
+                .field("user_id", userId)
+                .field("username", username)
+                .field("nickname", nickname)
+                .field("online", true)
+                .endObject();
     }
     
-    response << "]}";
+    response.endArray().endObject();
     
-    server.sendMessage(fd, MessageType::USER_LIST_RESPONSE, response.str());
-    Logger::info("返回用户列表: " + std::to_string(onlineUsers.size()) + " 个在线用户");
+    server.sendFrame(session.fd, response.finish());
+    LOG_INFO("返回用户列表: " + std::to_string(onlineUsers.size()) + " 个在线用户");
 }
 
 }  // namespace im
@@ -1,16 +1,19 @@
 #ifndef USER_HANDLER_H
 #define USER_HANDLER_H
 
+#include <string_view>
+
 namespace im {
 
 class EpollServer;
+struct Session;
 
 class UserHandler {
 public:
     /**
      * 处理用户列表请求
      */
-    static void handleUserList(EpollServer& server, int fd);
+    static void handleUserList(EpollServer& server, const Session& session, std::string_view jsonData);
 };
 
 }  // namespace im
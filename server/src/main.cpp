@@ -1,7 +1,10 @@
 #include "server/epoll_server.h"
 #include "database/database.h"
+#include "database/db_executor.h"
+#include "database/group_roster_cache.h"
+#include "store/message_store.h"
+#include "utils/id_generator.h"
 #include "utils/logger.h"
-#include <iostream>
 #include <signal.h>
 #include <unistd.h>
 #include <atomic>
@@ -9,17 +12,22 @@
 
 im::EpollServer* g_server = nullptr;
 std::atomic<bool> g_shutdown(false);
+std::atomic<int> g_signal(0);
 
 void signalHandler(int sig) {
+    // 信号处理函数中只调用异步信号安全的函数：设置标志并唤醒事件循环，
+    // 停止服务器与日志都在 run() 返回后由主线程完成
     if (g_shutdown.exchange(true)) {
         // 第二次收到信号，强制退出
-        im::Logger::warn("收到第二次信号，强制退出");
+        const char msg[] = "收到第二次信号，强制退出\n";
+        ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        (void)ignored;
         _exit(1);
     }
     
+    g_signal = sig;
     if (g_server) {
-        im::Logger::info("收到信号 " + std::to_string(sig) + "，正在关闭服务器...");
-        g_server->stop();
+        g_server->requestStop();
     }
 }
 
@@ -29,6 +37,22 @@ int main(int argc, char* argv[]) {
         port = std::stoi(argv[1]);
     }
     
+    // 日志配置：LOG_LEVEL 运行期级别（debug/info/warn/error，默认 info），LOG_FILE 输出文件（默认标准输出）
+    const char* logLevel = std::getenv("LOG_LEVEL");
+    const char* logFile = std::getenv("LOG_FILE");
+    const char* logMaxSize = std::getenv("LOG_MAX_SIZE_MB");
+    im::Logger::Options logOptions;
+    if (logLevel) {
+        logOptions.level = im::Logger::parseLevel(logLevel, im::Logger::Level::INFO);
+    }
+    if (logFile) {
+        logOptions.filePath = logFile;
+    }
+    if (logMaxSize) {
+        logOptions.maxFileSize = std::stoul(logMaxSize) << 20;
+    }
+    im::Logger::init(logOptions);
+    
     // 初始化数据库连接
     // 从环境变量读取数据库配置，如果没有则使用默认值
     const char* dbHost = std::getenv("DB_HOST");
@@ -44,32 +68,124 @@ int main(int argc, char* argv[]) {
     std::string database = dbName ? dbName : "im_server";
     unsigned int dbPortNum = dbPort ? std::stoi(dbPort) : 3306;
     
+    // 连接池上限：DB_POOL_SIZE 环境变量，默认 8
+    const char* dbPoolSize = std::getenv("DB_POOL_SIZE");
+    size_t poolSize = dbPoolSize ? std::stoul(dbPoolSize) : 8;
+    
     im::Database& db = im::Database::getInstance();
-    if (!db.init(host, user, password, database, dbPortNum)) {
-        im::Logger::error("数据库初始化失败，服务器无法启动");
-        im::Logger::info("提示: 请设置环境变量 DB_HOST, DB_USER, DB_PASSWORD, DB_NAME");
-        im::Logger::info("或确保 MySQL 服务运行在 localhost:3306，数据库名为 im_server");
+    if (!db.init(host, user, password, database, dbPortNum, poolSize)) {
+        LOG_ERROR("数据库初始化失败，服务器无法启动");
+        LOG_INFO("提示: 请设置环境变量 DB_HOST, DB_USER, DB_PASSWORD, DB_NAME");
+        LOG_INFO("或确保 MySQL 服务运行在 localhost:3306，数据库名为 im_server");
+        im::Logger::shutdown();
+        return 1;
+    }
+    
+    // 数据库执行器：DB_EXECUTOR_THREADS 线程数（默认与连接池上限相同，0 表示不启用、在业务线程中直接访问数据库），
+    // DB_QUEUE_SIZE 排队上限（默认 1024），排满后新的数据库请求直接回“服务器繁忙”
+    const char* dbExecutorThreads = std::getenv("DB_EXECUTOR_THREADS");
+    const char* dbQueueSize = std::getenv("DB_QUEUE_SIZE");
+    size_t executorThreads = dbExecutorThreads ? std::stoul(dbExecutorThreads) : poolSize;
+    im::DbExecutor& dbExecutor = im::DbExecutor::getInstance();
+    if (executorThreads > 0) {
+        dbExecutor.start(executorThreads, dbQueueSize ? std::stoul(dbQueueSize) : 1024);
+    }
+    
+    // 群成员缓存内存上限：GROUP_CACHE_MB 环境变量，默认 64MB
+    const char* groupCacheMb = std::getenv("GROUP_CACHE_MB");
+    if (groupCacheMb) {
+        im::GroupRosterCache::getInstance().setMemoryLimit(std::stoul(groupCacheMb) << 20);
+    }
+    
+    // 消息 ID 节点号：IM_NODE_ID 环境变量（0 ~ 63，默认 0），多实例部署时每个实例必须不同
+    const char* nodeId = std::getenv("IM_NODE_ID");
+    if (nodeId) {
+        im::IdGenerator::getInstance().setNodeId(std::stoul(nodeId));
+    }
+    
+    // 消息存储：MSG_STORE_DIR 目录（默认 data/messages），MSG_STORE_SEGMENT_MB 段大小（默认 64），
+    // MSG_STORE_RETENTION_DAYS 保留天数（默认 30，0 表示永久保留）
+    const char* storeDir = std::getenv("MSG_STORE_DIR");
+    const char* storeSegmentMb = std::getenv("MSG_STORE_SEGMENT_MB");
+    const char* storeRetentionDays = std::getenv("MSG_STORE_RETENTION_DAYS");
+    im::MessageStoreOptions storeOptions;
+    if (storeDir) {
+        storeOptions.directory = storeDir;
+    }
+    if (storeSegmentMb) {
+        storeOptions.segmentSize = std::stoul(storeSegmentMb) << 20;
+    }
+    if (storeRetentionDays) {
+        storeOptions.retention = std::chrono::hours(24 * std::stol(storeRetentionDays));
+    }
+    im::MessageStore& store = im::MessageStore::getInstance();
+    if (!store.open(storeOptions)) {
+        LOG_ERROR("消息存储初始化失败，服务器无法启动");
+        dbExecutor.stop();
+        db.close();
+        im::Logger::shutdown();
         return 1;
     }
     
-    im::EpollServer server(port);
+    // Reactor 数量：REACTOR_COUNT 环境变量，0 表示按 CPU 核数，默认单 Reactor
+    const char* reactorCountEnv = std::getenv("REACTOR_COUNT");
+    size_t reactorCount = reactorCountEnv ? std::stoul(reactorCountEnv) : 1;
+    
+    // 业务线程池：WORKER_THREADS 工作线程数（默认 0，按 CPU 核数），WORK_STEALING=1 启用工作窃取模式
+    const char* workerThreads = std::getenv("WORKER_THREADS");
+    const char* workStealing = std::getenv("WORK_STEALING");
+    size_t workerCount = workerThreads ? std::stoul(workerThreads) : 0;
+    bool stealing = workStealing && std::string(workStealing) == "1";
+    
+    im::EpollServer server(port, reactorCount, workerCount, stealing);
     g_server = &server;
     
+    // 连接超时：HEARTBEAT_TIMEOUT_SEC 心跳超时（默认 90），LOGIN_TIMEOUT_SEC 登录期限（默认 30），0 表示不检查
+    const char* heartbeatTimeout = std::getenv("HEARTBEAT_TIMEOUT_SEC");
+    const char* loginTimeout = std::getenv("LOGIN_TIMEOUT_SEC");
+    server.setIdleTimeouts(std::chrono::seconds(heartbeatTimeout ? std::stol(heartbeatTimeout) : 90),
+                           std::chrono::seconds(loginTimeout ? std::stol(loginTimeout) : 30));
+    
+    // 按连接限流：RATE_LIMIT_PER_SEC 每秒请求数（默认 0 不限流），RATE_LIMIT_BURST 突发上限（默认为每秒请求数的 2 倍）
+    const char* rateLimit = std::getenv("RATE_LIMIT_PER_SEC");
+    const char* rateBurst = std::getenv("RATE_LIMIT_BURST");
+    if (rateLimit) {
+        uint32_t perSecond = std::stoul(rateLimit);
+        server.setRateLimit(perSecond, rateBurst ? std::stoul(rateBurst) : perSecond * 2);
+    }
+    
+    // 在线状态推送：PRESENCE_COALESCE_MS 合并窗口（默认 200 毫秒），0 表示不推送
+    const char* presenceWindow = std::getenv("PRESENCE_COALESCE_MS");
+    server.setPresenceWindow(std::chrono::milliseconds(presenceWindow ? std::stol(presenceWindow) : 200));
+    
     // 注册信号处理
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    // 对端已关闭时写入返回 EPIPE，而不是以 SIGPIPE 终止进程
+    signal(SIGPIPE, SIG_IGN);
     
     if (!server.start()) {
-        im::Logger::error("服务器启动失败");
+        LOG_ERROR("服务器启动失败");
+        dbExecutor.stop();
+        store.close();
         db.close();
+        im::Logger::shutdown();
         return 1;
     }
     
-    im::Logger::info("IM 服务器运行中，按 Ctrl+C 停止");
+    LOG_INFO("IM 服务器运行中，按 Ctrl+C 停止");
     server.run();
     
-    // 清理资源
+    if (g_signal != 0) {
+        LOG_INFO("收到信号 ", g_signal.load(), "，正在关闭服务器");
+    }
+    server.stop();
+    
+    // 清理资源：先执行完已排队的数据库请求，再写完待落盘的消息
+    dbExecutor.stop();
+    store.close();
     db.close();
+    im::Logger::shutdown();
     
     return 0;
 }
@@ -2,21 +2,74 @@
 #define DECODER_H
 
 #include "message.h"
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <queue>
 
 namespace im {
 
+/**
+ * 连续缓冲区解码器
+ *
+ * 缓冲区由读写游标划分为：[已消费 | 未消费（含已解码未释放的包）| 可写]。
+ * recv 直接写入可写区，解码只移动游标、不复制数据体；
+ * 只有在可写空间不足时才把未消费部分整体前移（均摊 O(n)）。
+ */
 class MessageDecoder {
 public:
+    // 协议头长度：magic(4) + type(2) + length(4)
+    static constexpr size_t HEADER_SIZE = ::im::HEADER_SIZE;
+
+    // 单个数据包体的最大长度，超过视为协议错误
+    static constexpr uint32_t MAX_PACKET_LENGTH = 16 << 20;
+
+    /**
+     * 确保可写空间至少为 minSize 字节（必要时整理或扩容）
+     *
+     * 注意：会使之前 nextPacket 返回的视图失效，调用前应先 consume
+     *
+     * @return 可写字节数
+     */
+    size_t prepareWrite(size_t minSize);
+
+    /**
+     * 可写区起始地址，recv 直接写入这里
+     */
+    uint8_t* writeData() { return buffer_.data() + writePos_; }
+
     /**
-     * 添加数据到缓冲区
-     * 
-     * @param data 接收到的数据
-     * @return 解码出的消息列表
+     * 提交 recv 写入的字节数
      */
-    std::queue<Packet> addData(const std::vector<uint8_t>& data);
-    
+    void commitWrite(size_t length) { writePos_ += length; }
+
+    /**
+     * 解码下一个完整的数据包
+     *
+     * @param packet 输出参数：数据包视图，data 指向内部缓冲区，在 consume() 之前有效
+     * @return 是否解码出完整数据包
+     */
+    bool nextPacket(PacketView& packet);
+
+    /**
+     * 释放已解码的数据包，之后其视图失效
+     */
+    void consume();
+
+    /**
+     * 缓冲区中尚未释放的字节数
+     */
+    size_t bufferedBytes() const { return writePos_ - readPos_; }
+
+    /**
+     * 是否发生无法恢复的协议错误（例如包长超限），调用方应断开连接
+     */
+    bool hasError() const { return error_; }
+
+    /**
+     * 没有残留数据时归还缓冲区内存
+     */
+    void releaseIfEmpty();
+
     /**
      * 清空缓冲区
      */
@@ -24,14 +77,13 @@ public:
 
 private:
     std::vector<uint8_t> buffer_;
-    
-    /**
-     * 解码消息
-     */
-    std::queue<Packet> decodeMessages();
+    size_t readPos_ = 0;     // 第一个未释放字节
+    size_t decodePos_ = 0;   // 下一个待解码字节
+    size_t writePos_ = 0;    // 第一个可写字节
+    int magicMismatchCount_ = 0;
+    bool error_ = false;
 };
 
 }  // namespace im
 
 #endif  // DECODER_H
-
@@ -4,32 +4,27 @@
 
 namespace im {
 
-std::vector<uint8_t> MessageEncoder::encode(MessageType type, const std::string& jsonData) {
-    std::vector<uint8_t> packet;
-    
+std::vector<uint8_t> MessageEncoder::encode(MessageType type, std::string_view jsonData) {
+    std::vector<uint8_t> packet(HEADER_SIZE + jsonData.size());
+    writeHeader(packet.data(), type, static_cast<uint32_t>(jsonData.size()));
+    if (!jsonData.empty()) {
+        std::memcpy(packet.data() + HEADER_SIZE, jsonData.data(), jsonData.size());
+    }
+    return packet;
+}
+
+void MessageEncoder::writeHeader(uint8_t* out, MessageType type, uint32_t length) {
     // Magic (4 bytes)
     uint32_t magic = htonl(MAGIC);
-    packet.insert(packet.end(), 
-                  reinterpret_cast<uint8_t*>(&magic),
-                  reinterpret_cast<uint8_t*>(&magic) + 4);
+    std::memcpy(out, &magic, 4);
     
     // Type (2 bytes)
     uint16_t msgType = htons(static_cast<uint16_t>(type));
-    packet.insert(packet.end(),
-                  reinterpret_cast<uint8_t*>(&msgType),
-                  reinterpret_cast<uint8_t*>(&msgType) + 2);
+    std::memcpy(out + 4, &msgType, 2);
     
     // Length (4 bytes)
-    uint32_t length = htonl(static_cast<uint32_t>(jsonData.length()));
-    packet.insert(packet.end(),
-                  reinterpret_cast<uint8_t*>(&length),
-                  reinterpret_cast<uint8_t*>(&length) + 4);
-    
-    // Data
-    packet.insert(packet.end(), jsonData.begin(), jsonData.end());
-    
-    return packet;
+    uint32_t netLength = htonl(length);
+    std::memcpy(out + 6, &netLength, 4);
 }
 
 }  // namespace im
-
@@ -2,10 +2,23 @@
 #define ENCODER_H
 
 #include "message.h"
+#include <memory>
+#include <string_view>
 #include <vector>
 
 namespace im {
 
+/**
+ * 编码完成的帧：不可变、引用计数
+ *
+ * 群消息/广播扇出时只编码一次，所有接收方的发送队列共享同一份字节
+ */
+using Frame = std::shared_ptr<const std::vector<uint8_t>>;
+
+inline Frame makeFrame(std::vector<uint8_t> bytes) {
+    return std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+}
+
 class MessageEncoder {
 public:
     /**
@@ -15,10 +28,16 @@ public:
      * @param jsonData JSON 数据
      * @return 编码后的字节数组
      */
-    static std::vector<uint8_t> encode(MessageType type, const std::string& jsonData);
+    static std::vector<uint8_t> encode(MessageType type, std::string_view jsonData);
+
+    /**
+     * 在 out 处写入 HEADER_SIZE 字节的协议头
+     *
+     * 供先预留协议头、再直接在帧缓冲区后面写数据体的调用方（如 JsonWriter）使用
+     */
+    static void writeHeader(uint8_t* out, MessageType type, uint32_t length);
 };
 
 }  // namespace im
 
 #endif  // ENCODER_H
-
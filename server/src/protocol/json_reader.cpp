@@ -0,0 +1,359 @@
+#include "json_reader.h"
+#include <charconv>
+#include <cstring>
+
+namespace im {
+
+namespace {
+
+void skipWhitespace(std::string_view json, size_t& pos) {
+    while (pos < json.size()) {
+        char c = json[pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        ++pos;
+    }
+}
+
+bool isNumberChar(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(std::string_view text, size_t pos, uint32_t& out) {
+    if (pos + 4 > text.size()) {
+        return false;
+    }
+    out = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        int v = hexValue(text[pos + i]);
+        if (v < 0) {
+            return false;
+        }
+        out = (out << 4) | static_cast<uint32_t>(v);
+    }
+    return true;
+}
+
+/**
+ * 扫描字符串：pos 指向起始引号，成功后指向结束引号之后；只校验转义序列，不解码
+ */
+bool scanString(std::string_view json, size_t& pos, std::string_view& raw, bool& escaped) {
+    size_t start = pos + 1;
+    size_t i = start;
+    escaped = false;
+    while (i < json.size()) {
+        // 大段普通字符直接跳到下一个引号或反斜杠
+        const char* base = json.data() + i;
+        size_t remain = json.size() - i;
+        const void* quote = std::memchr(base, '"', remain);
+        size_t limit = quote ? static_cast<size_t>(static_cast<const char*>(quote) - base) : remain;
+        const void* backslash = std::memchr(base, '\\', limit);
+        if (!backslash) {
+            if (!quote) {
+                return false;
+            }
+            raw = json.substr(start, i + limit - start);
+            pos = i + limit + 1;
+            return true;
+        }
+
+        i += static_cast<size_t>(static_cast<const char*>(backslash) - base) + 1;
+        if (i >= json.size()) {
+            return false;
+        }
+        escaped = true;
+        switch (json[i]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                ++i;
+                break;
+            case 'u': {
+                uint32_t code;
+                if (!readHex4(json, i + 1, code)) {
+                    return false;
+                }
+                i += 5;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * 跳过嵌套的对象或数组：pos 指向起始括号，成功后指向匹配的结束括号之后
+ */
+bool skipNested(std::string_view json, size_t& pos) {
+    char stack[JsonReader::MAX_DEPTH];
+    int depth = 0;
+    std::string_view raw;
+    bool escaped;
+    while (pos < json.size()) {
+        char c = json[pos];
+        switch (c) {
+            case '{':
+            case '[':
+                if (depth == JsonReader::MAX_DEPTH) {
+                    return false;
+                }
+                stack[depth++] = (c == '{') ? '}' : ']';
+                ++pos;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0 || stack[depth - 1] != c) {
+                    return false;
+                }
+                ++pos;
+                if (--depth == 0) {
+                    return true;
+                }
+                break;
+            case '"':
+                if (!scanString(json, pos, raw, escaped)) {
+                    return false;
+                }
+                break;
+            default:
+                ++pos;
+                break;
+        }
+    }
+    return false;
+}
+
+void appendUtf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+/**
+ * 解码已通过 scanString 校验的字符串内容
+ */
+void unescape(std::string_view raw, std::string& out) {
+    out.clear();
+    out.reserve(raw.size());
+    size_t i = 0;
+    while (i < raw.size()) {
+        size_t backslash = raw.find('\\', i);
+        if (backslash == std::string_view::npos) {
+            out.append(raw.substr(i));
+            return;
+        }
+        out.append(raw.substr(i, backslash - i));
+        char c = raw[backslash + 1];
+        i = backslash + 2;
+        switch (c) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                uint32_t code = 0;
+                readHex4(raw, i, code);
+                i += 4;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    // 代理对：高位后必须紧跟低位，否则按非法字符处理
+                    uint32_t low = 0;
+                    if (i + 6 <= raw.size() && raw[i] == '\\' && raw[i + 1] == 'u' &&
+                        readHex4(raw, i + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else {
+                        code = 0xFFFD;
+                    }
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    code = 0xFFFD;
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:  // '"' '\\' '/'
+                out.push_back(c);
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+bool JsonValue::parse(std::string_view json, size_t& pos, JsonValue& value) {
+    value = JsonValue();
+    if (pos >= json.size()) {
+        return false;
+    }
+    size_t start = pos;
+    char c = json[pos];
+    switch (c) {
+        case '"':
+            value.type_ = Type::STRING;
+            return scanString(json, pos, value.raw_, value.escaped_);
+        case '{':
+        case '[':
+            if (!skipNested(json, pos)) {
+                return false;
+            }
+            value.type_ = (c == '{') ? Type::OBJECT : Type::ARRAY;
+            value.raw_ = json.substr(start, pos - start);
+            return true;
+        case 't':
+        case 'f':
+        case 'n': {
+            std::string_view literal = (c == 't') ? "true" : (c == 'f') ? "false" : "null";
+            if (json.substr(pos, literal.size()) != literal) {
+                return false;
+            }
+            pos += literal.size();
+            value.type_ = (c == 'n') ? Type::NUL : Type::BOOL;
+            value.raw_ = literal;
+            return true;
+        }
+        default:
+            while (pos < json.size() && isNumberChar(json[pos])) {
+                ++pos;
+            }
+            if (pos == start) {
+                return false;
+            }
+            value.type_ = Type::NUMBER;
+            value.raw_ = json.substr(start, pos - start);
+            return true;
+    }
+}
+
+bool JsonValue::copyTo(std::string& out) const {
+    if (type_ == Type::STRING && escaped_) {
+        unescape(raw_, out);
+        return true;
+    }
+    if (type_ == Type::STRING || type_ == Type::NUMBER) {
+        out.assign(raw_.data(), raw_.size());
+        return true;
+    }
+    out.clear();
+    return false;
+}
+
+bool JsonValue::getInt(int64_t& out) const {
+    if ((type_ != Type::NUMBER && type_ != Type::STRING) || escaped_ || raw_.empty()) {
+        return false;
+    }
+    const char* end = raw_.data() + raw_.size();
+    auto result = std::from_chars(raw_.data(), end, out);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+bool JsonValue::getBool(bool& out) const {
+    if (type_ != Type::BOOL) {
+        return false;
+    }
+    out = (raw_ == "true");
+    return true;
+}
+
+JsonArrayReader::JsonArrayReader(const JsonValue& array) {
+    if (array.type() == JsonValue::Type::ARRAY) {
+        // raw 已包含首尾方括号且括号匹配
+        json_ = array.raw();
+        pos_ = 1;
+    } else {
+        finished_ = true;
+    }
+}
+
+bool JsonArrayReader::next(JsonValue& element) {
+    if (finished_ || error_) {
+        return false;
+    }
+    skipWhitespace(json_, pos_);
+    if (pos_ < json_.size() && json_[pos_] == ']') {
+        finished_ = true;
+        return false;
+    }
+    if (!first_) {
+        if (pos_ >= json_.size() || json_[pos_] != ',') {
+            error_ = true;
+            return false;
+        }
+        ++pos_;
+        skipWhitespace(json_, pos_);
+    }
+    first_ = false;
+    if (!JsonValue::parse(json_, pos_, element)) {
+        error_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool JsonReader::next(std::string_view& key, JsonValue& value) {
+    if (finished_ || error_) {
+        return false;
+    }
+    skipWhitespace(json_, pos_);
+    if (!started_) {
+        if (pos_ >= json_.size() || json_[pos_] != '{') {
+            error_ = true;
+            return false;
+        }
+        started_ = true;
+        ++pos_;
+        skipWhitespace(json_, pos_);
+        if (pos_ < json_.size() && json_[pos_] == '}') {
+            finished_ = true;
+            return false;
+        }
+    } else if (pos_ < json_.size() && json_[pos_] == ',') {
+        ++pos_;
+        skipWhitespace(json_, pos_);
+    } else if (pos_ < json_.size() && json_[pos_] == '}') {
+        finished_ = true;
+        return false;
+    } else {
+        error_ = true;
+        return false;
+    }
+
+    bool escaped = false;
+    if (pos_ >= json_.size() || json_[pos_] != '"' || !scanString(json_, pos_, key, escaped)) {
+        error_ = true;
+        return false;
+    }
+    skipWhitespace(json_, pos_);
+    if (pos_ >= json_.size() || json_[pos_] != ':') {
+        error_ = true;
+        return false;
+    }
+    ++pos_;
+    skipWhitespace(json_, pos_);
+    if (!JsonValue::parse(json_, pos_, value)) {
+        error_ = true;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace im
@@ -0,0 +1,135 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace im {
+
+/**
+ * JSON 值视图
+ *
+ * 只记录值在原始报文中的位置，不复制数据；视图在原始报文有效期内有效。
+ */
+class JsonValue {
+public:
+    enum class Type {
+        NONE,
+        STRING,
+        NUMBER,
+        BOOL,
+        NUL,
+        OBJECT,
+        ARRAY
+    };
+
+    Type type() const { return type_; }
+    bool isString() const { return type_ == Type::STRING; }
+    bool isArray() const { return type_ == Type::ARRAY; }
+
+    /**
+     * 原始文本：字符串为引号内未解码的内容，其他类型为值本身
+     */
+    std::string_view raw() const { return raw_; }
+
+    /**
+     * 解码后的字符串值写入 out（复用 out 已有容量）；数字按原始文本写入
+     *
+     * @return 是否为字符串或数字；其他类型时 out 被清空
+     */
+    bool copyTo(std::string& out) const;
+
+    /**
+     * 按整数读取，接受数字或只含数字的字符串（如 "123"）
+     */
+    bool getInt(int64_t& out) const;
+
+    bool getBool(bool& out) const;
+
+private:
+    friend class JsonReader;
+    friend class JsonArrayReader;
+
+    /**
+     * 从 pos 处解析一个值，成功后 pos 指向值之后
+     */
+    static bool parse(std::string_view json, size_t& pos, JsonValue& value);
+
+    Type type_ = Type::NONE;
+    std::string_view raw_;
+    bool escaped_ = false;  // 字符串中是否含转义序列，不含时可直接使用 raw_
+};
+
+/**
+ * 数组元素遍历器
+ *
+ * 用法：
+ *     JsonArrayReader array(value);
+ *     JsonValue element;
+ *     while (array.next(element)) { ... }
+ */
+class JsonArrayReader {
+public:
+    explicit JsonArrayReader(const JsonValue& array);
+
+    /**
+     * 取下一个元素；数组结束或格式错误时返回 false
+     */
+    bool next(JsonValue& element);
+
+    bool hasError() const { return error_; }
+
+private:
+    std::string_view json_;
+    size_t pos_ = 0;
+    bool first_ = true;
+    bool finished_ = false;
+    bool error_ = false;
+};
+
+/**
+ * 单遍、无内存分配的 JSON 对象读取器
+ *
+ * 顺序遍历顶层对象的成员，嵌套的对象/数组只定位其范围，按需再用
+ * JsonArrayReader 展开。处理器在一次遍历中按键名取出自己需要的字段：
+ *
+ *     JsonReader reader(jsonData);
+ *     std::string_view key;
+ *     JsonValue value;
+ *     while (reader.next(key, value)) {
+ *         if (key == "username") value.copyTo(username);
+ *     }
+ */
+class JsonReader {
+public:
+    // 嵌套深度上限，超过视为格式错误
+    static constexpr int MAX_DEPTH = 32;
+
+    explicit JsonReader(std::string_view json) : json_(json) {}
+
+    /**
+     * 取顶层对象的下一个成员
+     *
+     * @param key 成员名（未解码的原始文本）
+     * @return 是否取到成员；对象结束或格式错误时返回 false
+     */
+    bool next(std::string_view& key, JsonValue& value);
+
+    /**
+     * 报文是否不是合法的 JSON 对象
+     */
+    bool hasError() const { return error_; }
+
+private:
+    std::string_view json_;
+    size_t pos_ = 0;
+    bool started_ = false;
+    bool finished_ = false;
+    bool error_ = false;
+};
+
+}  // namespace im
+
+#endif  // JSON_READER_H
@@ -0,0 +1,180 @@
+#include "json_writer.h"
+#include "encoder.h"
+#include <charconv>
+#include <cstring>
+
+namespace im {
+
+namespace {
+
+constexpr uint64_t ONES = 0x0101010101010101ULL;
+constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+
+// 8 字节中是否有字节为 0
+inline uint64_t hasZeroByte(uint64_t v) {
+    return (v - ONES) & ~v & HIGHS;
+}
+
+// 8 字节中是否有需要转义的字节：'"'、'\\' 或小于 0x20 的控制字符
+inline bool needsEscape(uint64_t v) {
+    uint64_t quote = hasZeroByte(v ^ (ONES * '"'));
+    uint64_t backslash = hasZeroByte(v ^ (ONES * '\\'));
+    uint64_t control = (v - ONES * 0x20) & ~v & HIGHS;
+    return (quote | backslash | control) != 0;
+}
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+}  // namespace
+
+JsonWriter::JsonWriter(MessageType type, size_t reserveBytes) : type_(type) {
+    buffer_.reserve(HEADER_SIZE + reserveBytes);
+    buffer_.resize(HEADER_SIZE);  // 预留协议头，finish() 时回填
+}
+
+void JsonWriter::separate() {
+    if (needComma_) {
+        buffer_.push_back(',');
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separate();
+    buffer_.push_back('{');
+    needComma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    buffer_.push_back('}');
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separate();
+    buffer_.push_back('[');
+    needComma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    buffer_.push_back(']');
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separate();
+    buffer_.push_back('"');
+    append(name);
+    buffer_.push_back('"');
+    buffer_.push_back(':');
+    needComma_ = false;  // 紧跟的值不需要逗号
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separate();
+    buffer_.push_back('"');
+    appendEscaped(buffer_, text);
+    buffer_.push_back('"');
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    return rawValue(flag ? "true" : "false");
+}
+
+JsonWriter& JsonWriter::value(std::nullptr_t) {
+    return rawValue("null");
+}
+
+JsonWriter& JsonWriter::writeSigned(long long number) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), number);
+    return rawValue(std::string_view(buf, static_cast<size_t>(result.ptr - buf)));
+}
+
+JsonWriter& JsonWriter::writeUnsigned(unsigned long long number) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), number);
+    return rawValue(std::string_view(buf, static_cast<size_t>(result.ptr - buf)));
+}
+
+JsonWriter& JsonWriter::rawValue(std::string_view json) {
+    separate();
+    append(json);
+    needComma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::fieldOrNull(std::string_view name, std::string_view text) {
+    key(name);
+    return text.empty() ? value(nullptr) : value(text);
+}
+
+std::string_view JsonWriter::body() const {
+    return std::string_view(reinterpret_cast<const char*>(buffer_.data()) + HEADER_SIZE,
+                            buffer_.size() - HEADER_SIZE);
+}
+
+std::vector<uint8_t> JsonWriter::finish() {
+    MessageEncoder::writeHeader(buffer_.data(), type_, static_cast<uint32_t>(buffer_.size() - HEADER_SIZE));
+    return std::move(buffer_);
+}
+
+void JsonWriter::appendEscaped(std::vector<uint8_t>& out, std::string_view text) {
+    const char* data = text.data();
+    size_t size = text.size();
+    size_t i = 0;
+    size_t clean = 0;  // [clean, i) 为尚未写出的无需转义的字节
+
+    while (i < size) {
+        // 快速路径：整 8 字节都无需转义时只移动游标
+        if (size - i >= 8) {
+            uint64_t chunk;
+            std::memcpy(&chunk, data + i, 8);
+            if (!needsEscape(chunk)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        // 慢速路径：逐字节处理当前块（或尾部不足 8 字节的部分）
+        size_t end = (size - i >= 8) ? i + 8 : size;
+        for (; i < end; ++i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            out.insert(out.end(), data + clean, data + i);
+            clean = i + 1;
+            char escaped[6] = {'\\', 0, 0, 0, 0, 0};
+            size_t length = 2;
+            switch (c) {
+                case '"':  escaped[1] = '"'; break;
+                case '\\': escaped[1] = '\\'; break;
+                case '\b': escaped[1] = 'b'; break;
+                case '\f': escaped[1] = 'f'; break;
+                case '\n': escaped[1] = 'n'; break;
+                case '\r': escaped[1] = 'r'; break;
+                case '\t': escaped[1] = 't'; break;
+                default:
+                    // 其余控制字符转义为 \u00XX
+                    escaped[1] = 'u';
+                    escaped[2] = '0';
+                    escaped[3] = '0';
+                    escaped[4] = HEX_DIGITS[c >> 4];
+                    escaped[5] = HEX_DIGITS[c & 0xF];
+                    length = 6;
+                    break;
+            }
+            out.insert(out.end(), escaped, escaped + length);
+        }
+    }
+    out.insert(out.end(), data + clean, data + size);
+}
+
+}  // namespace im
@@ -0,0 +1,101 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include "message.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace im {
+
+/**
+ * 流式 JSON 写入器
+ *
+ * 数据体直接写在帧缓冲区中预留的协议头之后，finish() 回填协议头后整体交给发送队列，
+ * 不再经过 std::string / MessageEncoder 复制。逗号由写入器自动插入。
+ *
+ * 用法：
+ *     JsonWriter writer(MessageType::FRIEND_LIST_RESPONSE);
+ *     writer.beginObject().field("success", true).key("friends").beginArray();
+ *     ...
+ *     writer.endArray().endObject();
+ *     server.sendFrame(fd, writer.finish());
+ *
+ * 键名应为固定的 ASCII 标识符，按原样写出不做转义。
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(MessageType type, size_t reserveBytes = 256);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(std::nullptr_t);
+
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, JsonWriter&> value(T number) {
+        if constexpr (std::is_signed_v<T>) {
+            return writeSigned(static_cast<long long>(number));
+        } else {
+            return writeUnsigned(static_cast<unsigned long long>(number));
+        }
+    }
+
+    /**
+     * 写入已经是合法 JSON 的片段
+     */
+    JsonWriter& rawValue(std::string_view json);
+
+    template <typename T>
+    JsonWriter& field(std::string_view name, const T& v) {
+        key(name);
+        return value(v);
+    }
+
+    /**
+     * 字符串为空时写 null，否则写字符串
+     */
+    JsonWriter& fieldOrNull(std::string_view name, std::string_view text);
+
+    /**
+     * 已写入的数据体（用于日志）
+     */
+    std::string_view body() const;
+
+    /**
+     * 回填协议头并返回完整帧，之后写入器不可再使用
+     */
+    std::vector<uint8_t> finish();
+
+    /**
+     * 按 JSON 规则转义 text 并追加到 out（不含引号）
+     *
+     * 每次检查 8 字节，整段不含需转义字符时直接整块复制
+     */
+    static void appendEscaped(std::vector<uint8_t>& out, std::string_view text);
+
+private:
+    void separate();
+    void append(std::string_view text) { buffer_.insert(buffer_.end(), text.begin(), text.end()); }
+    JsonWriter& writeSigned(long long number);
+    JsonWriter& writeUnsigned(unsigned long long number);
+
+    MessageType type_;
+    std::vector<uint8_t> buffer_;
+    bool needComma_ = false;  // 下一个值或键之前是否需要逗号
+};
+
+}  // namespace im
+
+#endif  // JSON_WRITER_H
@@ -1,8 +1,10 @@
 #ifndef MESSAGE_H
 #define MESSAGE_H
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace im {
 
@@ -67,18 +69,29 @@ enum class MessageType : uint16_t {
 
     GROUP_UPDATE_INFO_REQUEST  = 0x0212,  // 更新群信息（群名/公告等）
     GROUP_UPDATE_INFO_RESPONSE = 0x0213,  // 更新群信息结果
-    GROUP_UPDATE_INFO_NOTIFY   = 0x0214   // 更新群信息通知
+    GROUP_UPDATE_INFO_NOTIFY   = 0x0214,  // 更新群信息通知
+
+    // 消息同步
+    OFFLINE_SYNC_REQUEST   = 0x0300,  // 拉取离线消息（可带上次收到的序号）
+    OFFLINE_SYNC_RESPONSE  = 0x0301,  // 离线消息分页（登录后也会主动推送第一页）
+    HISTORY_REQUEST        = 0x0302,  // 按会话向前拉取历史消息
+    HISTORY_RESPONSE       = 0x0303,  // 历史消息分页
+    SEND_MESSAGE_ACK       = 0x0304,  // 发送确认（给发送方，带 client_msg_id 与 msg_id）
+    DELIVERY_ACK           = 0x0305,  // 投递确认（接收方收到 RECEIVE_MESSAGE 后回复 msg_id）
+
+    // 在线状态
+    PRESENCE_NOTIFY        = 0x0400   // 好友/同群成员上线、下线（合并窗口内的变化，取代轮询 USER_LIST_REQUEST）
 };
 
 // 协议常量
 constexpr uint32_t MAGIC = 0x494D494D;  // "IMIM"
+constexpr size_t HEADER_SIZE = 10;      // magic(4) + type(2) + length(4)
 
-// 数据包结构
-struct Packet {
-    uint32_t magic;
+// 数据包视图：data 指向解码器缓冲区，不持有数据
+struct PacketView {
     MessageType type;
     uint32_t length;
-    std::string data;
+    std::string_view data;
 };
 
 }  // namespace im
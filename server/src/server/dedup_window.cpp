@@ -0,0 +1,51 @@
+#include "dedup_window.h"
+#include <algorithm>
+
+namespace im {
+
+DedupWindow::DedupWindow(std::chrono::seconds ttl, size_t capacity)
+    : ttl_(ttl), shardCapacity_(std::max<size_t>(capacity / SHARD_COUNT, 1)) {}
+
+std::string DedupWindow::makeKey(const std::string& senderId, const std::string& clientMsgId) {
+    std::string key;
+    key.reserve(senderId.size() + 1 + clientMsgId.size());
+    key.append(senderId).push_back('\0');
+    key.append(clientMsgId);
+    return key;
+}
+
+uint64_t DedupWindow::insertIfAbsent(const std::string& senderId, const std::string& clientMsgId,
+                                     uint64_t msgId) {
+    std::string key = makeKey(senderId, clientMsgId);
+    Shard& shard = shards_[shardOf(key)];
+    auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    expire(shard, now);
+    auto result = shard.entries.try_emplace(key, msgId);
+    if (!result.second) {
+        return result.first->second;
+    }
+    shard.order.emplace_back(std::move(key), now + ttl_);
+    return 0;
+}
+
+void DedupWindow::expire(Shard& shard, Clock::time_point now) {
+    // 队头最早写入：过期或超出容量时出队，最多处理到第一个仍有效的条目
+    while (!shard.order.empty() &&
+           (shard.order.front().second <= now || shard.order.size() >= shardCapacity_)) {
+        shard.entries.erase(shard.order.front().first);
+        shard.order.pop_front();
+    }
+}
+
+size_t DedupWindow::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+}  // namespace im
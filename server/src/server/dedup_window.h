@@ -0,0 +1,64 @@
+#ifndef DEDUP_WINDOW_H
+#define DEDUP_WINDOW_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace im {
+
+/**
+ * 发送去重窗口：(发送者, client_msg_id) -> 服务端分配的 msg_id
+ *
+ * 客户端断线重连后重发同一条消息时，按 client_msg_id 识别出来，
+ * 只回确认、不再转发。条目按写入顺序排队，固定有效期，过期或超出容量时
+ * 从队头淘汰，查找、写入、淘汰都是 O(1)。按键哈希分片，每个分片一把锁。
+ */
+class DedupWindow {
+public:
+    static constexpr size_t SHARD_COUNT = 16;  // 必须是 2 的幂
+    static constexpr std::chrono::seconds DEFAULT_TTL{300};
+    static constexpr size_t DEFAULT_CAPACITY = 200000;
+
+    explicit DedupWindow(std::chrono::seconds ttl = DEFAULT_TTL, size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * 记录一次发送；窗口内已有相同键时不覆盖
+     *
+     * @param msgId 本次分配的 msg_id
+     * @return 窗口内已有的 msg_id（重复发送），或 0 表示首次发送、已记录
+     */
+    uint64_t insertIfAbsent(const std::string& senderId, const std::string& clientMsgId, uint64_t msgId);
+
+    size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, uint64_t> entries;  // 键 -> msg_id
+        // 写入顺序即过期顺序
+        std::deque<std::pair<std::string, Clock::time_point>> order;
+    };
+
+    static std::string makeKey(const std::string& senderId, const std::string& clientMsgId);
+    static size_t shardOf(const std::string& key) {
+        return std::hash<std::string>()(key) & (SHARD_COUNT - 1);
+    }
+
+    void expire(Shard& shard, Clock::time_point now);
+
+    std::chrono::seconds ttl_;
+    size_t shardCapacity_;
+    std::array<Shard, SHARD_COUNT> shards_;
+};
+
+}  // namespace im
+
+#endif  // DEDUP_WINDOW_H
@@ -0,0 +1,104 @@
+#include "delivery_tracker.h"
+#include <algorithm>
+
+namespace im {
+
+void DeliveryTracker::track(const std::string& userId, uint64_t msgId, Frame frame) {
+    Shard& shard = shards_[shardOf(userId)];
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& items = shard.users[userId];
+    expire(items, now);
+    if (items.size() >= MAX_PER_USER) {
+        items.pop_front();
+    }
+    items.push_back(Item{msgId, std::move(frame), now});
+}
+
+bool DeliveryTracker::ack(const std::string& userId, uint64_t msgId) {
+    Shard& shard = shards_[shardOf(userId)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    if (it == shard.users.end()) {
+        return false;
+    }
+    auto& items = it->second;
+    // 通常按投递顺序确认，先看队头
+    auto item = (!items.empty() && items.front().msgId == msgId)
+                    ? items.begin()
+                    : std::find_if(items.begin(), items.end(), [msgId](const Item& i) { return i.msgId == msgId; });
+    if (item == items.end()) {
+        return false;
+    }
+    items.erase(item);
+    if (items.empty()) {
+        shard.users.erase(it);
+    }
+    return true;
+}
+
+std::vector<Frame> DeliveryTracker::pending(const std::string& userId) {
+    Shard& shard = shards_[shardOf(userId)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    if (it == shard.users.end()) {
+        return {};
+    }
+    expire(it->second, Clock::now());
+    if (it->second.empty()) {
+        shard.users.erase(it);
+        return {};
+    }
+    std::vector<Frame> frames;
+    frames.reserve(it->second.size());
+    for (const Item& item : it->second) {
+        frames.push_back(item.frame);
+    }
+    return frames;
+}
+
+Frame DeliveryTracker::find(const std::string& userId, uint64_t msgId) {
+    Shard& shard = shards_[shardOf(userId)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    if (it == shard.users.end()) {
+        return nullptr;
+    }
+    expire(it->second, Clock::now());
+    for (const Item& item : it->second) {
+        if (item.msgId == msgId) {
+            return item.frame;
+        }
+    }
+    return nullptr;
+}
+
+void DeliveryTracker::expire(std::deque<Item>& items, Clock::time_point now) {
+    while (!items.empty() && now - items.front().sentAt >= TTL) {
+        items.pop_front();
+    }
+}
+
+void DeliveryTracker::sweep() {
+    auto now = Clock::now();
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.users.begin(); it != shard.users.end();) {
+            expire(it->second, now);
+            it = it->second.empty() ? shard.users.erase(it) : std::next(it);
+        }
+    }
+}
+
+size_t DeliveryTracker::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [userId, items] : shard.users) {
+            total += items.size();
+        }
+    }
+    return total;
+}
+
+}  // namespace im
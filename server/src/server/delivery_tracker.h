@@ -0,0 +1,88 @@
+#ifndef DELIVERY_TRACKER_H
+#define DELIVERY_TRACKER_H
+
+#include "protocol/encoder.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace im {
+
+/**
+ * 待确认投递：已推给在线用户、尚未收到 DELIVERY_ACK 的消息帧
+ *
+ * 连接在消息写出前后断开时，帧可能还在发送队列里或已被对端丢弃；
+ * 用户重新登录后把仍未确认的帧按原顺序重发，客户端按 msg_id 去重。
+ * 帧与其他接收方共享，这里只多持有一个引用。每个用户最多保留
+ * MAX_PER_USER 条，超过有效期的不再重发（消息仍可从历史记录拉取）。
+ */
+class DeliveryTracker {
+public:
+    static constexpr size_t SHARD_COUNT = 64;  // 必须是 2 的幂
+    static constexpr size_t MAX_PER_USER = 256;
+    static constexpr std::chrono::seconds TTL{600};
+
+    /**
+     * 记录一条已投递、待确认的消息
+     */
+    void track(const std::string& userId, uint64_t msgId, Frame frame);
+
+    /**
+     * 客户端确认收到，删除记录
+     *
+     * @return 是否找到该消息
+     */
+    bool ack(const std::string& userId, uint64_t msgId);
+
+    /**
+     * 取出仍未确认且未过期的帧（按投递顺序），用于重连后重发；记录保留到确认为止
+     */
+    std::vector<Frame> pending(const std::string& userId);
+
+    /**
+     * 取出单条仍未确认且未过期的帧，用于确认超时后的重发；已确认或已过期返回空
+     */
+    Frame find(const std::string& userId, uint64_t msgId);
+
+    /**
+     * 清理所有用户的过期记录（不再上线的用户不会触发 track/pending，需要定期调用）
+     */
+    void sweep();
+
+    /**
+     * 待确认消息总数
+     */
+    size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Item {
+        uint64_t msgId;
+        Frame frame;
+        Clock::time_point sentAt;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::deque<Item>> users;
+    };
+
+    static size_t shardOf(const std::string& userId) {
+        return std::hash<std::string>()(userId) & (SHARD_COUNT - 1);
+    }
+
+    static void expire(std::deque<Item>& items, Clock::time_point now);
+
+    std::array<Shard, SHARD_COUNT> shards_;
+};
+
+}  // namespace im
+
+#endif  // DELIVERY_TRACKER_H
@@ -0,0 +1,196 @@
+#include "dispatcher.h"
+#include "server/epoll_server.h"
+#include "handler/login_handler.h"
+#include "handler/message_handler.h"
+#include "handler/user_handler.h"
+#include "handler/friend_handler.h"
+#include "handler/group_handler.h"
+#include "handler/offline_handler.h"
+#include "handler/history_handler.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+namespace im {
+
+namespace {
+
+using RouteTable = std::array<Dispatcher::Route, Dispatcher::TABLE_SIZE>;
+
+int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * 混在业务包中、由工作线程处理的心跳（单独到达的心跳在 Reactor 线程直接应答）
+ */
+void handleHeartbeat(EpollServer& server, const Session& session, std::string_view /*jsonData*/) {
+    std::string heartbeatResponse = R"({"timestamp":)" + std::to_string(time(nullptr)) + "}";
+    server.sendMessage(session.fd, MessageType::HEARTBEAT_RESPONSE, heartbeatResponse);
+    LOG_DEBUG("[心跳处理] 心跳响应已提交: fd=", session.fd);
+}
+
+void handleLogout(EpollServer& server, const Session& session, std::string_view /*jsonData*/) {
+    server.closeConnection(session.fd);
+}
+
+constexpr RouteTable buildRoutes() {
+    RouteTable table{};
+    auto add = [&table](MessageType type, Dispatcher::Handler handler, uint8_t flags) {
+        table[Dispatcher::indexOf(static_cast<uint16_t>(type))] = Dispatcher::Route{handler, flags};
+    };
+    constexpr uint8_t AUTH = Dispatcher::REQUIRE_AUTH;
+    constexpr uint8_t DB = Dispatcher::DATABASE;
+
+    add(MessageType::LOGIN_REQUEST, &LoginHandler::handle, DB);
+    add(MessageType::REGISTER_REQUEST, &LoginHandler::handleRegister, DB);
+    add(MessageType::HEARTBEAT, &handleHeartbeat, Dispatcher::UNLIMITED);
+    add(MessageType::LOGOUT, &handleLogout, Dispatcher::UNLIMITED);
+    add(MessageType::USER_LIST_REQUEST, &UserHandler::handleUserList, AUTH);
+
+    add(MessageType::SEND_MESSAGE, &MessageHandler::handle, AUTH);
+    add(MessageType::DELIVERY_ACK, &MessageHandler::handleDeliveryAck,
+        AUTH | Dispatcher::QUIET | Dispatcher::UNLIMITED);
+
+    add(MessageType::FRIEND_APPLY_REQUEST, &FriendHandler::handleApply, AUTH | DB);
+    add(MessageType::FRIEND_HANDLE_REQUEST, &FriendHandler::handleApplyAction, AUTH | DB);
+    add(MessageType::FRIEND_LIST_REQUEST, &FriendHandler::handleFriendList, AUTH | DB);
+    add(MessageType::FRIEND_DELETE_REQUEST, &FriendHandler::handleDelete, AUTH | DB);
+    add(MessageType::FRIEND_BLOCK_REQUEST, &FriendHandler::handleBlock, AUTH | DB);
+
+    add(MessageType::GROUP_CREATE_REQUEST, &GroupHandler::handleCreate, AUTH | DB);
+    add(MessageType::GROUP_LIST_REQUEST, &GroupHandler::handleGroupList, AUTH | DB);
+    add(MessageType::GROUP_MEMBER_LIST_REQUEST, &GroupHandler::handleMemberList, AUTH | DB);
+    add(MessageType::GROUP_INVITE_REQUEST, &GroupHandler::handleInvite, AUTH | DB);
+    add(MessageType::GROUP_KICK_REQUEST, &GroupHandler::handleKick, AUTH | DB);
+    add(MessageType::GROUP_QUIT_REQUEST, &GroupHandler::handleQuit, AUTH | DB);
+    add(MessageType::GROUP_DISMISS_REQUEST, &GroupHandler::handleDismiss, AUTH | DB);
+    add(MessageType::GROUP_UPDATE_INFO_REQUEST, &GroupHandler::handleUpdateInfo, AUTH | DB);
+
+    add(MessageType::OFFLINE_SYNC_REQUEST, &OfflineHandler::handleSync, AUTH);
+    add(MessageType::HISTORY_REQUEST, &HistoryHandler::handle, AUTH | DB);
+    return table;
+}
+
+constexpr RouteTable ROUTES = buildRoutes();
+
+}  // namespace
+
+const Dispatcher::Route* Dispatcher::find(uint16_t type) {
+    size_t index = indexOf(type);
+    if (index >= TABLE_SIZE || !ROUTES[index].handler) {
+        return nullptr;
+    }
+    return &ROUTES[index];
+}
+
+void Dispatcher::use(Middleware middleware) {
+    middleware_.push_back(std::move(middleware));
+}
+
+void Dispatcher::setDatabaseExecutor(DatabaseExecutor executor) {
+    databaseExecutor_ = std::move(executor);
+}
+
+void Dispatcher::dispatch(EpollServer& server, Session& session, const PacketView& packet) {
+    uint16_t type = static_cast<uint16_t>(packet.type);
+    const Route* route = find(type);
+    if (!route) {
+        LOG_WARN("未知消息类型: " + std::to_string(type));
+        return;
+    }
+    Counter& counter = counters_[indexOf(type)];
+
+    for (const auto& middleware : middleware_) {
+        if (!middleware(server, session, packet.type, *route)) {
+            counter.rejected.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    if ((route->flags & DATABASE) && databaseExecutor_) {
+        // 数据体视图在本函数返回后即失效，交给数据库线程前拷贝；处理器只读会话，取快照即可
+        Task job = [this, &server, route, &counter, snapshot = Session(session),
+                    data = std::string(packet.data)] {
+            invoke(server, snapshot, *route, data, counter);
+        };
+        if (!databaseExecutor_(session, std::move(job))) {
+            counter.rejected.fetch_add(1, std::memory_order_relaxed);
+            if (!(route->flags & QUIET)) {
+                server.sendMessage(session.fd, MessageType::ERROR,
+                                   R"({"error_code":1006,"error_message":"服务器繁忙"})");
+            }
+            LOG_WARN("[消息分发] 数据库执行器繁忙，已拒绝: fd=", session.fd, ", type=", type);
+        }
+        return;
+    }
+
+    // 数据体视图指向接收缓冲区，处理器返回前（consume 之前）有效
+    invoke(server, session, *route, packet.data, counter);
+}
+
+void Dispatcher::invoke(EpollServer& server, const Session& session, const Route& route, std::string_view data,
+                        Counter& counter) {
+    auto start = std::chrono::steady_clock::now();
+    route.handler(server, session, data);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    counter.handled.fetch_add(1, std::memory_order_relaxed);
+    counter.totalMicros.fetch_add(elapsed.count(), std::memory_order_relaxed);
+}
+
+std::vector<Dispatcher::TypeStats> Dispatcher::getStats() const {
+    std::vector<TypeStats> result;
+    for (size_t index = 0; index < TABLE_SIZE; ++index) {
+        const Counter& counter = counters_[index];
+        uint64_t handled = counter.handled.load(std::memory_order_relaxed);
+        uint64_t rejected = counter.rejected.load(std::memory_order_relaxed);
+        if (handled == 0 && rejected == 0) {
+            continue;
+        }
+        uint16_t type = static_cast<uint16_t>(((index >> 6) << 8) | (index & 0x3F));
+        result.push_back({type, handled, rejected, counter.totalMicros.load(std::memory_order_relaxed)});
+    }
+    return result;
+}
+
+bool Dispatcher::requireAuth(EpollServer& server, Session& session, MessageType /*type*/, const Route& route) {
+    if (!(route.flags & REQUIRE_AUTH) || session.authenticated) {
+        return true;
+    }
+    if (!(route.flags & QUIET)) {
+        server.sendMessage(session.fd, MessageType::ERROR,
+                           R"({"error_code":1001,"error_message":"请先登录"})");
+    }
+    return false;
+}
+
+Dispatcher::Middleware Dispatcher::rateLimit(uint32_t perSecond, uint32_t burst) {
+    double capacity = std::max(burst, perSecond);
+    return [perSecond, capacity](EpollServer& server, Session& session, MessageType type, const Route& route) {
+        if (route.flags & UNLIMITED) {
+            return true;
+        }
+        int64_t now = steadyMs();
+        if (session.rateRefillMs == 0) {
+            session.rateTokens = capacity;
+        } else {
+            session.rateTokens = std::min(capacity, session.rateTokens +
+                                                        (now - session.rateRefillMs) * perSecond / 1000.0);
+        }
+        session.rateRefillMs = now;
+        if (session.rateTokens >= 1) {
+            session.rateTokens -= 1;
+            return true;
+        }
+        if (!(route.flags & QUIET)) {
+            server.sendMessage(session.fd, MessageType::ERROR,
+                               R"({"error_code":1005,"error_message":"请求过于频繁"})");
+        }
+        LOG_DEBUG("[限流] 请求过于频繁，已拒绝: fd=", session.fd, ", type=", static_cast<uint16_t>(type));
+        return false;
+    };
+}
+
+}  // namespace im
@@ -0,0 +1,123 @@
+#ifndef DISPATCHER_H
+#define DISPATCHER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "protocol/message.h"
+#include "server/session.h"
+#include "thread_pool/task.h"
+
+namespace im {
+
+class EpollServer;
+
+/**
+ * 消息分发：按消息类型查编译期生成的路由表，依次执行中间件后调用处理器
+ *
+ * 路由表按 (类型高字节, 类型低字节) 压成 16 x 64 的稠密数组，查找就是一次下标运算。
+ * 中间件（登录校验、限流等）只读写传入的 Session，不再按 fd 查连接、不加锁；
+ * 各类型的处理次数、拦截次数与耗时用原子计数累加，统计日志定期输出。
+ *
+ * 标记 DATABASE 的路由不在当前线程执行：数据体拷贝、会话取快照后交给数据库执行器，
+ * 执行器繁忙时回 1006。
+ */
+class Dispatcher {
+public:
+    using Handler = void (*)(EpollServer& server, const Session& session, std::string_view jsonData);
+
+    // 路由标志
+    static constexpr uint8_t REQUIRE_AUTH = 1 << 0;  // 需要先登录
+    static constexpr uint8_t QUIET = 1 << 1;         // 被拦截时不回错误（如投递确认）
+    static constexpr uint8_t UNLIMITED = 1 << 2;     // 不计入限流（心跳、登出、投递确认）
+    static constexpr uint8_t DATABASE = 1 << 3;      // 访问数据库，交给数据库执行器执行
+
+    struct Route {
+        Handler handler = nullptr;
+        uint8_t flags = 0;
+    };
+
+    /**
+     * 中间件：按注册顺序在处理器之前执行，返回 false 表示拦截（需要回错误时由中间件自己发送）
+     */
+    using Middleware = std::function<bool(EpollServer& server, Session& session, MessageType type,
+                                          const Route& route)>;
+
+    /**
+     * 数据库执行器：接收 DATABASE 路由的处理任务，无法受理（队列已满）时返回 false
+     */
+    using DatabaseExecutor = std::function<bool(Session& session, Task job)>;
+
+    struct TypeStats {
+        uint16_t type;
+        uint64_t handled;      // 交给处理器的次数
+        uint64_t rejected;     // 被中间件拦截的次数
+        uint64_t totalMicros;  // 处理器累计耗时
+    };
+
+    static constexpr size_t TABLE_SIZE = 16 * 64;
+
+    /**
+     * 类型在路由表中的下标，超出范围返回 TABLE_SIZE
+     */
+    static constexpr size_t indexOf(uint16_t type) {
+        return ((type >> 8) < 16 && (type & 0xFF) < 64) ? ((type >> 8) << 6) | (type & 0xFF) : TABLE_SIZE;
+    }
+
+    /**
+     * 查路由，未注册的类型返回 nullptr
+     */
+    static const Route* find(uint16_t type);
+
+    /**
+     * 注册中间件（需在服务器启动之前调用）
+     */
+    void use(Middleware middleware);
+
+    /**
+     * 设置数据库执行器（需在服务器启动之前调用），未设置时 DATABASE 路由在当前线程执行
+     */
+    void setDatabaseExecutor(DatabaseExecutor executor);
+
+    /**
+     * 分发一个数据包（在处理该连接的工作线程中调用）
+     */
+    void dispatch(EpollServer& server, Session& session, const PacketView& packet);
+
+    /**
+     * 有过处理或拦截记录的消息类型统计
+     */
+    std::vector<TypeStats> getStats() const;
+
+    /**
+     * 登录校验：REQUIRE_AUTH 的路由未登录时回 1001（QUIET 的路由直接丢弃）
+     */
+    static bool requireAuth(EpollServer& server, Session& session, MessageType type, const Route& route);
+
+    /**
+     * 按连接限流（令牌桶）：每秒补充 perSecond 个，最多积攒 burst 个，超出时回 1005
+     */
+    static Middleware rateLimit(uint32_t perSecond, uint32_t burst);
+
+private:
+    struct Counter {
+        std::atomic<uint64_t> handled{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> totalMicros{0};
+    };
+
+    void invoke(EpollServer& server, const Session& session, const Route& route, std::string_view data,
+                Counter& counter);
+
+    std::vector<Middleware> middleware_;
+    DatabaseExecutor databaseExecutor_;
+    std::array<Counter, TABLE_SIZE> counters_;
+};
+
+}  // namespace im
+
+#endif  // DISPATCHER_H
@@ -1,10 +1,9 @@
 #include "epoll_server.h"
 #include "protocol/encoder.h"
-#include "handler/login_handler.h"
-#include "handler/message_handler.h"
-#include "handler/user_handler.h"
-#include "handler/friend_handler.h"
-#include "handler/group_handler.h"
+#include "database/database.h"
+#include "database/db_executor.h"
+#include "database/group_roster_cache.h"
+#include "store/message_store.h"
 #include "utils/logger.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -12,35 +11,124 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <chrono>
 #include <cstring>
-#include <iostream>
 #include <ctime>
 #include <vector>
 #include <errno.h>
 
 namespace im {
 
-EpollServer::EpollServer(int port) 
-    : port_(port), serverFd_(-1), epollFd_(-1), running_(false) {
+namespace {
+
+// 统计日志输出间隔（秒）
+constexpr int STATS_LOG_INTERVAL = 60;
+
+// fd 索引表的上限，防止 RLIMIT_NOFILE 为 unlimited 时分配过大
+constexpr size_t MAX_FD_OWNER_CAPACITY = 1 << 22;
+
+// 连接读缓冲区初始大小与上限（到达上限时先交给解码器再继续读取）
+constexpr size_t INITIAL_READ_BUFFER_SIZE = 4096;
+constexpr size_t MAX_READ_BUFFER_SIZE = 1 << 20;
+
+// 发送队列水位：超过高水位暂停读取，降到低水位以下恢复，超过上限判定为慢客户端并断开
+constexpr size_t OUTPUT_HIGH_WATERMARK = 1 << 20;
+constexpr size_t OUTPUT_LOW_WATERMARK = 256 * 1024;
+constexpr size_t OUTPUT_HARD_LIMIT = 8 << 20;
+
+// 单次 writev 最多合并的帧数
+constexpr int MAX_WRITE_IOVECS = 64;
+
+// 默认连接超时：客户端每 30 秒发一次心跳，连续丢 3 次判定为死连接
+constexpr std::chrono::seconds DEFAULT_HEARTBEAT_TIMEOUT{90};
+constexpr std::chrono::seconds DEFAULT_LOGIN_TIMEOUT{30};
+
+// epoll_wait 的最长等待（毫秒），时间轮有定时器时缩短到下一个刻度
+constexpr int MAX_WAIT_MS = 1000;
+
+int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 从编码好的帧中取消息类型与数据体（用于日志），调用方保证帧长度不小于协议头
+uint16_t frameType(const std::vector<uint8_t>& frame) {
+    uint16_t type;
+    std::memcpy(&type, frame.data() + 4, sizeof(type));
+    return ntohs(type);
+}
+
+std::string_view frameBody(const std::vector<uint8_t>& frame) {
+    return std::string_view(reinterpret_cast<const char*>(frame.data()) + HEADER_SIZE,
+                            frame.size() - HEADER_SIZE);
+}
+
+size_t fdCapacity() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+        return MAX_FD_OWNER_CAPACITY;
+    }
+    return std::min(static_cast<size_t>(limit.rlim_cur), MAX_FD_OWNER_CAPACITY);
+}
+
+}  // namespace
+
+EpollServer::EpollServer(int port, size_t reactorCount, size_t workerCount, bool workStealing)
+    : port_(port), running_(false), threadPool_(workerCount, workStealing), fdOwnerCapacity_(fdCapacity()),
+      heartbeatTimeout_(DEFAULT_HEARTBEAT_TIMEOUT), loginTimeout_(DEFAULT_LOGIN_TIMEOUT) {
+    if (reactorCount == 0) {
+        reactorCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < reactorCount; ++i) {
+        auto reactor = std::make_unique<Reactor>();
+        reactor->index = static_cast<int>(i);
+        MessageEncoder::writeHeader(reactor->heartbeatFrame.data(), MessageType::HEARTBEAT_RESPONSE,
+                                    HEARTBEAT_BODY_SIZE);
+        std::memcpy(reactor->heartbeatFrame.data() + HEADER_SIZE, R"({"timestamp":0000000000})",
+                    HEARTBEAT_BODY_SIZE);
+        reactors_.push_back(std::move(reactor));
+    }
+    fdOwners_.reset(new std::atomic<int>[fdOwnerCapacity_]());
 }
 
 EpollServer::~EpollServer() {
     stop();
+    for (auto& reactor : reactors_) {
+        if (reactor->thread.joinable()) {
+            reactor->thread.join();
+        }
+        // 唤醒 fd 最后关闭：其他线程的 runAfter 在停止前后可能仍在写入，提前关闭会写到被复用的 fd
+        if (reactor->wakeFd >= 0) {
+            close(reactor->wakeFd);
+            reactor->wakeFd = -1;
+        }
+    }
 }
 
-bool EpollServer::createServerSocket() {
-    serverFd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (serverFd_ < 0) {
-        Logger::error("创建 Socket 失败: " + std::string(strerror(errno)));
+bool EpollServer::createServerSocket(Reactor& reactor) {
+    int serverFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (serverFd < 0) {
+        LOG_ERROR("创建 Socket 失败: " + std::string(strerror(errno)));
         return false;
     }
+    reactor.listenFd = serverFd;
     
     // 设置 Socket 选项
     int opt = 1;
-    setsockopt(serverFd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    
+    // 多 Reactor 时每个 Reactor 绑定同一端口，由内核在各监听 Socket 间分发新连接
+    if (reactors_.size() > 1 &&
+        setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("设置 SO_REUSEPORT 失败: " + std::string(strerror(errno)));
+        return false;
+    }
     
     // 设置为非阻塞
-    if (!setNonBlocking(serverFd_)) {
+    if (!setNonBlocking(serverFd)) {
         return false;
     }
     
@@ -50,14 +138,14 @@ bool EpollServer::createServerSocket() {
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port = htons(port_);
     
-    if (bind(serverFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-        Logger::error("绑定地址失败: " + std::string(strerror(errno)) + " (端口: " + std::to_string(port_) + ")");
+    if (bind(serverFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        LOG_ERROR("绑定地址失败: " + std::string(strerror(errno)) + " (端口: " + std::to_string(port_) + ")");
         return false;
     }
     
     // 监听
-    if (listen(serverFd_, 128) < 0) {
-        Logger::error("监听失败: " + std::string(strerror(errno)));
+    if (listen(serverFd, 128) < 0) {
+        LOG_ERROR("监听失败: " + std::string(strerror(errno)));
         return false;
     }
     
@@ -73,28 +161,53 @@ bool EpollServer::setNonBlocking(int fd) {
 }
 
 bool EpollServer::start() {
-    if (!createServerSocket()) {
-        return false;
+    for (auto& reactor : reactors_) {
+        if (!createServerSocket(*reactor)) {
+            return false;
+        }
+        
+        // 创建 epoll
+        reactor->epollFd = epoll_create1(0);
+        if (reactor->epollFd < 0) {
+            LOG_ERROR("创建 epoll 失败");
+            return false;
+        }
+        
+        // 添加服务器 Socket 到 epoll
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;  // 边缘触发模式
+        ev.data.fd = reactor->listenFd;
+        if (epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->listenFd, &ev) < 0) {
+            LOG_ERROR("添加服务器 Socket 到 epoll 失败");
+            return false;
+        }
+        
+        // 唤醒用的 eventfd（提交延时任务时写入）
+        reactor->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event wakeEv{};
+        wakeEv.events = EPOLLIN;
+        wakeEv.data.fd = reactor->wakeFd;
+        if (reactor->wakeFd < 0 || epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->wakeFd, &wakeEv) < 0) {
+            LOG_ERROR("创建 Reactor 唤醒 eventfd 失败: " + std::string(strerror(errno)));
+            return false;
+        }
     }
     
-    // 创建 epoll
-    epollFd_ = epoll_create1(0);
-    if (epollFd_ < 0) {
-        Logger::error("创建 epoll 失败");
-        return false;
+    // 中间件：先限流（未登录的连接同样计入），再校验登录
+    if (rateLimitPerSecond_ > 0) {
+        dispatcher_.use(Dispatcher::rateLimit(rateLimitPerSecond_, rateLimitBurst_));
     }
-    
-    // 添加服务器 Socket 到 epoll
-    epoll_event ev{};
-    ev.events = EPOLLIN | EPOLLET;  // 边缘触发模式
-    ev.data.fd = serverFd_;
-    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, serverFd_, &ev) < 0) {
-        Logger::error("添加服务器 Socket 到 epoll 失败");
-        return false;
+    dispatcher_.use(&Dispatcher::requireAuth);
+    if (DbExecutor::getInstance().isRunning()) {
+        dispatcher_.setDatabaseExecutor([this](Session& session, Task job) {
+            return deferToDatabase(session, std::move(job));
+        });
     }
     
+    stopRequested_ = false;
     running_ = true;
-    Logger::info("服务器启动成功，监听端口: " + std::to_string(port_));
+    LOG_INFO("服务器启动成功，监听端口: " + std::to_string(port_) +
+                 "，Reactor 数量: " + std::to_string(reactors_.size()));
     return true;
 }
 
@@ -103,66 +216,175 @@ void EpollServer::stop() {
         return;  // 已经停止，避免重复调用
     }
     
-    Logger::info("正在停止服务器...");
+    LOG_INFO("正在停止服务器...");
     running_ = false;
+    requestStop();  // 唤醒各 Reactor，不必等到 epoll_wait 超时
     
     // 先停止线程池，避免新任务提交
     threadPool_.stop();
-    Logger::info("线程池已停止");
+    LOG_INFO("线程池已停止");
     
-    // 关闭所有客户端连接
-    {
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        Logger::info("正在关闭 " + std::to_string(clients_.size()) + " 个客户端连接");
-        for (auto& [fd, client] : clients_) {
-            close(fd);
+    // 关闭所有客户端连接（各 Reactor 的事件循环在下一次超时后退出并释放 epoll / 监听 Socket）
+    size_t closedCount = 0;
+    for (auto& reactor : reactors_) {
+        std::lock_guard<std::mutex> lock(reactor->mutex);
+        for (auto& [fd, client] : reactor->connections) {
+            fdOwners_[fd].store(0, std::memory_order_release);
+            client->closed = true;
+            shutdown(fd, SHUT_RDWR);
         }
-        clients_.clear();
+        closedCount += reactor->connections.size();
+        reactor->connections.clear();
+        reactor->connectionCount.store(0, std::memory_order_relaxed);
     }
+    LOG_INFO("已关闭 " + std::to_string(closedCount) + " 个客户端连接");
     
-    // 关闭 epoll（这会让 epoll_wait 返回 EBADF，从而退出循环）
-    if (epollFd_ >= 0) {
-        close(epollFd_);
-        epollFd_ = -1;
-    }
-    
-    // 关闭服务器 Socket
-    if (serverFd_ >= 0) {
-        close(serverFd_);
-        serverFd_ = -1;
+    LOG_INFO("服务器已完全停止");
+}
+
+void EpollServer::requestStop() {
+    static_assert(std::atomic<bool>::is_always_lock_free, "信号处理函数中只能使用无锁原子变量");
+    stopRequested_.store(true, std::memory_order_release);
+    for (auto& reactor : reactors_) {
+        if (reactor->wakeFd >= 0) {
+            uint64_t one = 1;
+            ssize_t written = write(reactor->wakeFd, &one, sizeof(one));
+            (void)written;
+        }
     }
-    
-    Logger::info("服务器已完全停止");
 }
 
 void EpollServer::run() {
+    // Reactor 0 在调用线程中运行，其余 Reactor 各占一个线程
+    for (size_t i = 1; i < reactors_.size(); ++i) {
+        Reactor* reactor = reactors_[i].get();
+        reactor->thread = std::thread([this, reactor] { runReactor(*reactor); });
+    }
+    if (!reactors_.empty()) {
+        runReactor(*reactors_[0]);
+    }
+    for (auto& reactor : reactors_) {
+        if (reactor->thread.joinable()) {
+            reactor->thread.join();
+        }
+    }
+}
+
+void EpollServer::runReactor(Reactor& reactor) {
     const int MAX_EVENTS = 64;
     epoll_event events[MAX_EVENTS];
     
-    while (running_) {
-        // 使用 1000ms 超时，以便定期检查 running_ 状态
-        int numEvents = epoll_wait(epollFd_, events, MAX_EVENTS, 1000);
+    auto sampleTime = std::chrono::steady_clock::now();
+    auto statsLogTime = sampleTime;
+    uint64_t sampleEvents = 0;
+    
+    while (running_ && !stopRequested_) {
+        // 其他线程提交的延时任务挂到时间轮上
+        std::vector<std::pair<std::chrono::milliseconds, std::function<void()>>> pendingTimers;
+        {
+            std::lock_guard<std::mutex> lock(reactor.timerMutex);
+            pendingTimers.swap(reactor.pendingTimers);
+        }
+        for (auto& [delay, task] : pendingTimers) {
+            reactor.timers.add(delay, std::move(task));
+        }
+        
+        // 最长等待 1000ms 以便定期检查 running_ 状态，有定时器时等到下一个刻度
+        int timeout = reactor.timers.timeoutMs(std::chrono::steady_clock::now(), MAX_WAIT_MS);
+        int numEvents = epoll_wait(reactor.epollFd, events, MAX_EVENTS, timeout);
         
         if (numEvents < 0) {
             if (errno == EINTR) {
                 // 被信号中断，检查是否需要退出
-                if (!running_) {
+                if (!running_ || stopRequested_) {
                     break;
                 }
                 continue;
             }
             if (errno == EBADF) {
-                // epollFd_ 已被关闭，正常退出
-                Logger::info("epoll 文件描述符已关闭，退出事件循环");
+                // epoll 已被关闭，正常退出
+                LOG_INFO("epoll 文件描述符已关闭，退出事件循环");
                 break;
             }
-            Logger::error("epoll_wait 失败: " + std::string(strerror(errno)));
+            LOG_ERROR("epoll_wait 失败: " + std::string(strerror(errno)));
             break;
         }
         
+        // 事件速率采样，按秒计算
+        uint64_t totalEvents = reactor.eventCount.fetch_add(numEvents, std::memory_order_relaxed) + numEvents;
+        auto now = std::chrono::steady_clock::now();
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - sampleTime).count();
+        if (elapsedMs >= 1000) {
+            reactor.eventsPerSecond.store((totalEvents - sampleEvents) * 1000 / elapsedMs,
+                                          std::memory_order_relaxed);
+            sampleEvents = totalEvents;
+            sampleTime = now;
+        }
+        
+        // 到期的连接超时检查与延时任务
+        reactor.timers.advance(now);
+        
+        if (reactor.index == 0 && now - statsLogTime >= std::chrono::seconds(STATS_LOG_INTERVAL)) {
+            statsLogTime = now;
+            for (const auto& stats : getReactorStats()) {
+                LOG_INFO("[Reactor " + std::to_string(stats.index) + "] 连接数=" +
+                             std::to_string(stats.connections) + ", 事件/秒=" +
+                             std::to_string(stats.eventsPerSecond) + ", 待发送字节=" +
+                             std::to_string(stats.queuedBytes));
+            }
+            auto workers = threadPool_.getStats();
+            std::string workerStats;
+            for (const auto& worker : workers.workers) {
+                workerStats += "; #" + std::to_string(worker.index) + " 执行=" + std::to_string(worker.executed) +
+                               " 窃取=" + std::to_string(worker.steals) +
+                               " 本地队列=" + std::to_string(worker.localDepth);
+            }
+            LOG_INFO("[线程池] 模式=", workers.workStealing ? "工作窃取" : "全局队列",
+                     ", 全局队列=", workers.globalDepth, workerStats);
+            auto pool = Database::getInstance().getPoolStats();
+            LOG_INFO("[数据库连接池] 连接数=", pool.size, ", 借出=", pool.inUse,
+                     ", 借出次数=", pool.acquireCount, ", 等待次数=", pool.waitCount,
+                     ", 平均等待(us)=", pool.waitCount ? pool.totalWaitMicros / pool.waitCount : 0,
+                     ", 最长等待(us)=", pool.maxWaitMicros, ", 超时次数=", pool.timeoutCount,
+                     ", 重连次数=", pool.reconnectCount);
+            auto executor = DbExecutor::getInstance().getStats();
+            if (executor.threads > 0) {
+                LOG_INFO("[数据库执行器] 线程数=", executor.threads, ", 执行中=", executor.running,
+                         ", 排队=", executor.queued, "/", executor.capacity, ", 执行次数=", executor.executed,
+                         ", 拒绝次数=", executor.rejected, ", 平均排队(us)=",
+                         executor.executed ? executor.totalWaitMicros / executor.executed : 0,
+                         ", 最长排队(us)=", executor.maxWaitMicros);
+            }
+            auto presence = presence_.getStats();
+            LOG_INFO("[在线状态] 事件=", presence.published, ", 合并=", presence.coalesced,
+                     ", 推送变化=", presence.changes, ", 批次=", presence.flushes,
+                     ", 通知帧=", presence.notifies, ", 字节=", presence.bytes);
+            auto roster = GroupRosterCache::getInstance().getStats();
+            LOG_INFO("[群成员缓存] 群数=", roster.groups, ", 内存(KB)=", roster.memoryBytes >> 10,
+                     ", 命中=", roster.hits, ", 未命中=", roster.misses, ", 淘汰=", roster.evictions);
+            std::string dispatchStats;
+            for (const auto& stats : dispatcher_.getStats()) {
+                char type[8];
+                snprintf(type, sizeof(type), "0x%04X", stats.type);
+                dispatchStats += std::string(dispatchStats.empty() ? "" : "; ") + type +
+                                 " 处理=" + std::to_string(stats.handled) +
+                                 " 拦截=" + std::to_string(stats.rejected) +
+                                 " 平均耗时(us)=" + std::to_string(stats.handled ? stats.totalMicros / stats.handled : 0);
+            }
+            if (!dispatchStats.empty()) {
+                LOG_INFO("[消息分发] ", dispatchStats);
+            }
+            deliveries_.sweep();
+            LOG_INFO("[消息确认] 去重窗口=", sendDedup_.size(), ", 待确认投递=", deliveries_.size());
+            auto store = MessageStore::getInstance().getStats();
+            LOG_INFO("[消息存储] 写入条数=", store.appended, ", 写入(KB)=", store.bytes >> 10,
+                     ", 刷盘次数=", store.commits, ", 最大批量=", store.maxBatch, ", 待写入=", store.pending,
+                     ", 段文件=", store.segments, ", 会话数=", store.conversations);
+        }
+        
         // 超时返回 0，检查是否需要退出
         if (numEvents == 0) {
-            if (!running_) {
+            if (!running_ || stopRequested_) {
                 break;
             }
             continue;
@@ -171,29 +393,116 @@ void EpollServer::run() {
         for (int i = 0; i < numEvents; ++i) {
             int fd = events[i].data.fd;
             
-            if (fd == serverFd_) {
+            if (fd == reactor.listenFd) {
                 // 新连接
-                acceptConnection();
+                acceptConnection(reactor);
+            } else if (fd == reactor.wakeFd) {
+                // 只为唤醒：清零计数，新提交的延时任务在下一轮循环开头挂到时间轮上
+                uint64_t count;
+                while (read(reactor.wakeFd, &count, sizeof(count)) < 0 && errno == EINTR) {
+                }
             } else {
                 // 检查连接是否关闭
-                if (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
                     closeConnection(fd);
                 } else {
-                    // 客户端数据
-                    threadPool_.submit([this, fd] {
-                        handleClientData(fd);
-                    });
+                    std::shared_ptr<ClientConnection> client;
+                    {
+                        std::lock_guard<std::mutex> lock(reactor.mutex);
+                        auto it = reactor.connections.find(fd);
+                        if (it != reactor.connections.end()) {
+                            client = it->second;
+                        }
+                    }
+                    if (!client) {
+                        continue;
+                    }
+                    // 可写：刷出积压的发送队列
+                    if (events[i].events & EPOLLOUT) {
+                        handleWritable(client);
+                    }
+                    // 客户端数据（EPOLLRDHUP 也走读流程，读完剩余数据后由 recv 返回 0 关闭）
+                    if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                        handleReadable(reactor, client);
+                    }
                 }
             }
         }
     }
+    
+    // 事件循环结束，释放本 Reactor 的 epoll 和监听 Socket
+    if (reactor.epollFd >= 0) {
+        close(reactor.epollFd);
+        reactor.epollFd = -1;
+    }
+    if (reactor.listenFd >= 0) {
+        close(reactor.listenFd);
+        reactor.listenFd = -1;
+    }
+}
+
+EpollServer::Reactor* EpollServer::ownerOf(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= fdOwnerCapacity_) {
+        return nullptr;
+    }
+    int owner = fdOwners_[fd].load(std::memory_order_acquire);
+    return owner > 0 ? reactors_[owner - 1].get() : nullptr;
+}
+
+EpollServer::ClientConnection::~ClientConnection() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+std::shared_ptr<EpollServer::ClientConnection> EpollServer::findConnection(int fd) {
+    Reactor* reactor = ownerOf(fd);
+    if (!reactor) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(reactor->mutex);
+    auto it = reactor->connections.find(fd);
+    return it != reactor->connections.end() ? it->second : nullptr;
+}
+
+std::vector<ReactorStats> EpollServer::getReactorStats() {
+    std::vector<ReactorStats> result;
+    result.reserve(reactors_.size());
+    for (auto& reactor : reactors_) {
+        size_t queuedBytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(reactor->mutex);
+            for (auto& [fd, client] : reactor->connections) {
+                queuedBytes += client->queuedBytes.load(std::memory_order_relaxed);
+            }
+        }
+        result.push_back({reactor->index,
+                          reactor->connectionCount.load(std::memory_order_relaxed),
+                          reactor->eventCount.load(std::memory_order_relaxed),
+                          reactor->eventsPerSecond.load(std::memory_order_relaxed),
+                          queuedBytes});
+    }
+    return result;
+}
+
+std::vector<ConnectionStats> EpollServer::getConnectionStats() {
+    std::vector<ConnectionStats> result;
+    for (auto& reactor : reactors_) {
+        std::lock_guard<std::mutex> lock(reactor->mutex);
+        for (auto& [fd, client] : reactor->connections) {
+            result.push_back({fd, client->userId,
+                              client->queuedBytes.load(std::memory_order_relaxed),
+                              client->readPaused.load(std::memory_order_relaxed)});
+        }
+    }
+    return result;
 }
 
-void EpollServer::acceptConnection() {
+void EpollServer::acceptConnection(Reactor& reactor) {
     while (true) {
         sockaddr_in clientAddr{};
         socklen_t addrLen = sizeof(clientAddr);
-        int clientFd = accept(serverFd_, 
+        int clientFd = accept(reactor.listenFd, 
                              reinterpret_cast<sockaddr*>(&clientAddr),
                              &addrLen);
         
@@ -201,421 +510,489 @@ void EpollServer::acceptConnection() {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 break;  // 没有更多连接
             }
-            Logger::error("接受连接失败");
+            LOG_ERROR("接受连接失败");
+            continue;
+        }
+        
+        if (static_cast<size_t>(clientFd) >= fdOwnerCapacity_) {
+            LOG_ERROR("连接数超出 fd 上限，拒绝连接: fd=" + std::to_string(clientFd));
+            close(clientFd);
             continue;
         }
         
         // 设置为非阻塞
         setNonBlocking(clientFd);
         
-        // 添加到 epoll
+        // 创建客户端连接，先登记到本 Reactor 的分片再加入 epoll
+        auto client = std::make_shared<ClientConnection>();
+        client->fd = clientFd;
+        client->serial = connectionSerial_.fetch_add(1, std::memory_order_relaxed) + 1;
+        client->acceptedMs = steadyMs();
+        client->lastActiveMs.store(client->acceptedMs, std::memory_order_relaxed);
+        uint32_t serial = client->serial;
+                
+        {
+            std::lock_guard<std::mutex> lock(reactor.mutex);
+            reactor.connections[clientFd] = std::move(client);
+        }
+        reactor.connectionCount.fetch_add(1, std::memory_order_relaxed);
+        fdOwners_[clientFd].store(reactor.index + 1, std::memory_order_release);
+        
+        // 添加到 epoll（EPOLLOUT 边缘触发常驻，仅在发送缓冲区由满变为可写时通知）
         epoll_event ev{};
-        ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
         ev.data.fd = clientFd;
-        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, clientFd, &ev) < 0) {
-            close(clientFd);
+        if (epoll_ctl(reactor.epollFd, EPOLL_CTL_ADD, clientFd, &ev) < 0) {
+            closeConnection(clientFd);
             continue;
         }
         
-        // 创建客户端连接
-        auto client = std::make_unique<ClientConnection>();
-        client->fd = clientFd;
-        client->authenticated = false;
-        
-        {
-            std::lock_guard<std::mutex> lock(clientsMutex_);
-            clients_[clientFd] = std::move(client);
+        // 登录期限与心跳超时共用一个定时器，先到期的那个决定首次检查时间
+        auto firstCheck = std::chrono::milliseconds::max();
+        if (loginTimeout_.count() > 0) {
+            firstCheck = loginTimeout_;
+        }
+        if (heartbeatTimeout_.count() > 0) {
+            firstCheck = std::min(firstCheck, heartbeatTimeout_);
+        }
+        if (firstCheck != std::chrono::milliseconds::max()) {
+            reactor.timers.add(firstCheck, [this, clientFd, serial] { checkIdle(clientFd, serial); });
         }
         
-        Logger::info("新客户端连接: " + std::string(inet_ntoa(clientAddr.sin_addr)) 
+        LOG_INFO("新客户端连接: " + std::string(inet_ntoa(clientAddr.sin_addr)) 
                   + ":" + std::to_string(ntohs(clientAddr.sin_port)));
     }
 }
 
-void EpollServer::handleClientData(int fd) {
-    std::vector<uint8_t> buffer(4096);
-    ssize_t bytesRead = recv(fd, buffer.data(), buffer.size(), 0);
-    
-    if (bytesRead <= 0) {
-        if (bytesRead == 0) {
-            // 客户端主动关闭连接
-            closeConnection(fd);
-        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            Logger::warn("读取客户端数据失败: fd=" + std::to_string(fd) +
-                         ", bytesRead=" + std::to_string(bytesRead) +
-                         ", errno=" + std::to_string(errno) +
-                         ", msg=" + std::string(strerror(errno)));
-            closeConnection(fd);
-        }
+void EpollServer::scheduleRead(const std::shared_ptr<ClientConnection>& client) {
+    client->readPending = true;
+    if (client->readPaused || client->dbPending) {
+        return;  // 发送积压中或等待数据库，恢复时会重新调度
+    }
+    if (client->reading.exchange(true)) {
+        return;  // 已有任务在处理该连接，它会在结束前再次读取
+    }
+    threadPool_.submit([this, client] {
+        handleClientData(client);
+    });
+}
+
+void EpollServer::handleReadable(Reactor& reactor, const std::shared_ptr<ClientConnection>& client) {
+    client->readPending = true;
+    if (client->readPaused || client->dbPending) {
+        return;
+    }
+    if (client->reading.exchange(true)) {
         return;
     }
     
-    // 记录收到的原始数据（只显示前32字节的十六进制）
-    std::string hexDump;
-    size_t dumpSize = std::min(static_cast<size_t>(bytesRead), size_t(32));
-    for (size_t i = 0; i < dumpSize; ++i) {
-        char buf[4];
-        snprintf(buf, sizeof(buf), "%02X ", static_cast<unsigned char>(buffer[i]));
-        hexDump += buf;
+    // 解码器里还有半包：直接走常规路径，保证包序
+    auto& decoder = client->decoder;
+    if (decoder.bufferedBytes() > 0) {
+        threadPool_.submit([this, client] { handleClientData(client); });
+        return;
     }
-    Logger::info("收到客户端数据: fd=" + std::to_string(fd) +
-                 ", bytes=" + std::to_string(bytesRead) +
-                 ", 前" + std::to_string(dumpSize) + "字节(hex): " + hexDump);
-    std::cout.flush();  // 强制刷新输出
+    client->readPending = false;
     
-    buffer.resize(bytesRead);
-    Logger::info("缓冲区已调整大小: " + std::to_string(buffer.size()) + " 字节");
-    std::cout.flush();
+    int fd = client->fd;
+    const uint8_t* data = reactor.readScratch.data();
+    ssize_t bytesRead;
+    do {
+        bytesRead = recv(fd, reactor.readScratch.data(), INLINE_READ_SIZE, 0);
+    } while (bytesRead < 0 && errno == EINTR);
     
-    // 解码消息（需要加锁访问 clients_）
-    std::queue<Packet> messagesCopy;
-    {
-        Logger::info("准备获取客户端连接锁: fd=" + std::to_string(fd));
-        std::cout.flush();
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        Logger::info("已获取客户端连接锁: fd=" + std::to_string(fd));
-        std::cout.flush();
-        auto it = clients_.find(fd);
-        if (it == clients_.end()) {
-            Logger::warn("收到数据但客户端连接不存在: fd=" + std::to_string(fd));
-            return;
+    // 没读满暂存区说明内核缓冲区已读空（之后到达的数据会再次触发边缘事件）
+    size_t length = bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+    bool drained = (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ||
+                   (bytesRead > 0 && length < INLINE_READ_SIZE);
+    
+    // 从头逐个应答完整的心跳包，遇到其他类型、半包或错误的 Magic 即停止
+    size_t offset = 0;
+    size_t heartbeats = 0;
+    while (length - offset >= HEADER_SIZE) {
+        uint32_t magic;
+        uint16_t type;
+        uint32_t bodyLength;
+        std::memcpy(&magic, data + offset, 4);
+        std::memcpy(&type, data + offset + 4, 2);
+        std::memcpy(&bodyLength, data + offset + 6, 4);
+        bodyLength = ntohl(bodyLength);
+        if (ntohl(magic) != MAGIC || ntohs(type) != static_cast<uint16_t>(MessageType::HEARTBEAT) ||
+            bodyLength > length - offset - HEADER_SIZE) {
+            break;
         }
-        
-        auto& client = it->second;
-        Logger::info("调用解码器: fd=" + std::to_string(fd) + ", 缓冲区大小=" + std::to_string(buffer.size()));
-        auto messages = client->decoder.addData(buffer);
-        Logger::info("解码器返回: fd=" + std::to_string(fd) + ", 解码出消息数=" + std::to_string(messages.size()));
-        
-        // 复制消息队列，准备释放锁
-        messagesCopy = messages;
-        // lock 在这里自动释放（作用域结束）
+        offset += HEADER_SIZE + bodyLength;
+        sendHeartbeatInline(reactor, client);
+        ++heartbeats;
+    }
+    if (length > 0) {
+        client->lastActiveMs.store(steadyMs(), std::memory_order_relaxed);
+        LOG_DEBUG("收到客户端数据: fd=", fd, ", bytes=", length, ", 心跳直接应答=", heartbeats);
     }
-    Logger::info("锁已释放，准备处理消息: fd=" + std::to_string(fd));
-    std::cout.flush();
     
-    if (messagesCopy.empty()) {
-        Logger::warn("⚠ 收到数据但未解码出任何消息: fd=" + std::to_string(fd) + 
-                     ", bytes=" + std::to_string(bytesRead) +
-                     ", 这可能表示数据格式错误或数据不完整");
-    } else {
-        Logger::info("✓ 成功解码出 " + std::to_string(messagesCopy.size()) + " 条消息，开始处理");
+    if (drained && offset == length) {
+        // 全部是心跳（或是空读）：就地结束；期间被标记待读（如恢复读取）时再交给线程池
+        client->reading = false;
+        if (client->readPending && !client->readPaused && !client->dbPending &&
+            !client->reading.exchange(true)) {
+            threadPool_.submit([this, client] { handleClientData(client); });
+        }
+        return;
     }
     
-    while (!messagesCopy.empty()) {
-        Logger::info("处理消息队列中的一条消息: fd=" + std::to_string(fd));
-        std::cout.flush();
-        processMessage(fd, messagesCopy.front());
-        messagesCopy.pop();
+    // 其余数据（业务消息、半包、未读完、连接关闭或出错）转入解码器，由线程池按常规路径处理
+    if (offset < length) {
+        decoder.prepareWrite(length - offset);
+        std::memcpy(decoder.writeData(), data + offset, length - offset);
+        decoder.commitWrite(length - offset);
     }
-    Logger::info("消息处理完成: fd=" + std::to_string(fd));
+    threadPool_.submit([this, client] { handleClientData(client); });
 }
 
-void EpollServer::processMessage(int fd, const Packet& packet) {
-    uint16_t msgType = static_cast<uint16_t>(packet.type);
-    
-    // 区分心跳和业务请求的日志级别
-    bool isHeartbeat = (msgType == static_cast<uint16_t>(MessageType::HEARTBEAT) ||
-                        msgType == static_cast<uint16_t>(MessageType::HEARTBEAT_RESPONSE));
-    
-    Logger::info("[processMessage] 开始处理消息: fd=" + std::to_string(fd) + 
-                 ", type=" + std::to_string(msgType));
-    std::cout.flush();
-    
-    if (isHeartbeat) {
-        // 心跳包也使用info级别以便排查问题
-        Logger::info("[processMessage] 处理心跳: fd=" + std::to_string(fd) + ", type=" + std::to_string(msgType));
-    } else {
-        // 业务请求记录info级别，便于排查问题
-        Logger::info("[processMessage] 处理业务消息: fd=" + std::to_string(fd) +
-                     ", type=" + std::to_string(msgType) +
-                     ", data_length=" + std::to_string(packet.data.length()) +
-                     ", data=" + packet.data.substr(0, 100));  // 只显示前100字符
-    }
-    std::cout.flush();
-    
-    // 先检查客户端是否存在，然后快速释放锁
-    Logger::info("[processMessage] 准备获取锁检查客户端: fd=" + std::to_string(fd));
-    std::cout.flush();
-    bool clientExists = false;
-    bool authenticated = false;
-    {
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        Logger::info("[processMessage] 已获取锁，查找客户端: fd=" + std::to_string(fd));
-        std::cout.flush();
-        auto it = clients_.find(fd);
-        if (it == clients_.end()) {
-            Logger::warn("处理消息时客户端连接不存在: fd=" + std::to_string(fd));
-            return;
+void EpollServer::sendHeartbeatInline(Reactor& reactor, const std::shared_ptr<ClientConnection>& client) {
+    time_t now = time(nullptr);
+    if (now != reactor.heartbeatSecond) {
+        // 每秒改写一次时间戳的 10 位数字（位于结尾的 '}' 之前）
+        reactor.heartbeatSecond = now;
+        uint8_t* digit = reactor.heartbeatFrame.data() + reactor.heartbeatFrame.size() - 2;
+        for (int i = 0; i < 10; ++i, --digit) {
+            *digit = static_cast<uint8_t>('0' + now % 10);
+            now /= 10;
         }
-        clientExists = true;
-        authenticated = it->second->authenticated;
-        Logger::info("[processMessage] 找到客户端，authenticated=" + std::string(authenticated ? "true" : "false"));
-        std::cout.flush();
     }
-    // 锁在这里释放，避免在发送消息时持有锁
-    Logger::info("[processMessage] 锁已释放，开始处理消息逻辑: fd=" + std::to_string(fd));
-    std::cout.flush();
+    const uint8_t* frame = reactor.heartbeatFrame.data();
+    const size_t size = reactor.heartbeatFrame.size();
     
-    switch (msgType) {
-        case static_cast<uint16_t>(MessageType::LOGIN_REQUEST):
-            Logger::info(">>> 处理登录请求: fd=" + std::to_string(fd) + ", data=" + packet.data);
-            LoginHandler::handle(*this, fd, packet.data);
-            break;
-        case static_cast<uint16_t>(MessageType::REGISTER_REQUEST):
-            Logger::info(">>> 处理注册请求: fd=" + std::to_string(fd) + ", data=" + packet.data);
-            LoginHandler::handleRegister(*this, fd, packet.data);
-            break;
-        case static_cast<uint16_t>(MessageType::SEND_MESSAGE):
-            if (authenticated) {
-                MessageHandler::handle(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR, 
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::HEARTBEAT): {
-            // 心跳包处理（使用info级别以便排查问题）
-            Logger::info("[心跳处理] >>> 收到心跳请求: fd=" + std::to_string(fd));
-            std::cout.flush();
-            std::string heartbeatResponse = R"({"timestamp":)" + std::to_string(time(nullptr)) + "}";
-            Logger::info("[心跳处理] 准备发送心跳响应: fd=" + std::to_string(fd) + ", json=" + heartbeatResponse);
-            std::cout.flush();
-            sendMessage(fd, MessageType::HEARTBEAT_RESPONSE, heartbeatResponse);
-            Logger::info("[心跳处理] <<< 心跳响应发送完成: fd=" + std::to_string(fd));
-            std::cout.flush();
-            break;
-        }
-        case static_cast<uint16_t>(MessageType::FRIEND_APPLY_REQUEST):
-            if (authenticated) {
-                FriendHandler::handleApply(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::FRIEND_HANDLE_REQUEST):
-            if (authenticated) {
-                FriendHandler::handleApplyAction(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::FRIEND_LIST_REQUEST):
-            if (authenticated) {
-                FriendHandler::handleFriendList(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::FRIEND_DELETE_REQUEST):
-            if (authenticated) {
-                FriendHandler::handleDelete(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::FRIEND_BLOCK_REQUEST):
-            if (authenticated) {
-                FriendHandler::handleBlock(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_CREATE_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleCreate(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_LIST_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleGroupList(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_MEMBER_LIST_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleMemberList(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
-            }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_INVITE_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleInvite(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
+    {
+        // 只尝试加锁，不等待：其他线程正在写时交给线程池入队
+        std::unique_lock<std::mutex> lock(client->writeMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            if (client->closed) {
+                return;
             }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_KICK_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleKick(*this, fd, packet.data);
+            bool ok;
+            if (!client->outQueue.empty()) {
+                // 队列中还有数据：排在其后，保持发送顺序
+                ok = queueFrameLocked(*client, makeFrame(std::vector<uint8_t>(frame, frame + size)));
             } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
+                ssize_t sent = send(client->fd, frame, size, MSG_NOSIGNAL);
+                if (sent == static_cast<ssize_t>(size)) {
+                    return;
+                }
+                if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    ok = false;
+                } else {
+                    // 发送缓冲区已满：剩余部分按同样的水位规则入队，由 EPOLLOUT 刷出
+                    size_t offset = sent > 0 ? static_cast<size_t>(sent) : 0;
+                    ok = queueFrameLocked(*client, makeFrame(std::vector<uint8_t>(frame + offset, frame + size)));
+                }
             }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_QUIT_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleQuit(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
+            if (ok) {
+                return;
             }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_DISMISS_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleDismiss(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
+            lock.unlock();
+            closeConnection(client->fd);
+            return;
+        }
+    }
+    threadPool_.submit([this, client, frame = makeFrame(std::vector<uint8_t>(frame, frame + size))]() mutable {
+        enqueueFrame(client, std::move(frame));
+    });
+}
+
+void EpollServer::handleClientData(const std::shared_ptr<ClientConnection>& client) {
+    int fd = client->fd;
+    auto& decoder = client->decoder;
+    
+    // 在同一任务内按到达顺序处理，保证该连接的包序；包体直接引用解码缓冲区，不做拷贝
+    auto processPackets = [this, &client, &decoder]() {
+        size_t count = 0;
+        PacketView packet;
+        while (!client->closed && !client->dbPending && decoder.nextPacket(packet)) {
+            processMessage(*client, packet);
+            decoder.consume();
+            ++count;
+        }
+        return count;
+    };
+    
+    while (true) {
+        client->readPending = false;
+        
+        // 边缘触发：一直读到 EAGAIN，recv 直接写入解码缓冲区；积压到上限先处理已完整的包
+        size_t totalRead = 0;
+        size_t packetCount = 0;
+        bool peerClosed = false;
+        bool readError = false;
+        while (!client->closed && !client->readPaused && !client->dbPending && !decoder.hasError()) {
+            if (decoder.bufferedBytes() >= MAX_READ_BUFFER_SIZE) {
+                packetCount += processPackets();
+                if (client->closed || client->readPaused || client->dbPending || decoder.hasError()) {
+                    break;
+                }
             }
-            break;
-        case static_cast<uint16_t>(MessageType::GROUP_UPDATE_INFO_REQUEST):
-            if (authenticated) {
-                GroupHandler::handleUpdateInfo(*this, fd, packet.data);
-            } else {
-                sendMessage(fd, MessageType::ERROR,
-                           R"({"error_code":1001,"error_message":"请先登录"})");
+            
+            size_t writable = decoder.prepareWrite(INITIAL_READ_BUFFER_SIZE);
+            ssize_t bytesRead = recv(fd, decoder.writeData(), writable, 0);
+            if (bytesRead > 0) {
+                decoder.commitWrite(bytesRead);
+                totalRead += bytesRead;
+                continue;
             }
-            break;
-        case static_cast<uint16_t>(MessageType::USER_LIST_REQUEST):
-            if (authenticated) {
-                UserHandler::handleUserList(*this, fd);
-            } else {
-                sendMessage(fd, MessageType::ERROR, 
-                           R"({"error_code":1001,"error_message":"请先登录"})");
+            if (bytesRead == 0) {
+                // 客户端主动关闭连接
+                peerClosed = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARN("读取客户端数据失败: fd=" + std::to_string(fd) +
+                             ", errno=" + std::to_string(errno) +
+                             ", msg=" + std::string(strerror(errno)));
+                readError = true;
             }
             break;
-        case static_cast<uint16_t>(MessageType::LOGOUT):
+        }
+        
+        packetCount += processPackets();
+        
+        if (totalRead > 0) {
+            client->lastActiveMs.store(steadyMs(), std::memory_order_relaxed);
+            LOG_DEBUG("收到客户端数据: fd=", fd, ", bytes=", totalRead, ", 解码出消息数=", packetCount);
+        }
+        
+        if (decoder.hasError()) {
+            // 协议错误无法恢复同步，直接断开
+            LOG_WARN("协议解码错误，断开连接: fd=" + std::to_string(fd));
+            readError = true;
+        }
+        if (peerClosed || readError) {
             closeConnection(fd);
-            break;
-        default:
-            Logger::warn("未知消息类型: " + std::to_string(static_cast<uint16_t>(packet.type)));
-            break;
+        }
+        if (client->closed) {
+            client->reading = false;
+            return;
+        }
+        
+        // 释放连接前再检查一次，避免丢失处理期间到达的可读事件或恢复读取的通知
+        auto shouldContinue = [&client] {
+            return client->readPending && !client->readPaused && !client->dbPending;
+        };
+        if (!shouldContinue()) {
+            // 连接转入空闲，没有半包时归还解码缓冲区，避免大量空闲连接占用内存
+            decoder.releaseIfEmpty();
+            client->reading = false;
+            if (!shouldContinue() || client->reading.exchange(true)) {
+                return;
+            }
+        }
     }
 }
 
-void EpollServer::sendMessage(int fd, MessageType type, const std::string& jsonData) {
-    uint16_t msgType = static_cast<uint16_t>(type);
-    bool isHeartbeat = (msgType == static_cast<uint16_t>(MessageType::HEARTBEAT_RESPONSE));
+bool EpollServer::deferToDatabase(const Session& session, Task job) {
+    // 分发时传入的会话就是正在处理的连接本身
+    auto client = findConnection(session.fd);
+    if (!client || client.get() != &session) {
+        return true;  // 连接已关闭，请求直接丢弃
+    }
     
+    client->dbPending = true;
+    bool accepted = DbExecutor::getInstance().submit([this, client, job = std::move(job)]() mutable {
+        job();
+        job.reset();
+        // 恢复该连接：积压的包和期间到达的数据回到线程池继续处理
+        client->dbPending = false;
+        scheduleRead(client);
+    });
+    if (!accepted) {
+        client->dbPending = false;
+    }
+    return accepted;
+}
+
+void EpollServer::processMessage(Session& session, const PacketView& packet) {
+    // 逐包跟踪日志使用 DEBUG 级别，Release 构建在编译期剔除
+    LOG_DEBUG("[processMessage] fd=", session.fd, ", type=", static_cast<uint16_t>(packet.type),
+              ", data_length=", packet.data.length(),
+              ", data=", packet.data.substr(0, 100));  // 只显示前100字符
+    dispatcher_.dispatch(*this, session, packet);
+}
+
+void EpollServer::sendMessage(int fd, MessageType type, const std::string& jsonData) {
+    sendFrame(fd, MessageEncoder::encode(type, jsonData));
+}
+
+void EpollServer::sendFrame(int fd, Frame frame) {
     // 先检查客户端连接是否存在
+    auto client = findConnection(fd);
+    if (!client) {
+        LOG_ERROR("[发送消息] ✗ 客户端连接不存在: fd=", fd, ", 无法发送消息");
+        return;
+    }
+    submitFrame(client, std::move(frame));
+}
+
+void EpollServer::submitFrame(const std::shared_ptr<ClientConnection>& client, Frame frame) {
+    if (!frame || frame->size() < HEADER_SIZE) {
+        return;
+    }
+    int fd = client->fd;
+    uint16_t msgType = frameType(*frame);
+    
+    // 心跳响应使用debug级别，其他消息使用info级别
+    size_t packetSize = frame->size();
+    if (msgType == static_cast<uint16_t>(MessageType::HEARTBEAT_RESPONSE)) {
+        LOG_DEBUG("[发送消息] 心跳响应已提交: fd=", fd, ", bytes=", packetSize);
+    } else {
+        LOG_INFO("[发送消息] 消息已提交: fd=", fd, ", type=", msgType,
+                 ", bytes=", packetSize, ", json=", frameBody(*frame));
+    }
+    enqueueFrame(client, std::move(frame));
+}
+
+void EpollServer::enqueueFrame(const std::shared_ptr<ClientConnection>& client, Frame frame) {
+    if (!frame || frame->empty()) {
+        return;
+    }
+    
+    bool ok;
     {
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        auto it = clients_.find(fd);
-        if (it == clients_.end()) {
-            Logger::error("[发送消息] ✗ 客户端连接不存在: fd=" + std::to_string(fd) +
-                         ", type=" + std::to_string(msgType) +
-                         ", 无法发送消息");
+        std::lock_guard<std::mutex> lock(client->writeMutex);
+        if (client->closed) {
             return;
         }
+        ok = queueFrameLocked(*client, std::move(frame));
     }
-    
-    Logger::info("[发送消息] 开始编码: fd=" + std::to_string(fd) +
-                 ", type=" + std::to_string(msgType) +
-                 ", json_length=" + std::to_string(jsonData.length()) +
-                 ", json=" + jsonData);
-    std::cout.flush();
-    
-    auto packet = MessageEncoder::encode(type, jsonData);
-    
-    Logger::info("[发送消息] 编码完成: fd=" + std::to_string(fd) +
-                 ", packet_size=" + std::to_string(packet.size()) +
-                 " (头部10字节 + 数据" + std::to_string(jsonData.length()) + "字节)");
-    std::cout.flush();
-    
-    // 输出前16字节的十六进制，便于调试
-    std::string hexDump;
-    size_t dumpSize = std::min(packet.size(), size_t(16));
-    for (size_t i = 0; i < dumpSize; ++i) {
-        char buf[4];
-        snprintf(buf, sizeof(buf), "%02X ", static_cast<unsigned char>(packet[i]));
-        hexDump += buf;
+    if (!ok) {
+        closeConnection(client->fd);
     }
-    Logger::info("[发送消息] 数据包前" + std::to_string(dumpSize) + "字节(hex): " + hexDump);
-    std::cout.flush();
+}
+
+bool EpollServer::queueFrameLocked(ClientConnection& client, Frame frame) {
+    bool wasEmpty = client.outQueue.empty();
+    client.outQueue.push_back(std::move(frame));
+    client.queuedBytes.fetch_add(client.outQueue.back()->size(), std::memory_order_relaxed);
     
-    ssize_t sent = send(fd, packet.data(), packet.size(), 0);
+    // 队列原本为空时直接在当前线程尝试发送，否则等待 EPOLLOUT 按序刷出
+    if (wasEmpty && !flushQueueLocked(client)) {
+        return false;
+    }
     
-    if (sent < 0) {
-        Logger::error("[发送消息] ✗ 发送失败: fd=" + std::to_string(fd) + 
-                     ", type=" + std::to_string(msgType) +
-                     ", errno=" + std::to_string(errno) +
-                     ", msg=" + std::string(strerror(errno)) +
-                     ", 期望发送=" + std::to_string(packet.size()) + "字节");
-        std::cout.flush();
+    size_t queued = client.queuedBytes.load(std::memory_order_relaxed);
+    if (queued > OUTPUT_HARD_LIMIT) {
+        LOG_WARN("[发送消息] ✗ 发送队列超过上限，断开慢客户端: fd=" + std::to_string(client.fd));
+        return false;
+    }
+    if (queued > OUTPUT_HIGH_WATERMARK && !client.readPaused) {
+        client.readPaused = true;
+        LOG_WARN("[发送消息] 发送队列超过高水位，暂停读取: fd=" + std::to_string(client.fd) +
+                     ", queued=" + std::to_string(queued));
+    }
+    return true;
+}
+
+bool EpollServer::flushQueueLocked(ClientConnection& client) {
+    while (!client.outQueue.empty()) {
+        // 一次 writev 合并多帧
+        iovec iov[MAX_WRITE_IOVECS];
+        int iovCount = 0;
+        for (auto it = client.outQueue.begin();
+             it != client.outQueue.end() && iovCount < MAX_WRITE_IOVECS; ++it, ++iovCount) {
+            size_t offset = (iovCount == 0) ? client.outOffset : 0;
+            // 帧可能被多个连接共享，writev 只读不写
+            iov[iovCount].iov_base = const_cast<uint8_t*>((*it)->data()) + offset;
+            iov[iovCount].iov_len = (*it)->size() - offset;
+        }
         
-        // 发送失败时，如果是连接错误，关闭连接
-        if (errno == EPIPE || errno == ECONNRESET || errno == EBADF) {
-            Logger::warn("[发送消息] 检测到连接错误，关闭连接: fd=" + std::to_string(fd));
-            closeConnection(fd);
+        ssize_t written = writev(client.fd, iov, iovCount);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;  // 内核发送缓冲区已满，等待 EPOLLOUT
+            }
+            LOG_ERROR("[发送消息] ✗ 发送失败: fd=" + std::to_string(client.fd) +
+                         ", errno=" + std::to_string(errno) +
+                         ", msg=" + std::string(strerror(errno)));
+            return false;
         }
-    } else if (sent != static_cast<ssize_t>(packet.size())) {
-        Logger::warn("[发送消息] ⚠ 部分发送: fd=" + std::to_string(fd) +
-                     ", type=" + std::to_string(msgType) +
-                     ", 期望=" + std::to_string(packet.size()) +
-                     "字节, 实际=" + std::to_string(sent) + "字节");
-        std::cout.flush();
-        // 部分发送时，尝试发送剩余数据
-        if (sent > 0 && sent < static_cast<ssize_t>(packet.size())) {
-            ssize_t remaining = packet.size() - sent;
-            ssize_t retrySent = send(fd, packet.data() + sent, remaining, 0);
-            if (retrySent < 0) {
-                Logger::error("[发送消息] ✗ 重试发送失败: fd=" + std::to_string(fd) +
-                             ", errno=" + std::to_string(errno));
-                if (errno == EPIPE || errno == ECONNRESET || errno == EBADF) {
-                    closeConnection(fd);
-                }
-            } else if (retrySent == remaining) {
-                Logger::info("[发送消息] ✓ 重试发送成功: fd=" + std::to_string(fd) +
-                             ", 补发=" + std::to_string(retrySent) + "字节");
-            } else {
-                Logger::warn("[发送消息] ⚠ 重试仍部分发送: fd=" + std::to_string(fd) +
-                             ", 期望=" + std::to_string(remaining) +
-                             "字节, 实际=" + std::to_string(retrySent) + "字节");
+        
+        // 弹出已完整发送的帧，记录队首帧的发送进度
+        client.queuedBytes.fetch_sub(written, std::memory_order_relaxed);
+        size_t remaining = written;
+        while (remaining > 0) {
+            size_t frameLeft = client.outQueue.front()->size() - client.outOffset;
+            if (remaining < frameLeft) {
+                client.outOffset += remaining;
+                break;
             }
+            remaining -= frameLeft;
+            client.outQueue.pop_front();
+            client.outOffset = 0;
         }
-    } else {
-        // 心跳响应使用debug级别，其他消息使用info级别
-        if (isHeartbeat) {
-            Logger::debug("[发送消息] ✓ 心跳响应已发送: fd=" + std::to_string(fd) + 
-                         ", bytes=" + std::to_string(sent));
-        } else {
-            Logger::info("[发送消息] ✓ 消息发送成功: fd=" + std::to_string(fd) +
-                         ", type=" + std::to_string(msgType) +
-                         ", bytes=" + std::to_string(sent) +
-                         ", json=" + jsonData);
+    }
+    return true;
+}
+
+void EpollServer::handleWritable(const std::shared_ptr<ClientConnection>& client) {
+    if (client->queuedBytes.load(std::memory_order_relaxed) == 0 && !client->readPaused) {
+        return;
+    }
+    
+    bool failed = false;
+    bool resume = false;
+    {
+        std::lock_guard<std::mutex> lock(client->writeMutex);
+        if (client->closed) {
+            return;
         }
-        std::cout.flush();
+        failed = !flushQueueLocked(*client);
+        if (!failed && client->readPaused &&
+            client->queuedBytes.load(std::memory_order_relaxed) <= OUTPUT_LOW_WATERMARK) {
+            client->readPaused = false;
+            resume = true;
+        }
+    }
+    
+    if (failed) {
+        closeConnection(client->fd);
+    } else if (resume) {
+        // 暂停期间的边缘事件已被忽略，恢复后主动调度一次读取
+        LOG_INFO("[发送消息] 发送队列降到低水位，恢复读取: fd=" + std::to_string(client->fd));
+        scheduleRead(client);
     }
 }
 
 void EpollServer::setClientAuthenticated(int fd, const std::string& userId, const std::string& username) {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    auto it = clients_.find(fd);
-    if (it != clients_.end()) {
-        it->second->authenticated = true;
-        it->second->userId = userId;
-        it->second->username = username.empty() ? userId : username;
-        Logger::info("客户端认证成功: fd=" + std::to_string(fd) + ", userId=" + userId);
+    Reactor* reactor = ownerOf(fd);
+    if (!reactor) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(reactor->mutex);
+    auto it = reactor->connections.find(fd);
+    if (it != reactor->connections.end()) {
+        ClientConnection& client = *it->second;
+        // 同一连接切换账号时先解除旧绑定（持有分片锁，与 closeConnection 的删除互斥）
+        if (client.authenticated && client.userId != userId && sessions_.unbind(client.userId, fd)) {
+            presence_.publish(client.userId, false);
+        }
+        client.authenticated = true;
+        client.userId = userId;
+        client.username = username.empty() ? userId : username;
+        sessions_.bind(userId, fd);
+        presence_.publish(userId, true);
+        LOG_INFO("客户端认证成功: fd=" + std::to_string(fd) + ", userId=" + userId);
     }
 }
 
 std::unique_ptr<ClientInfo> EpollServer::getClientInfo(int fd) {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    auto it = clients_.find(fd);
-    if (it != clients_.end() && it->second->authenticated) {
+    Reactor* reactor = ownerOf(fd);
+    if (!reactor) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(reactor->mutex);
+    auto it = reactor->connections.find(fd);
+    if (it != reactor->connections.end() && it->second->authenticated) {
         auto info = std::make_unique<ClientInfo>();
         info->userId = it->second->userId;
         info->username = it->second->username;
@@ -626,53 +1003,90 @@ std::unique_ptr<ClientInfo> EpollServer::getClientInfo(int fd) {
 }
 
 void EpollServer::sendMessageToUser(const std::string& userId, MessageType type, const std::string& jsonData) {
-    // 先找到目标用户的 fd，然后释放锁再发送消息（避免死锁）
-    int targetFd = -1;
-    {
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        for (auto& [fd, client] : clients_) {
-            if (client->authenticated && client->userId == userId) {
-                targetFd = fd;
-                break;
-            }
+    sendFrameToUser(userId, MessageEncoder::encode(type, jsonData));
+}
+
+void EpollServer::sendFrameToUser(const std::string& userId, Frame frame) {
+    auto client = findUserConnection(userId, sessions_.find(userId));
+    if (client) {
+        LOG_INFO("[转发消息] 发送给用户: userId=", userId, ", fd=", client->fd);
+        submitFrame(client, std::move(frame));
+    } else {
+        LOG_WARN("[转发消息] ✗ 用户不在线: userId=", userId);
+    }
+}
+
+size_t EpollServer::sendFrameToUsers(const std::vector<std::string>& userIds, const Frame& frame) {
+    if (!frame || frame->size() < HEADER_SIZE) {
+        return 0;
+    }
+    // 一次批量查索引，每个分片只加一次锁
+    std::vector<int> fds = sessions_.lookup(userIds);
+    size_t delivered = 0;
+    for (size_t i = 0; i < userIds.size(); ++i) {
+        if (auto client = findUserConnection(userIds[i], fds[i])) {
+            enqueueFrame(client, frame);  // 只增加引用计数
+            delivered++;
         }
     }
-    
-    if (targetFd >= 0) {
-        sendMessage(targetFd, type, jsonData);
-        Logger::info("[转发消息] 发送给用户: userId=" + userId + ", fd=" + std::to_string(targetFd));
-    } else {
-        Logger::warn("[转发消息] ✗ 用户不在线: userId=" + userId);
+    LOG_INFO("[扇出消息] 消息已提交: type=", frameType(*frame), ", bytes=", frame->size(),
+             ", targets=", userIds.size(), ", online=", delivered, ", json=", frameBody(*frame));
+    return delivered;
+}
+
+std::shared_ptr<EpollServer::ClientConnection> EpollServer::findUserConnection(const std::string& userId, int fd) {
+    if (fd < 0) {
+        return nullptr;
+    }
+    Reactor* reactor = ownerOf(fd);
+    if (!reactor) {
+        return nullptr;
     }
+    // 索引查到的 fd 可能已被关闭并复用，核对连接上的用户
+    std::lock_guard<std::mutex> lock(reactor->mutex);
+    auto it = reactor->connections.find(fd);
+    if (it == reactor->connections.end() || !it->second->authenticated || it->second->userId != userId) {
+        return nullptr;
+    }
+    return it->second;
 }
 
 void EpollServer::broadcastMessage(MessageType type, const std::string& jsonData, int excludeFd) {
-    // 先收集所有目标 fd，然后释放锁再发送消息（避免死锁）
-    std::vector<int> targetFds;
-    {
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        for (auto& [fd, client] : clients_) {
+    broadcastFrame(makeFrame(MessageEncoder::encode(type, jsonData)), excludeFd);
+}
+
+void EpollServer::broadcastFrame(const Frame& frame, int excludeFd) {
+    if (!frame || frame->size() < HEADER_SIZE) {
+        return;
+    }
+    // 先收集所有目标连接，然后释放锁再发送消息（避免死锁）
+    std::vector<std::shared_ptr<ClientConnection>> targets;
+    for (auto& reactor : reactors_) {
+        std::lock_guard<std::mutex> lock(reactor->mutex);
+        for (auto& [fd, client] : reactor->connections) {
             if (client->authenticated && fd != excludeFd) {
-                targetFds.push_back(fd);
+                targets.push_back(client);
             }
         }
     }
     
-    // 在锁外发送消息
-    for (int fd : targetFds) {
-        sendMessage(fd, type, jsonData);
+    // 在锁外发送消息，所有连接共享同一帧
+    for (const auto& client : targets) {
+        enqueueFrame(client, frame);
     }
     
-    Logger::info("[广播消息] 发送给 " + std::to_string(targetFds.size()) + " 个用户" +
-                 (excludeFd >= 0 ? " (排除 fd=" + std::to_string(excludeFd) + ")" : ""));
+    LOG_INFO("[广播消息] 发送给 ", targets.size(), " 个用户: exclude_fd=", excludeFd,
+             ", type=", frameType(*frame), ", json=", frameBody(*frame));
 }
 
 std::vector<std::string> EpollServer::getOnlineUsers() {
     std::vector<std::string> users;
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    for (auto& [fd, client] : clients_) {
-        if (client->authenticated) {
-            users.push_back(client->userId);
+    for (auto& reactor : reactors_) {
+        std::lock_guard<std::mutex> lock(reactor->mutex);
+        for (auto& [fd, client] : reactor->connections) {
+            if (client->authenticated) {
+                users.push_back(client->userId);
+            }
         }
     }
     return users;
@@ -680,51 +1094,143 @@ std::vector<std::string> EpollServer::getOnlineUsers() {
 
 std::vector<std::pair<std::string, std::string>> EpollServer::getOnlineUsersWithInfo() {
     std::vector<std::pair<std::string, std::string>> users;
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    for (auto& [fd, client] : clients_) {
-        if (client->authenticated) {
-            users.push_back({client->userId, client->username});
+    for (auto& reactor : reactors_) {
+        std::lock_guard<std::mutex> lock(reactor->mutex);
+        for (auto& [fd, client] : reactor->connections) {
+            if (client->authenticated) {
+                users.push_back({client->userId, client->username});
+            }
         }
     }
     return users;
 }
 
+void EpollServer::setIdleTimeouts(std::chrono::seconds heartbeat, std::chrono::seconds login) {
+    heartbeatTimeout_ = heartbeat;
+    loginTimeout_ = login;
+}
+
+void EpollServer::setRateLimit(uint32_t perSecond, uint32_t burst) {
+    rateLimitPerSecond_ = perSecond;
+    rateLimitBurst_ = burst;
+}
+
+void EpollServer::runAfter(std::chrono::milliseconds delay, std::function<void()> task) {
+    if (reactors_.empty() || !running_) {
+        return;
+    }
+    Reactor& reactor = *reactors_[0];
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(reactor.timerMutex);
+        // 已有待挂任务时 Reactor 已被唤醒过，不必再写
+        wake = reactor.pendingTimers.empty();
+        reactor.pendingTimers.emplace_back(delay, std::move(task));
+    }
+    if (wake && reactor.wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(reactor.wakeFd, &one, sizeof(one));
+        (void)written;  // 计数溢出（EAGAIN）时 Reactor 必然已处于可读状态
+    }
+}
+
+void EpollServer::post(Task task) {
+    threadPool_.submit(std::move(task));
+}
+
+void EpollServer::checkIdle(int fd, uint32_t serial) {
+    // 关闭连接可能发生在工作线程，不在那里取消定时器；fd 已关闭或被新连接复用时直接丢弃
+    Reactor* reactor = ownerOf(fd);
+    if (!reactor) {
+        return;
+    }
+    std::shared_ptr<ClientConnection> client;
+    bool authenticated = false;
+    std::string userId;
+    {
+        std::lock_guard<std::mutex> lock(reactor->mutex);
+        auto it = reactor->connections.find(fd);
+        if (it == reactor->connections.end() || it->second->serial != serial) {
+            return;
+        }
+        client = it->second;
+        authenticated = client->authenticated;
+        userId = authenticated ? client->userId : "(未登录)";
+    }
+    
+    int64_t now = steadyMs();
+    int64_t deadline = INT64_MAX;
+    if (!authenticated && loginTimeout_.count() > 0) {
+        deadline = client->acceptedMs + loginTimeout_.count();
+        if (now >= deadline) {
+            LOG_INFO("登录超时，断开连接: fd=", fd);
+            closeConnection(fd);
+            return;
+        }
+    }
+    if (heartbeatTimeout_.count() > 0) {
+        int64_t expiry = client->lastActiveMs.load(std::memory_order_relaxed) + heartbeatTimeout_.count();
+        if (now >= expiry) {
+            LOG_INFO("心跳超时，断开连接: fd=", fd, ", userId=", userId);
+            closeConnection(fd);
+            return;
+        }
+        deadline = std::min(deadline, expiry);
+    }
+    if (deadline == INT64_MAX) {
+        return;
+    }
+    // 期间有数据到达：按新的截止时间重新挂上（只在到期时做一次，收包路径不碰时间轮）
+    reactor->timers.add(std::chrono::milliseconds(deadline - now), [this, fd, serial] { checkIdle(fd, serial); });
+}
+
 void EpollServer::closeConnection(int fd) {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    auto it = clients_.find(fd);
-    if (it != clients_.end()) {
-        std::string userId = it->second->userId;
-        std::string username = it->second->username;
-        bool authenticated = it->second->authenticated;
-        
+    Reactor* reactor = ownerOf(fd);
+    if (!reactor) {
+        // 连接记录已不存在，可能是重复调用；fd 可能已被新连接复用，不能再关闭
+        return;
+    }
+    
+    std::shared_ptr<ClientConnection> client;
+    {
+        std::lock_guard<std::mutex> lock(reactor->mutex);
+        auto it = reactor->connections.find(fd);
+        if (it == reactor->connections.end()) {
+            return;
+        }
         // 先删除连接记录，避免重复处理
-        clients_.erase(it);
-        
-        if (authenticated && !userId.empty()) {
-            // 已登录用户断开，记录 info 级别日志
-            Logger::info("客户端断开连接: fd=" + std::to_string(fd) + 
-                        ", userId=" + userId + 
-                        ", username=" + username);
-        } else {
-            // 未登录连接断开，使用 debug 级别，减少日志量
-            Logger::debug("客户端断开连接: fd=" + std::to_string(fd) + 
-                         " (未登录)");
+        client = std::move(it->second);
+        reactor->connections.erase(it);
+        fdOwners_[fd].store(0, std::memory_order_release);
+    }
+    reactor->connectionCount.fetch_sub(1, std::memory_order_relaxed);
+    
+    if (client->authenticated) {
+        // 连接记录已删除，userId 不会再被修改；用户在其他连接上仍在线时不算下线
+        if (sessions_.unbind(client->userId, fd)) {
+            presence_.publish(client->userId, false);
         }
-    } else {
-        // 连接记录已不存在，可能是重复调用，不记录日志避免重复
-        // 但仍然需要清理 epoll 和关闭 fd
     }
     
-    // 从 epoll 中移除（如果还在的话）
-    if (epollFd_ >= 0) {
-        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    if (client->authenticated && !client->userId.empty()) {
+        // 已登录用户断开，记录 info 级别日志
+        LOG_INFO("客户端断开连接: fd=" + std::to_string(fd) + 
+                    ", userId=" + client->userId + 
+                    ", username=" + client->username);
+    } else {
+        // 未登录连接断开，使用 debug 级别，减少日志量
+        LOG_DEBUG("客户端断开连接: fd=" + std::to_string(fd) + 
+                     " (未登录)");
     }
     
-    // 关闭文件描述符
-    if (fd >= 0) {
-    close(fd);
+    // 从 epoll 中移除
+    client->closed = true;
+    if (reactor->epollFd >= 0) {
+        epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, fd, nullptr);
     }
+    
+    // 立即断开 TCP；fd 本身在最后一个持有者释放连接对象时关闭
+    shutdown(fd, SHUT_RDWR);
 }
 
 }  // namespace im
-
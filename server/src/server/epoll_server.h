@@ -1,14 +1,30 @@
 #ifndef EPOLL_SERVER_H
 #define EPOLL_SERVER_H
 
-#include <map>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "protocol/decoder.h"
+#include "protocol/encoder.h"
 #include "protocol/message.h"
+#include "server/dedup_window.h"
+#include "server/delivery_tracker.h"
+#include "server/dispatcher.h"
+#include "server/presence_service.h"
+#include "server/session.h"
+#include "server/session_index.h"
+#include "server/timer_wheel.h"
 #include "thread_pool/thread_pool.h"
 
 namespace im {
@@ -23,9 +39,34 @@ struct ClientInfo {
     bool authenticated;
 };
 
+// 单个 Reactor 的运行统计
+struct ReactorStats {
+    int index;                  // Reactor 编号
+    size_t connections;         // 当前连接数
+    uint64_t totalEvents;       // 累计处理的 epoll 事件数
+    uint64_t eventsPerSecond;   // 最近一个采样周期的事件速率
+    size_t queuedBytes;         // 所有连接发送队列中待发送的字节数
+};
+
+// 单个连接的发送队列统计
+struct ConnectionStats {
+    int fd;
+    std::string userId;
+    size_t queuedBytes;         // 发送队列中待发送的字节数
+    bool readPaused;            // 是否因发送队列超过高水位而暂停读取
+};
+
 class EpollServer {
 public:
-    explicit EpollServer(int port = 8888);
+    /**
+     * @param port 监听端口
+     * @param reactorCount Reactor 数量，每个 Reactor 独占一个线程、epoll 和
+     *                     SO_REUSEPORT 监听 Socket（0 表示按 CPU 核数）
+     * @param workerCount 业务线程池的工作线程数（0 表示按 CPU 核数）
+     * @param workStealing 线程池是否启用工作窃取模式
+     */
+    explicit EpollServer(int port = 8888, size_t reactorCount = 1, size_t workerCount = 0,
+                         bool workStealing = false);
     ~EpollServer();
     
     /**
@@ -34,15 +75,69 @@ public:
     bool start();
     
     /**
-     * 停止服务器
+     * 停止服务器（关闭连接、停止线程池），不能在信号处理函数中调用
      */
     void stop();
     
+    /**
+     * 请求事件循环退出：只设置标志并写各 Reactor 的唤醒 eventfd，异步信号安全，
+     * 可在信号处理函数中调用；run() 返回后由调用线程执行 stop()
+     */
+    void requestStop();
+    
     /**
      * 运行事件循环
      */
     void run();
     
+    /**
+     * 设置连接超时（需在 start() 之前调用，0 表示不检查）
+     *
+     * @param heartbeat 连续这么久没有收到任何数据（含心跳）即断开
+     * @param login 建立连接后这么久仍未登录即断开
+     */
+    void setIdleTimeouts(std::chrono::seconds heartbeat, std::chrono::seconds login);
+    
+    /**
+     * 设置按连接限流（需在 start() 之前调用，0 表示不限流）：每秒 perSecond 个请求，
+     * 允许突发 burst 个；心跳、登出和投递确认不计入
+     */
+    void setRateLimit(uint32_t perSecond, uint32_t burst);
+    
+    /**
+     * 设置在线状态推送的合并窗口（需在 start() 之前调用），0 表示不推送
+     */
+    void setPresenceWindow(std::chrono::milliseconds window) { presence_.setWindow(window); }
+    
+    /**
+     * 设置在线状态推送的受众来源（需在 start() 之前调用），默认查库
+     */
+    void setPresenceAudience(PresenceService::AudienceResolver resolver) {
+        presence_.setAudienceResolver(std::move(resolver));
+    }
+    
+    PresenceStats getPresenceStats() const { return presence_.getStats(); }
+        
+    /**
+     * 延时任务：delay 之后在 Reactor 0 的线程中执行，精度为一个时间轮刻度
+     *
+     * 任务不能阻塞（会拖慢该 Reactor 的所有连接）；服务器停止时未执行的任务直接丢弃
+     */
+    void runAfter(std::chrono::milliseconds delay, std::function<void()> task);
+    
+    /**
+     * 在业务线程池中执行任务（可以阻塞，如访问数据库）；服务器停止后丢弃
+     */
+    void post(Task task);
+    
+    /**
+     * 把连接的一个请求交给数据库执行器：执行期间该连接暂停处理，
+     * 完成后回到线程池继续处理后续的包。执行器队列已满时返回 false
+     *
+     * 处理器中途需要查库时也可调用，把剩余处理作为 job 交出（需先确认执行器在运行）
+     */
+    bool deferToDatabase(const Session& session, Task job);
+        
     /**
      * 设置客户端认证状态
      */
@@ -58,16 +153,64 @@ public:
      */
     void sendMessage(int fd, MessageType type, const std::string& jsonData);
     
+    /**
+     * 发送已编码的完整帧（如 JsonWriter::finish() 的结果），不再复制数据体
+     */
+    void sendFrame(int fd, Frame frame);
+    void sendFrame(int fd, std::vector<uint8_t> frame) { sendFrame(fd, makeFrame(std::move(frame))); }
+    
     /**
      * 发送消息给指定用户
      */
     void sendMessageToUser(const std::string& userId, MessageType type, const std::string& jsonData);
     
+    /**
+     * 发送已编码的完整帧给指定用户
+     */
+    void sendFrameToUser(const std::string& userId, Frame frame);
+    void sendFrameToUser(const std::string& userId, std::vector<uint8_t> frame) {
+        sendFrameToUser(userId, makeFrame(std::move(frame)));
+    }
+    
+    /**
+     * 发送同一帧给多个用户（群消息扇出），跳过不在线的用户
+     *
+     * 各接收方共享同一份帧，不再按人复制；日志只记录一条汇总
+     *
+     * @return 实际提交的用户数
+     */
+    size_t sendFrameToUsers(const std::vector<std::string>& userIds, const Frame& frame);
+    
     /**
      * 广播消息（排除发送者）
      */
     void broadcastMessage(MessageType type, const std::string& jsonData, int excludeFd = -1);
     
+    /**
+     * 广播已编码的完整帧（排除发送者）
+     */
+    void broadcastFrame(const Frame& frame, int excludeFd = -1);
+    
+    /**
+     * 在线用户索引（isOnline / lookup）
+     */
+    const SessionIndex& sessions() const { return sessions_; }
+    
+    /**
+     * 发送去重窗口：(发送者, client_msg_id) -> msg_id
+     */
+    DedupWindow& sendDedup() { return sendDedup_; }
+    
+    /**
+     * 已投递、待接收方确认的消息，重连后重发
+     */
+    DeliveryTracker& deliveries() { return deliveries_; }
+    
+    /**
+     * 关闭客户端连接
+     */
+    void closeConnection(int fd);
+    
     /**
      * 获取所有在线用户ID
      */
@@ -77,31 +220,127 @@ public:
      * 获取所有在线用户的完整信息（userId, username）
      */
     std::vector<std::pair<std::string, std::string>> getOnlineUsersWithInfo();
+    
+    /**
+     * 获取各 Reactor 的连接数与事件速率
+     */
+    std::vector<ReactorStats> getReactorStats();
+    
+    /**
+     * 获取各连接的发送队列积压情况
+     */
+    std::vector<ConnectionStats> getConnectionStats();
 
 private:
+    // 客户端连接管理：会话部分（fd 与登录身份）直接交给分发层和处理器
+    struct ClientConnection : Session {
+        MessageDecoder decoder;
+                
+        // 串行执行：同一连接同一时刻只有一个工作线程在读取和处理，保证包序
+        std::atomic<bool> reading{false};      // 是否已有任务在处理该连接
+        std::atomic<bool> readPending{false};  // 处理期间是否又收到可读事件
+        std::atomic<bool> closed{false};
+        
+        // 发送队列：按帧排队，EPOLLOUT 时由所属 Reactor 用 writev 批量刷出
+        std::mutex writeMutex;
+        std::deque<Frame> outQueue;            // 扇出时多个连接共享同一帧
+        size_t outOffset = 0;                  // 队首帧已发送的字节数
+        std::atomic<size_t> queuedBytes{0};
+        std::atomic<bool> readPaused{false};   // 发送积压超过高水位时暂停读取
+        std::atomic<bool> dbPending{false};    // 有请求在数据库执行器中，完成前不读取、不处理后续的包
+        
+        // 超时检查：工作线程只更新活跃时间，由所属 Reactor 的时间轮到期时核对
+        uint32_t serial = 0;                   // 连接序号，fd 被复用后旧定时器据此失效
+        int64_t acceptedMs = 0;
+        std::atomic<int64_t> lastActiveMs{0};
+                
+        // fd 随连接对象一起释放，避免工作线程仍在使用时 fd 被新连接复用
+        ~ClientConnection();
+    };
+    
+    // 心跳快速路径：Reactor 线程单次读取的暂存区大小；心跳响应 {"timestamp":秒} 定长
+    static constexpr size_t INLINE_READ_SIZE = 4096;
+    static constexpr size_t HEARTBEAT_BODY_SIZE = sizeof(R"({"timestamp":0000000000})") - 1;
+    
+    // 每个 Reactor 拥有独立的监听 Socket、epoll 和连接分片，
+    // 分片锁只在本 Reactor 的连接之间竞争
+    struct Reactor {
+        int index = 0;
+        int listenFd = -1;
+        int epollFd = -1;
+        std::thread thread;
+        
+        std::unordered_map<int, std::shared_ptr<ClientConnection>> connections;
+        std::mutex mutex;
+        
+        std::atomic<size_t> connectionCount{0};
+        std::atomic<uint64_t> eventCount{0};
+        std::atomic<uint64_t> eventsPerSecond{0};
+        
+        // 时间轮只在本 Reactor 线程中访问；其他线程提交的延时任务先放进 pendingTimers，
+        // 再写 wakeFd（eventfd）唤醒 epoll_wait，使新任务不必等到原定的超时
+        TimerWheel timers;
+        int wakeFd = -1;
+        std::mutex timerMutex;
+        std::vector<std::pair<std::chrono::milliseconds, std::function<void()>>> pendingTimers;
+        
+        // 心跳快速路径（只在本 Reactor 线程中访问）：预编码的响应帧，时间戳按秒原地改写
+        std::array<uint8_t, INLINE_READ_SIZE> readScratch;
+        std::array<uint8_t, HEADER_SIZE + HEARTBEAT_BODY_SIZE> heartbeatFrame;
+        time_t heartbeatSecond = 0;
+    };
+    
     int port_;
-    int serverFd_;
-    int epollFd_;
-    bool running_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stopRequested_{false};  // requestStop 设置，事件循环看到后退出
     
     ThreadPool threadPool_;
     
-    // 客户端连接管理
-    struct ClientConnection {
-        int fd;
-        MessageDecoder decoder;
-        std::string userId;
-        std::string username;
-        bool authenticated;
-    };
+    std::vector<std::unique_ptr<Reactor>> reactors_;
     
-    std::map<int, std::unique_ptr<ClientConnection>> clients_;
-    std::mutex clientsMutex_;
+    // fd -> 所属 Reactor 编号 + 1（0 表示无主），按 fd 直接索引，无需加锁
+    std::unique_ptr<std::atomic<int>[]> fdOwners_;
+    size_t fdOwnerCapacity_;
+    
+    // userId -> fd，登录时建立，断开时删除
+    SessionIndex sessions_;
+    
+    DedupWindow sendDedup_;
+    DeliveryTracker deliveries_;
+    PresenceService presence_{*this};
+    
+    std::chrono::milliseconds heartbeatTimeout_;
+    std::chrono::milliseconds loginTimeout_;
+    std::atomic<uint32_t> connectionSerial_{0};
+    
+    Dispatcher dispatcher_;
+    uint32_t rateLimitPerSecond_ = 0;
+    uint32_t rateLimitBurst_ = 0;
+        
+    /**
+     * 为 Reactor 创建监听 Socket（多 Reactor 时启用 SO_REUSEPORT）
+     */
+    bool createServerSocket(Reactor& reactor);
+    
+    /**
+     * 运行单个 Reactor 的事件循环
+     */
+    void runReactor(Reactor& reactor);
     
     /**
-     * 创建服务器 Socket
+     * 根据 fd 找到所属 Reactor
      */
-    bool createServerSocket();
+    Reactor* ownerOf(int fd);
+    
+    /**
+     * 在所属分片中查找连接
+     */
+    std::shared_ptr<ClientConnection> findConnection(int fd);
+    
+    /**
+     * 按索引查到的 fd 取连接，并核对连接仍属于该用户
+     */
+    std::shared_ptr<ClientConnection> findUserConnection(const std::string& userId, int fd);
     
     /**
      * 设置 Socket 为非阻塞
@@ -111,22 +350,66 @@ private:
     /**
      * 接受新连接
      */
-    void acceptConnection();
+    void acceptConnection(Reactor& reactor);
     
     /**
-     * 处理客户端数据
+     * 调度连接的读任务（已有任务在运行时只标记待读）
      */
-    void handleClientData(int fd);
+    void scheduleRead(const std::shared_ptr<ClientConnection>& client);
     
     /**
-     * 关闭客户端连接
+     * 可读事件：空闲连接先在 Reactor 线程读一次，读到的全是心跳时就地应答，
+     * 否则把数据转入解码器、交给线程池（已有任务在处理时同 scheduleRead）
      */
-    void closeConnection(int fd);
+    void handleReadable(Reactor& reactor, const std::shared_ptr<ClientConnection>& client);
+    
+    /**
+     * 在 Reactor 线程直接写出心跳响应：发送锁空闲且队列为空时直接 send，未写完的部分按发送队列的
+     * 水位规则入队；发送锁被占用时交给线程池入队（这时才复制帧），Reactor 不等锁
+     */
+    void sendHeartbeatInline(Reactor& reactor, const std::shared_ptr<ClientConnection>& client);
+    
+    /**
+     * 处理客户端数据：循环读取直到 EAGAIN，按序解码并处理
+     */
+    void handleClientData(const std::shared_ptr<ClientConnection>& client);
+    
+    /**
+     * 将编码好的帧加入连接的发送队列（队列为空时先尝试直接发送）
+     */
+    void enqueueFrame(const std::shared_ptr<ClientConnection>& client, Frame frame);
+    
+    /**
+     * 帧入队、计入积压字节并检查水位（调用方需持有 writeMutex）：队列原本为空时先尝试直接发送，
+     * 超过高水位暂停读取；返回 false 表示发送出错或超过硬上限，调用方释放锁后断开连接
+     */
+    bool queueFrameLocked(ClientConnection& client, Frame frame);
+    
+    /**
+     * 记录发送日志并入队
+     */
+    void submitFrame(const std::shared_ptr<ClientConnection>& client, Frame frame);
+    
+    /**
+     * 刷出发送队列（调用方需持有 writeMutex），返回 false 表示连接出错
+     */
+    bool flushQueueLocked(ClientConnection& client);
+    
+    /**
+     * 处理 EPOLLOUT：刷出发送队列，积压降到低水位以下时恢复读取
+     */
+    void handleWritable(const std::shared_ptr<ClientConnection>& client);
+    
+    /**
+     * 连接超时检查（时间轮回调，在所属 Reactor 线程中执行）：
+     * 超时则断开，否则按最近的截止时间重新挂上
+     */
+    void checkIdle(int fd, uint32_t serial);
     
     /**
-     * 处理消息
+     * 处理消息：经中间件后交给路由表中的处理器
      */
-    void processMessage(int fd, const Packet& packet);
+    void processMessage(Session& session, const PacketView& packet);
 };
 
 }  // namespace im
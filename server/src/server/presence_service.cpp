@@ -0,0 +1,201 @@
+#include "presence_service.h"
+#include "server/epoll_server.h"
+#include "protocol/json_writer.h"
+#include "database/batch_statement.h"
+#include "database/database.h"
+#include "database/db_executor.h"
+#include "database/group_roster_cache.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <map>
+
+namespace im {
+
+void PresenceService::publish(const std::string& userId, bool online) {
+    if (window_.count() <= 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.published;
+        if (!pending_.insert_or_assign(userId, online).second) {
+            ++stats_.coalesced;  // 窗口内已有变化，只保留最新状态
+        }
+        if (scheduled_) {
+            return;
+        }
+        scheduled_ = true;
+    }
+    server_.runAfter(window_, [this] { schedule(); });
+}
+
+PresenceStats PresenceService::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PresenceService::schedule() {
+    DbExecutor& executor = DbExecutor::getInstance();
+    if (!executor.isRunning()) {
+        server_.post([this] { flush(); });
+        return;
+    }
+    if (!executor.submit([this] { flush(); })) {
+        // 数据库执行器繁忙：变化留在待推送表中继续合并，下个窗口再试
+        LOG_WARN("[在线状态] 数据库执行器队列已满，推送延后一个窗口");
+        server_.runAfter(window_, [this] { schedule(); });
+    }
+}
+
+void PresenceService::flush() {
+    std::vector<Change> changes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changes.reserve(pending_.size());
+        for (const auto& [userId, online] : pending_) {
+            bool wasOnline = announced_.count(userId) > 0;
+            if (wasOnline == online) {
+                ++stats_.coalesced;  // 如窗口内断开后又重连
+                continue;
+            }
+            if (online) {
+                announced_.insert(userId);
+            } else {
+                announced_.erase(userId);
+            }
+            changes.push_back({userId, online});
+        }
+        pending_.clear();
+    }
+
+    if (!changes.empty()) {
+        deliver(changes);
+    }
+
+    bool again;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        again = !pending_.empty();
+        scheduled_ = again;
+    }
+    if (again) {
+        server_.runAfter(window_, [this] { schedule(); });
+    }
+}
+
+void PresenceService::deliver(const std::vector<Change>& changes) {
+    // 接收方 -> 需要告知的变化下标
+    std::unordered_map<std::string, std::vector<uint32_t>> audience;
+    if (audienceResolver_) {
+        for (uint32_t i = 0; i < changes.size(); ++i) {
+            for (auto& recipient : audienceResolver_(changes[i].userId)) {
+                audience[std::move(recipient)].push_back(i);
+            }
+        }
+    } else if (!loadAudience(changes, audience)) {
+        return;
+    }
+
+    // 只给在线的接收方推送；好友与同群可能重复，按变化集合归组，同组共享一帧
+    std::vector<std::string> recipients;
+    recipients.reserve(audience.size());
+    for (const auto& entry : audience) {
+        recipients.push_back(entry.first);
+    }
+    std::vector<int> fds = server_.sessions().lookup(recipients);
+    std::map<std::vector<uint32_t>, std::vector<std::string>> batches;
+    for (size_t i = 0; i < recipients.size(); ++i) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        std::vector<uint32_t>& indices = audience[recipients[i]];
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+        batches[std::move(indices)].push_back(std::move(recipients[i]));
+    }
+
+    uint64_t notifies = 0;
+    uint64_t bytes = 0;
+    for (const auto& [indices, users] : batches) {
+        JsonWriter notify(MessageType::PRESENCE_NOTIFY, 32 + indices.size() * 48);
+        notify.beginObject().key("changes").beginArray();
+        for (uint32_t index : indices) {
+            notify.beginObject()
+                .field("user_id", changes[index].userId)
+                .field("online", changes[index].online)
+                .endObject();
+        }
+        notify.endArray().endObject();
+        Frame frame = makeFrame(notify.finish());
+        size_t delivered = server_.sendFrameToUsers(users, frame);
+        notifies += delivered;
+        bytes += delivered * frame->size();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.changes += changes.size();
+    stats_.flushes++;
+    stats_.notifies += notifies;
+    stats_.bytes += bytes;
+}
+
+bool PresenceService::loadAudience(const std::vector<Change>& changes,
+                                   std::unordered_map<std::string, std::vector<uint32_t>>& audience) {
+    PooledConnection conn = Database::getInstance().acquire();
+    if (!conn) {
+        LOG_WARN("[在线状态] 数据库未连接，丢弃 ", changes.size(), " 条状态变化");
+        return false;
+    }
+
+    std::unordered_map<std::string, uint32_t> indexOf;
+    std::vector<std::string_view> userIds;
+    userIds.reserve(changes.size());
+    for (uint32_t i = 0; i < changes.size(); ++i) {
+        indexOf.emplace(changes[i].userId, i);
+        userIds.push_back(changes[i].userId);
+    }
+
+    // 好友：只通知未被本人拉黑的好友
+    static const BatchStatement selectFriends(
+        "SELECT user_id, friend_user_id FROM friends WHERE is_blocked = 0 AND user_id IN (", "?", ")");
+    bool ok = selectFriends.execute(conn, userIds, [&](PreparedStatement& stmt) {
+        while (stmt.fetch()) {
+            auto it = indexOf.find(std::string(stmt.getString(0)));
+            if (it != indexOf.end()) {
+                audience[std::string(stmt.getString(1))].push_back(it->second);
+            }
+        }
+    });
+
+    // 同群成员：先取出所在的群，语句结束后再从群成员缓存取名单
+    static const BatchStatement selectGroups("SELECT user_id, group_id FROM group_members WHERE user_id IN (",
+                                             "?", ")");
+    std::vector<std::pair<uint32_t, std::string>> memberships;
+    ok = selectGroups.execute(conn, userIds, [&](PreparedStatement& stmt) {
+        while (stmt.fetch()) {
+            auto it = indexOf.find(std::string(stmt.getString(0)));
+            if (it != indexOf.end()) {
+                memberships.emplace_back(it->second, std::string(stmt.getString(1)));
+            }
+        }
+    }) && ok;
+    if (!ok) {
+        LOG_ERROR("[在线状态] 查询好友或群成员失败，本批只推送已查到的接收方");
+    }
+
+    GroupRosterCache& rosters = GroupRosterCache::getInstance();
+    for (const auto& [index, groupId] : memberships) {
+        GroupRosterPtr roster = rosters.get(groupId, &conn);
+        if (!roster) {
+            continue;
+        }
+        for (const auto& memberId : roster->userIds) {
+            if (memberId != changes[index].userId) {
+                audience[memberId].push_back(index);
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace im
@@ -0,0 +1,105 @@
+#ifndef PRESENCE_SERVICE_H
+#define PRESENCE_SERVICE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace im {
+
+class EpollServer;
+
+/**
+ * 在线状态推送统计
+ */
+struct PresenceStats {
+    uint64_t published = 0;   // 登录/下线事件数
+    uint64_t coalesced = 0;   // 窗口内被合并或与上次推送相同而未推送的事件数
+    uint64_t changes = 0;     // 实际推送的状态变化数
+    uint64_t flushes = 0;     // 推送批次数
+    uint64_t notifies = 0;    // 发出的 PRESENCE_NOTIFY 帧数（在线接收方）
+    uint64_t bytes = 0;       // 发出的字节数
+};
+
+/**
+ * 在线状态推送：用户上线/下线时只通知其好友与同群成员，取代客户端轮询 USER_LIST_REQUEST
+ *
+ * - publish 只记录待推送表中该用户的最新状态，窗口内第一次变化时安排一次推送；
+ *   窗口内反复登录/断开只保留最后状态，与上次推送的状态相同则不推送
+ * - 推送时按批查库得到受众（好友一次 IN 查询、所在群一次 IN 查询 + 群成员缓存），
+ *   每个在线接收方一个窗口只收一帧 PRESENCE_NOTIFY；变化集合相同的接收方共享同一帧
+ * - 推送在数据库执行器（未启用时在业务线程池）中执行，同一时刻最多一批，保证先后顺序
+ */
+class PresenceService {
+public:
+    /**
+     * 给出某用户状态变化的受众（可含不在线的用户）
+     */
+    using AudienceResolver = std::function<std::vector<std::string>(const std::string& userId)>;
+
+    explicit PresenceService(EpollServer& server) : server_(server) {}
+
+    /**
+     * 设置合并窗口（需在 start() 之前调用），0 表示不推送
+     */
+    void setWindow(std::chrono::milliseconds window) { window_ = window; }
+
+    /**
+     * 用 resolver 代替查库得到受众（测试与基准在没有 MySQL 时使用），需在 start() 之前调用
+     */
+    void setAudienceResolver(AudienceResolver resolver) { audienceResolver_ = std::move(resolver); }
+
+    /**
+     * 记录用户上线/下线
+     */
+    void publish(const std::string& userId, bool online);
+
+    PresenceStats getStats() const;
+
+private:
+    struct Change {
+        std::string userId;
+        bool online;
+    };
+
+    /**
+     * 窗口到期（Reactor 0 线程）：把推送交给数据库执行器，队列满时下个窗口再试
+     */
+    void schedule();
+
+    /**
+     * 取出待推送表并推送，结束后若又有新变化则安排下一批
+     */
+    void flush();
+
+    void deliver(const std::vector<Change>& changes);
+
+    /**
+     * 查库得到受众：好友（一次 IN 查询）与同群成员（一次 IN 查询 + 群成员缓存）
+     *
+     * @return 数据库不可用时返回 false
+     */
+    bool loadAudience(const std::vector<Change>& changes,
+                      std::unordered_map<std::string, std::vector<uint32_t>>& audience);
+
+    EpollServer& server_;
+    std::chrono::milliseconds window_{200};
+    AudienceResolver audienceResolver_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, bool> pending_;  // 窗口内各用户的最新状态
+    std::unordered_set<std::string> announced_;      // 最近一次推送为在线的用户
+    bool scheduled_ = false;                         // 已安排或正在推送
+
+    PresenceStats stats_;
+};
+
+}  // namespace im
+
+#endif  // PRESENCE_SERVICE_H
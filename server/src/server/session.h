@@ -0,0 +1,29 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <cstdint>
+#include <string>
+
+namespace im {
+
+/**
+ * 连接会话：分发时交给中间件和处理器，已登录的连接直接带着身份，不必再按 fd 查连接
+ *
+ * 身份字段只在登录时由 setClientAuthenticated 修改（持有分片锁）；同一连接的数据包
+ * 由一个工作线程串行处理，交给数据库执行器的请求（包括登录）完成之前该连接不处理后续的包，
+ * 因此处理器读取时无需加锁。
+ */
+struct Session {
+    int fd = -1;
+    std::string userId;
+    std::string username;
+    bool authenticated = false;
+
+    // 限流中间件的令牌桶，只由正在处理该连接的线程访问
+    double rateTokens = 0;
+    int64_t rateRefillMs = 0;
+};
+
+}  // namespace im
+
+#endif  // SESSION_H
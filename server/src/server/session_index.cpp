@@ -0,0 +1,76 @@
+#include "session_index.h"
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
+
+namespace im {
+
+void SessionIndex::bind(const std::string& userId, int fd) {
+    Shard& shard = shards_[shardOf(userId)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto result = shard.users.insert_or_assign(userId, fd);
+    if (result.second) {
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool SessionIndex::unbind(const std::string& userId, int fd) {
+    Shard& shard = shards_[shardOf(userId)];
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    if (it != shard.users.end() && it->second == fd) {
+        shard.users.erase(it);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+int SessionIndex::find(const std::string& userId) const {
+    const Shard& shard = shards_[shardOf(userId)];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    return it != shard.users.end() ? it->second : -1;
+}
+
+std::vector<int> SessionIndex::lookup(const std::vector<std::string>& userIds) const {
+    std::vector<int> fds(userIds.size(), -1);
+    if (userIds.empty()) {
+        return fds;
+    }
+
+    // 计数排序：按分片把下标归到一起
+    std::vector<uint8_t> shardIds(userIds.size());
+    std::array<uint32_t, SHARD_COUNT + 1> offsets{};
+    for (size_t i = 0; i < userIds.size(); ++i) {
+        shardIds[i] = static_cast<uint8_t>(shardOf(userIds[i]));
+        offsets[shardIds[i] + 1]++;
+    }
+    for (size_t s = 0; s < SHARD_COUNT; ++s) {
+        offsets[s + 1] += offsets[s];
+    }
+    std::vector<uint32_t> order(userIds.size());
+    std::array<uint32_t, SHARD_COUNT> cursor;
+    std::copy(offsets.begin(), offsets.end() - 1, cursor.begin());
+    for (size_t i = 0; i < userIds.size(); ++i) {
+        order[cursor[shardIds[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    for (size_t s = 0; s < SHARD_COUNT; ++s) {
+        if (offsets[s] == offsets[s + 1]) {
+            continue;
+        }
+        const Shard& shard = shards_[s];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (uint32_t k = offsets[s]; k < offsets[s + 1]; ++k) {
+            uint32_t i = order[k];
+            auto it = shard.users.find(userIds[i]);
+            if (it != shard.users.end()) {
+                fds[i] = it->second;
+            }
+        }
+    }
+    return fds;
+}
+
+}  // namespace im
@@ -0,0 +1,75 @@
+#ifndef SESSION_INDEX_H
+#define SESSION_INDEX_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace im {
+
+/**
+ * 在线用户索引：userId -> fd
+ *
+ * 按 userId 哈希分成固定数量的分片，每个分片一把读写锁；投递消息只取读锁，
+ * 登录/断开才取写锁，不同分片之间互不竞争。同一用户重复登录时以最后一次为准。
+ *
+ * 索引只用于快速定位，fd 可能在查到之后被关闭并复用，调用方发送前
+ * 仍需核对连接上的 userId。
+ */
+class SessionIndex {
+public:
+    static constexpr size_t SHARD_COUNT = 64;  // 必须是 2 的幂
+
+    /**
+     * 绑定用户与连接（覆盖该用户之前的绑定）
+     */
+    void bind(const std::string& userId, int fd);
+
+    /**
+     * 解除绑定；只有当前绑定的仍是该 fd 时才删除，避免误删重新登录后的新连接
+     *
+     * @return 是否删除（用户已没有其他连接在线）
+     */
+    bool unbind(const std::string& userId, int fd);
+
+    /**
+     * @return 用户所在连接的 fd，不在线返回 -1
+     */
+    int find(const std::string& userId) const;
+
+    bool isOnline(const std::string& userId) const { return find(userId) >= 0; }
+
+    /**
+     * 批量查找，结果与 userIds 一一对应，不在线的为 -1
+     *
+     * 先按分片归类，每个分片只加一次读锁，适合群消息扇出
+     */
+    std::vector<int> lookup(const std::vector<std::string>& userIds) const;
+
+    /**
+     * 在线用户数
+     */
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    // 每个分片独占缓存行，避免相邻分片的锁互相伪共享
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, int> users;
+    };
+
+    static size_t shardOf(const std::string& userId) {
+        return std::hash<std::string>()(userId) & (SHARD_COUNT - 1);
+    }
+
+    std::array<Shard, SHARD_COUNT> shards_;
+    std::atomic<size_t> size_{0};
+};
+
+}  // namespace im
+
+#endif  // SESSION_INDEX_H
@@ -0,0 +1,192 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+namespace im {
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, Clock::time_point start)
+    : tick_(std::max(tick, std::chrono::milliseconds(1))), start_(start) {
+    heads_.fill(NIL);
+}
+
+uint32_t TimerWheel::allocate() {
+    if (freeList_ != NIL) {
+        uint32_t index = freeList_;
+        freeList_ = nodes_[index].next;
+        return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& node = nodes_[index];
+    node.callback = nullptr;
+    node.slot = NIL;
+    node.prev = NIL;
+    node.next = freeList_;
+    // 代数递增使旧 TimerId 失效（跳过 0，保证 TimerId 非 0）
+    if (++node.generation == 0) {
+        node.generation = 1;
+    }
+    freeList_ = index;
+}
+
+TimerWheel::Node* TimerWheel::lookup(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    if (index >= nodes_.size()) {
+        return nullptr;
+    }
+    Node& node = nodes_[index];
+    if (node.slot == NIL || node.generation != static_cast<uint32_t>(id >> 32)) {
+        return nullptr;
+    }
+    return &node;
+}
+
+void TimerWheel::link(uint32_t index) {
+    Node& node = nodes_[index];
+    uint64_t delta = node.expire - current_;
+    if (delta >= MAX_SPAN) {
+        node.expire = current_ + MAX_SPAN - 1;
+        delta = MAX_SPAN - 1;
+    }
+
+    uint32_t slot;
+    if (delta < (uint64_t(1) << ROOT_BITS)) {
+        slot = static_cast<uint32_t>(node.expire & ((1u << ROOT_BITS) - 1));
+    } else {
+        int level = 1;
+        while (delta >= (uint64_t(1) << (ROOT_BITS + LEVEL_BITS * level))) {
+            ++level;
+        }
+        int shift = ROOT_BITS + LEVEL_BITS * (level - 1);
+        slot = (1u << ROOT_BITS) + (level - 1) * (1u << LEVEL_BITS) +
+               static_cast<uint32_t>((node.expire >> shift) & ((1u << LEVEL_BITS) - 1));
+    }
+
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = heads_[slot];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = index;
+    }
+    heads_[slot] = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.slot] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+}
+
+TimerWheel::TimerId TimerWheel::add(std::chrono::milliseconds delay, Callback callback) {
+    uint64_t ticks = delay.count() <= 0 ? 1 : (delay.count() + tick_.count() - 1) / tick_.count();
+    uint32_t index = allocate();
+    Node& node = nodes_[index];
+    node.expire = current_ + ticks;
+    node.callback = std::move(callback);
+    link(index);
+    ++size_;
+    return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::reschedule(TimerId id, std::chrono::milliseconds delay) {
+    Node* node = lookup(id);
+    if (!node) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(id);
+    uint64_t ticks = delay.count() <= 0 ? 1 : (delay.count() + tick_.count() - 1) / tick_.count();
+    unlink(index);
+    nodes_[index].expire = current_ + ticks;
+    link(index);
+    return true;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    if (!lookup(id)) {
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(id);
+    unlink(index);
+    release(index);
+    --size_;
+    return true;
+}
+
+void TimerWheel::cascade(int level, uint32_t slot) {
+    uint32_t head = (1u << ROOT_BITS) + (level - 1) * (1u << LEVEL_BITS) + slot;
+    uint32_t index = heads_[head];
+    heads_[head] = NIL;
+    while (index != NIL) {
+        uint32_t next = nodes_[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void TimerWheel::tick() {
+    uint64_t now = ++current_;
+
+    // 第 0 层转完一圈时，从高层依次下放当前槽
+    if ((now & ((1u << ROOT_BITS) - 1)) == 0) {
+        for (int level = 1; level < LEVELS; ++level) {
+            int shift = ROOT_BITS + LEVEL_BITS * (level - 1);
+            uint32_t slot = static_cast<uint32_t>((now >> shift) & ((1u << LEVEL_BITS) - 1));
+            cascade(level, slot);
+            if (slot != 0) {
+                break;
+            }
+        }
+    }
+}
+
+size_t TimerWheel::advance(Clock::time_point now) {
+    if (now < start_) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>((now - start_) / tick_);
+    size_t fired = 0;
+    while (current_ < target) {
+        if (size_ == 0) {
+            current_ = target;
+            break;
+        }
+        tick();
+
+        // 逐个摘下执行：回调新加的定时器至少晚一个刻度，不会落回当前槽
+        uint32_t slot = static_cast<uint32_t>(current_ & ((1u << ROOT_BITS) - 1));
+        while (heads_[slot] != NIL) {
+            uint32_t index = heads_[slot];
+            unlink(index);
+            Callback callback = std::move(nodes_[index].callback);
+            release(index);
+            --size_;
+            ++fired;
+            callback();
+        }
+    }
+    return fired;
+}
+
+int TimerWheel::timeoutMs(Clock::time_point now, int maxMs) const {
+    if (size_ == 0) {
+        return maxMs;
+    }
+    auto next = start_ + tick_ * static_cast<int64_t>(current_ + 1);
+    if (next <= now) {
+        return 0;
+    }
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(next - now).count();
+    return static_cast<int>(std::min<int64_t>(remaining, maxMs));
+}
+
+}  // namespace im
@@ -0,0 +1,114 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace im {
+
+/**
+ * 分层时间轮：挂在 Reactor 的事件循环上，由 epoll_wait 的超时驱动
+ *
+ * 第 0 层 256 个槽，每槽一个刻度；第 1~3 层各 64 个槽，每槽覆盖下一层一整圈，
+ * 到点时整槽下放到低层。添加、重设、取消都是 O(1)（按下标的双向链表），
+ * 推进时只处理到期槽。超出最大跨度（256 * 64^3 个刻度）的定时器按最大跨度处理。
+ *
+ * 非线程安全：只能在所属 Reactor 线程中使用。
+ */
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    // 高 32 位为代数，低 32 位为节点下标；0 表示无效
+    using TimerId = uint64_t;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(100),
+                        Clock::time_point start = Clock::now());
+
+    /**
+     * 添加定时器，delay 向上取整到刻度，至少一个刻度
+     */
+    TimerId add(std::chrono::milliseconds delay, Callback callback);
+
+    /**
+     * 重新设置到期时间（回调不变）
+     *
+     * @return 定时器已到期或已取消时返回 false
+     */
+    bool reschedule(TimerId id, std::chrono::milliseconds delay);
+
+    /**
+     * 取消定时器
+     *
+     * @return 定时器已到期或已取消时返回 false
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * 推进到 now，依次执行到期回调（回调中可以添加或取消定时器）
+     *
+     * @return 执行的回调数
+     */
+    size_t advance(Clock::time_point now);
+
+    /**
+     * 距下一个刻度的毫秒数，用作 epoll_wait 超时；没有定时器时返回 maxMs
+     */
+    int timeoutMs(Clock::time_point now, int maxMs) const;
+
+    /**
+     * 当前挂着的定时器数
+     */
+    size_t size() const { return size_; }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr int ROOT_BITS = 8;
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int LEVELS = 4;
+    static constexpr uint64_t MAX_SPAN = uint64_t(1) << (ROOT_BITS + LEVEL_BITS * (LEVELS - 1));
+
+    struct Node {
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t generation = 1;
+        uint32_t slot = NIL;      // 所在槽的全局下标，NIL 表示空闲
+        uint64_t expire = 0;      // 到期刻度
+        Callback callback;
+    };
+
+    uint32_t allocate();
+    void release(uint32_t index);
+    Node* lookup(TimerId id);
+
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+
+    /**
+     * 把第 level 层第 slot 槽的定时器按剩余时间重新挂到低层
+     */
+    void cascade(int level, uint32_t slot);
+
+    void tick();
+
+    std::chrono::milliseconds tick_;
+    Clock::time_point start_;
+    uint64_t current_ = 0;  // 已处理到的刻度
+    size_t size_ = 0;
+
+    std::vector<Node> nodes_;
+    uint32_t freeList_ = NIL;
+
+    // 各层槽的链表头，按 ROOT 槽在前、各层依次排列
+    static constexpr size_t SLOT_COUNT = (size_t(1) << ROOT_BITS) + (LEVELS - 1) * (size_t(1) << LEVEL_BITS);
+    std::array<uint32_t, SLOT_COUNT> heads_;
+};
+
+}  // namespace im
+
+#endif  // TIMER_WHEEL_H
@@ -0,0 +1,648 @@
+#include "message_store.h"
+#include "utils/logger.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+namespace im {
+
+namespace {
+
+constexpr uint32_t SEGMENT_MAGIC = 0x47534D49;  // "IMSG"
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr size_t SEGMENT_HEADER_SIZE = 16;      // magic(4) version(4) id(4) reserved(4)
+constexpr size_t RECORD_HEADER_SIZE = 32;
+constexpr size_t RECORD_ALIGN = 8;
+constexpr size_t CRC_OFFSET = 8;                // crc 覆盖 length、crc 之后的全部字节
+constexpr size_t MIN_SEGMENT_SIZE = 1 << 20;
+constexpr size_t MAX_SEGMENT_SIZE = size_t(1) << 31;  // 索引中的段内偏移为 32 位
+constexpr std::string_view TRIM_PREFIX = "t:";          // 删除标记记录的键前缀
+
+/**
+ * 记录头，写入时整体 memcpy 到段中
+ */
+struct RecordHeader {
+    uint32_t length;      // 对齐后的记录总长度
+    uint32_t crc;
+    uint64_t sequence;
+    int64_t timestamp;
+    uint16_t keyLength;
+    uint16_t reserved;
+    uint32_t bodyLength;
+};
+static_assert(sizeof(RecordHeader) == RECORD_HEADER_SIZE, "记录头必须为 32 字节");
+
+size_t alignRecord(size_t size) {
+    return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+}
+
+/**
+ * CRC-32（IEEE 802.3），查表实现
+ */
+const uint32_t* crcTable() {
+    static const auto table = [] {
+        static uint32_t t[256];
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    const uint32_t* table = crcTable();
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+std::string segmentPath(const std::string& directory, uint32_t id) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%010u.seg", id);
+    return directory + "/" + name;
+}
+
+int64_t nowSeconds() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+/**
+ * msync 要求起始地址按页对齐
+ */
+void syncRange(uint8_t* base, size_t from, size_t to) {
+    if (to <= from) {
+        return;
+    }
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = from & ~(pageSize - 1);
+    if (msync(base + start, to - start, MS_SYNC) != 0) {
+        LOG_ERROR("[消息存储] msync 失败: ", std::strerror(errno));
+    }
+}
+
+/**
+ * 新建、删除文件后刷目录项，否则掉电后文件本身可能丢失
+ */
+void syncDirectory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("[消息存储] 打开目录失败: ", directory, ", error=", std::strerror(errno));
+        return;
+    }
+    if (fsync(fd) != 0) {
+        LOG_ERROR("[消息存储] 刷新目录失败: ", directory, ", error=", std::strerror(errno));
+    }
+    ::close(fd);
+}
+
+}  // namespace
+
+MessageStore& MessageStore::getInstance() {
+    static MessageStore instance;
+    return instance;
+}
+
+MessageStore::~MessageStore() {
+    close();
+}
+
+bool MessageStore::open(const MessageStoreOptions& options) {
+    if (isOpen()) {
+        return true;
+    }
+    options_ = options;
+    options_.segmentSize = std::clamp(alignRecord(options_.segmentSize), MIN_SEGMENT_SIZE, MAX_SEGMENT_SIZE);
+
+    std::error_code ec;
+    std::filesystem::create_directories(options_.directory, ec);
+    if (ec) {
+        LOG_ERROR("[消息存储] 创建目录失败: ", options_.directory, ", error=", ec.message());
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!recover()) {
+        return false;
+    }
+    if (segments_.empty() && !createSegment(1)) {
+        return false;
+    }
+    applyRetention();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        nextSequence_ = lastSequence_.load() + 1;
+        stopping_ = false;
+    }
+    writer_ = std::thread(&MessageStore::writerLoop, this);
+    open_.store(true, std::memory_order_release);
+
+    LOG_INFO("[消息存储] 已打开: dir=", options_.directory, ", segments=", segments_.size(),
+             ", conversations=", conversations_.size(), ", last_seq=", lastSequence_.load(),
+             ", 恢复耗时=", elapsed, "ms");
+    return true;
+}
+
+void MessageStore::close() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (!open_.exchange(false)) {
+            return;
+        }
+        stopping_ = true;
+    }
+    queueCond_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    for (auto& segment : segments_) {
+        closeSegment(*segment);
+    }
+    segments_.clear();
+    conversations_.clear();
+    trimmed_.clear();
+    // 重新打开时由恢复扫描重新得出；不清零的话扫描会把所有记录当作乱序，截断并清空段文件
+    uint64_t lastSequence = lastSequence_.exchange(0);
+    LOG_INFO("[消息存储] 已关闭: last_seq=", lastSequence);
+}
+
+uint64_t MessageStore::append(std::string conversation, std::string body, AppendCallback callback) {
+    size_t recordSize = alignRecord(RECORD_HEADER_SIZE + conversation.size() + body.size());
+    if (conversation.size() > UINT16_MAX || recordSize > options_.segmentSize - SEGMENT_HEADER_SIZE) {
+        LOG_WARN("[消息存储] 消息过大，未写入: conversation=", conversation, ", size=", body.size());
+        return 0;
+    }
+
+    uint64_t sequence;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_ || !open_.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        sequence = nextSequence_++;
+        queue_.push_back(Pending{sequence, nowSeconds(), std::move(conversation), std::move(body),
+                                 std::move(callback)});
+    }
+    queueCond_.notify_one();
+    return sequence;
+}
+
+void MessageStore::writerLoop() {
+    std::deque<Pending> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCond_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;  // stopping_ 且已写完
+            }
+            // 一次取走全部待写消息，写入期间新的 append 继续入队，下一轮再提交
+            batch.swap(queue_);
+        }
+        writeBatch(batch);
+        batch.clear();
+    }
+}
+
+void MessageStore::writeBatch(std::deque<Pending>& batch) {
+    struct Written {
+        Pending* pending;
+        Location location;
+    };
+    std::vector<Written> written;
+    written.reserve(batch.size());
+
+    Segment* segment = segments_.back().get();
+    size_t syncFrom = segment->writeOffset;
+    uint64_t bytes = 0;
+
+    for (Pending& p : batch) {
+        size_t payload = RECORD_HEADER_SIZE + p.conversation.size() + p.body.size();
+        size_t recordSize = alignRecord(payload);
+        if (segment->writeOffset + recordSize > segment->size) {
+            // 当前段写满：先把本段已写部分刷盘，再滚动到新段
+            syncRange(segment->data, syncFrom, segment->writeOffset);
+            segment = ensureSpace(recordSize);
+            if (!segment) {
+                if (p.callback) {
+                    p.callback(p.sequence, false);
+                }
+                segment = segments_.back().get();
+                syncFrom = segment->writeOffset;
+                continue;
+            }
+            syncFrom = segment->writeOffset;
+        }
+
+        uint8_t* dest = segment->data + segment->writeOffset;
+        RecordHeader header{};
+        header.length = static_cast<uint32_t>(recordSize);
+        header.sequence = p.sequence;
+        header.timestamp = p.timestamp;
+        header.keyLength = static_cast<uint16_t>(p.conversation.size());
+        header.bodyLength = static_cast<uint32_t>(p.body.size());
+        std::memcpy(dest, &header, RECORD_HEADER_SIZE);
+        std::memcpy(dest + RECORD_HEADER_SIZE, p.conversation.data(), p.conversation.size());
+        std::memcpy(dest + RECORD_HEADER_SIZE + p.conversation.size(), p.body.data(), p.body.size());
+        header.crc = crc32(dest + CRC_OFFSET, payload - CRC_OFFSET);
+        std::memcpy(dest + 4, &header.crc, sizeof(header.crc));
+
+        written.push_back({&p, Location{p.sequence, segment->id, static_cast<uint32_t>(segment->writeOffset)}});
+        segment->writeOffset += recordSize;
+        segment->lastTimestamp = p.timestamp;
+        bytes += recordSize;
+    }
+
+    // 组提交：整批只刷一次盘
+    syncRange(segment->data, syncFrom, segment->writeOffset);
+    commits_.fetch_add(1, std::memory_order_relaxed);
+
+    // 落盘后才对读取可见
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex_);
+        for (const Written& w : written) {
+            indexRecordLocked(w.pending->conversation, w.location, w.pending->body);
+        }
+    }
+    if (!written.empty()) {
+        lastSequence_.store(written.back().location.sequence, std::memory_order_release);
+    }
+    appended_.fetch_add(written.size(), std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (written.size() > maxBatch_.load(std::memory_order_relaxed)) {
+        maxBatch_.store(written.size(), std::memory_order_relaxed);
+    }
+
+    for (const Written& w : written) {
+        if (w.pending->callback) {
+            w.pending->callback(w.location.sequence, true);
+        }
+    }
+}
+
+MessageStore::Segment* MessageStore::ensureSpace(size_t recordSize) {
+    Segment* current = segments_.back().get();
+    if (current->writeOffset + recordSize <= current->size) {
+        return current;
+    }
+    Segment* next = createSegment(current->id + 1);
+    if (next) {
+        applyRetention();
+    }
+    return next;
+}
+
+MessageStore::Segment* MessageStore::createSegment(uint32_t id) {
+    auto segment = std::make_unique<Segment>();
+    segment->id = id;
+    segment->size = options_.segmentSize;
+
+    std::string path = segmentPath(options_.directory, id);
+    segment->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (segment->fd < 0) {
+        LOG_ERROR("[消息存储] 创建段文件失败: ", path, ", error=", std::strerror(errno));
+        return nullptr;
+    }
+    // 预分配整段的磁盘块：稀疏文件在磁盘写满后经映射写入会触发 SIGBUS，
+    // 这里提前失败，由调用方回调 ok=false；未写入部分读出为 0，即记录结束标记
+    int err = posix_fallocate(segment->fd, 0, static_cast<off_t>(segment->size));
+    if (err != 0) {
+        LOG_ERROR("[消息存储] 预分配段文件失败: ", path, ", error=", std::strerror(err));
+        ::close(segment->fd);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+    void* data = mmap(nullptr, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("[消息存储] 映射段文件失败: ", path, ", error=", std::strerror(errno));
+        ::close(segment->fd);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+    segment->data = static_cast<uint8_t*>(data);
+    syncDirectory(options_.directory);
+
+    uint32_t header[4] = {SEGMENT_MAGIC, SEGMENT_VERSION, id, 0};
+    std::memcpy(segment->data, header, SEGMENT_HEADER_SIZE);
+    segment->writeOffset = SEGMENT_HEADER_SIZE;
+    segment->lastTimestamp = nowSeconds();
+
+    Segment* raw = segment.get();
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex_);
+        segments_.push_back(std::move(segment));
+    }
+    LOG_DEBUG("[消息存储] 新建段文件: ", path);
+    return raw;
+}
+
+void MessageStore::closeSegment(Segment& segment) {
+    if (segment.data) {
+        msync(segment.data, segment.size, MS_SYNC);
+        munmap(segment.data, segment.size);
+        segment.data = nullptr;
+    }
+    if (segment.fd >= 0) {
+        ::close(segment.fd);
+        segment.fd = -1;
+    }
+}
+
+bool MessageStore::recover() {
+    std::vector<uint32_t> ids;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(options_.directory, ec)) {
+        const std::string name = entry.path().filename().string();
+        unsigned int id = 0;
+        char suffix[8] = {};
+        if (std::sscanf(name.c_str(), "%10u.%4s", &id, suffix) == 2 && std::strcmp(suffix, "seg") == 0 && id > 0) {
+            ids.push_back(id);
+        }
+    }
+    if (ec) {
+        LOG_ERROR("[消息存储] 读取目录失败: ", options_.directory, ", error=", ec.message());
+        return false;
+    }
+    std::sort(ids.begin(), ids.end());
+
+    for (uint32_t id : ids) {
+        auto segment = std::make_unique<Segment>();
+        segment->id = id;
+        std::string path = segmentPath(options_.directory, id);
+        segment->fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        struct stat st {};
+        if (segment->fd < 0 || fstat(segment->fd, &st) != 0 ||
+            static_cast<size_t>(st.st_size) < SEGMENT_HEADER_SIZE) {
+            LOG_ERROR("[消息存储] 段文件无法打开，跳过: ", path);
+            closeSegment(*segment);
+            continue;
+        }
+        segment->size = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+        if (data == MAP_FAILED) {
+            LOG_ERROR("[消息存储] 映射段文件失败: ", path, ", error=", std::strerror(errno));
+            closeSegment(*segment);
+            return false;
+        }
+        segment->data = static_cast<uint8_t*>(data);
+
+        uint32_t header[4];
+        std::memcpy(header, segment->data, SEGMENT_HEADER_SIZE);
+        if (header[0] != SEGMENT_MAGIC || header[1] != SEGMENT_VERSION || header[2] != id) {
+            LOG_ERROR("[消息存储] 段文件头无效，跳过: ", path);
+            closeSegment(*segment);
+            continue;
+        }
+        if (!scanSegment(*segment)) {
+            LOG_WARN("[消息存储] 段文件末尾有不完整记录，已截断: ", path, ", offset=", segment->writeOffset);
+        }
+        segments_.push_back(std::move(segment));
+    }
+    return true;
+}
+
+bool MessageStore::scanSegment(Segment& segment) {
+    size_t offset = SEGMENT_HEADER_SIZE;
+    uint64_t lastSequence = lastSequence_.load(std::memory_order_relaxed);
+    bool clean = true;
+    segment.lastTimestamp = 0;
+
+    while (offset + RECORD_HEADER_SIZE <= segment.size) {
+        RecordHeader header;
+        std::memcpy(&header, segment.data + offset, RECORD_HEADER_SIZE);
+        if (header.length == 0) {
+            break;
+        }
+        size_t payload = RECORD_HEADER_SIZE + header.keyLength + size_t(header.bodyLength);
+        if (header.length != alignRecord(payload) || offset + header.length > segment.size ||
+            header.sequence <= lastSequence ||
+            crc32(segment.data + offset + CRC_OFFSET, payload - CRC_OFFSET) != header.crc) {
+            clean = false;
+            break;
+        }
+
+        const char* record = reinterpret_cast<const char*>(segment.data + offset + RECORD_HEADER_SIZE);
+        indexRecordLocked(std::string(record, header.keyLength),
+                          Location{header.sequence, segment.id, static_cast<uint32_t>(offset)},
+                          std::string_view(record + header.keyLength, header.bodyLength));
+        lastSequence = header.sequence;
+        segment.lastTimestamp = header.timestamp;
+        offset += header.length;
+    }
+
+    segment.writeOffset = offset;
+    lastSequence_.store(lastSequence, std::memory_order_relaxed);
+    if (segment.lastTimestamp == 0) {
+        segment.lastTimestamp = nowSeconds();
+    }
+    if (!clean) {
+        // 写入中途崩溃：清掉残留字节，避免之后追加的记录后面接上旧数据
+        std::memset(segment.data + offset, 0, segment.size - offset);
+        syncRange(segment.data, offset, segment.size);
+    }
+    return clean;
+}
+
+void MessageStore::applyRetention() {
+    if (options_.retention.count() <= 0) {
+        return;
+    }
+    int64_t cutoff = nowSeconds() - std::chrono::duration_cast<std::chrono::seconds>(options_.retention).count();
+
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    size_t removed = 0;
+    // 当前写入段不删除
+    while (segments_.size() > 1 && segments_.front()->lastTimestamp < cutoff) {
+        Segment& segment = *segments_.front();
+        closeSegment(segment);
+        ::unlink(segmentPath(options_.directory, segment.id).c_str());
+        segments_.pop_front();
+        ++removed;
+    }
+    if (removed == 0) {
+        return;
+    }
+
+    uint32_t firstSegment = segments_.front()->id;
+    for (auto it = conversations_.begin(); it != conversations_.end();) {
+        auto& locations = it->second;
+        auto keep = std::find_if(locations.begin(), locations.end(),
+                                 [firstSegment](const Location& l) { return l.segment >= firstSegment; });
+        locations.erase(locations.begin(), keep);
+        if (locations.empty()) {
+            it = conversations_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    LOG_INFO("[消息存储] 删除过期段文件: ", removed, " 个，保留 ", segments_.size(), " 个");
+}
+
+void MessageStore::indexRecordLocked(const std::string& key, const Location& location, std::string_view body) {
+    if (key.compare(0, TRIM_PREFIX.size(), TRIM_PREFIX) == 0) {
+        uint64_t through = 0;
+        std::from_chars(body.data(), body.data() + body.size(), through);
+        trimLocked(key.substr(TRIM_PREFIX.size()), through);
+        return;
+    }
+    auto trimmed = trimmed_.find(key);
+    if (trimmed != trimmed_.end() && location.sequence <= trimmed->second) {
+        return;  // 写入前已被删除（删除位置由调用方指定，可能超过正在写入的序号）
+    }
+    conversations_[key].push_back(location);
+}
+
+void MessageStore::trimLocked(const std::string& conversation, uint64_t throughSequence) {
+    uint64_t& current = trimmed_[conversation];
+    if (throughSequence <= current) {
+        return;
+    }
+    current = throughSequence;
+    auto it = conversations_.find(conversation);
+    if (it == conversations_.end()) {
+        return;
+    }
+    auto& locations = it->second;
+    auto keep = std::upper_bound(locations.begin(), locations.end(), throughSequence,
+                                 [](uint64_t seq, const Location& l) { return seq < l.sequence; });
+    locations.erase(locations.begin(), keep);
+    if (locations.empty()) {
+        conversations_.erase(it);
+    }
+}
+
+bool MessageStore::trim(const std::string& conversation, uint64_t throughSequence) {
+    {
+        std::unique_lock<std::shared_mutex> lock(indexMutex_);
+        auto it = trimmed_.find(conversation);
+        if (it != trimmed_.end() && throughSequence <= it->second) {
+            return false;
+        }
+        // 先从索引移除，之后的读取立即生效；标记记录落盘后重启也能恢复
+        trimLocked(conversation, throughSequence);
+    }
+    std::string key;
+    key.reserve(TRIM_PREFIX.size() + conversation.size());
+    key.append(TRIM_PREFIX).append(conversation);
+    append(std::move(key), std::to_string(throughSequence));
+    return true;
+}
+
+uint64_t MessageStore::trimmedThrough(const std::string& conversation) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    auto it = trimmed_.find(conversation);
+    return it != trimmed_.end() ? it->second : 0;
+}
+
+std::vector<StoredMessage> MessageStore::readAfter(const std::string& conversation, uint64_t afterSequence,
+                                                   size_t limit) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    auto it = conversations_.find(conversation);
+    if (it == conversations_.end()) {
+        return {};
+    }
+    const auto& locations = it->second;
+    auto first = std::upper_bound(locations.begin(), locations.end(), afterSequence,
+                                  [](uint64_t seq, const Location& l) { return seq < l.sequence; });
+    size_t begin = static_cast<size_t>(first - locations.begin());
+    size_t end = std::min(locations.size(), begin + limit);
+    return readRange(locations, begin, end);
+}
+
+std::vector<StoredMessage> MessageStore::readBefore(const std::string& conversation, uint64_t beforeSequence,
+                                                    size_t limit) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    auto it = conversations_.find(conversation);
+    if (it == conversations_.end()) {
+        return {};
+    }
+    const auto& locations = it->second;
+    auto last = std::lower_bound(locations.begin(), locations.end(), beforeSequence,
+                                 [](const Location& l, uint64_t seq) { return l.sequence < seq; });
+    size_t end = static_cast<size_t>(last - locations.begin());
+    size_t begin = end > limit ? end - limit : 0;
+    return readRange(locations, begin, end);
+}
+
+std::vector<StoredMessage> MessageStore::readRange(const std::vector<Location>& locations, size_t begin,
+                                                   size_t end) const {
+    std::vector<StoredMessage> messages;
+    messages.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        const Segment* segment = findSegment(locations[i].segment);
+        if (!segment) {
+            continue;
+        }
+        RecordHeader header;
+        std::memcpy(&header, segment->data + locations[i].offset, RECORD_HEADER_SIZE);
+        const char* body = reinterpret_cast<const char*>(segment->data + locations[i].offset +
+                                                         RECORD_HEADER_SIZE + header.keyLength);
+        StoredMessage message;
+        message.sequence = header.sequence;
+        message.timestamp = header.timestamp;
+        message.body.assign(body, header.bodyLength);
+        messages.push_back(std::move(message));
+    }
+    return messages;
+}
+
+const MessageStore::Segment* MessageStore::findSegment(uint32_t id) const {
+    auto it = std::lower_bound(segments_.begin(), segments_.end(), id,
+                               [](const std::unique_ptr<Segment>& s, uint32_t v) { return s->id < v; });
+    return (it != segments_.end() && (*it)->id == id) ? it->get() : nullptr;
+}
+
+std::string MessageStore::singleKey(const std::string& userA, const std::string& userB) {
+    const std::string& low = std::min(userA, userB);
+    const std::string& high = std::max(userA, userB);
+    std::string key;
+    key.reserve(3 + low.size() + high.size());
+    key.append("u:").append(low).append(":").append(high);
+    return key;
+}
+
+std::string MessageStore::groupKey(const std::string& groupId) {
+    return "g:" + groupId;
+}
+
+std::string MessageStore::inboxKey(const std::string& userId) {
+    return "i:" + userId;
+}
+
+MessageStoreStats MessageStore::getStats() const {
+    MessageStoreStats stats;
+    stats.appended = appended_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.commits = commits_.load(std::memory_order_relaxed);
+    stats.maxBatch = maxBatch_.load(std::memory_order_relaxed);
+    stats.lastSequence = lastSequence_.load(std::memory_order_acquire);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stats.pending = queue_.size();
+    }
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    stats.segments = segments_.size();
+    stats.conversations = conversations_.size();
+    return stats;
+}
+
+}  // namespace im
@@ -0,0 +1,224 @@
+#ifndef MESSAGE_STORE_H
+#define MESSAGE_STORE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace im {
+
+/**
+ * 消息存储配置
+ */
+struct MessageStoreOptions {
+    std::string directory = "data/messages";     // 段文件目录
+    size_t segmentSize = 64 << 20;                // 单个段文件大小（固定，创建时预分配）
+    std::chrono::hours retention{24 * 30};        // 段内最后一条消息早于该时长时整段删除，0 表示不删除
+};
+
+/**
+ * 消息存储统计
+ */
+struct MessageStoreStats {
+    uint64_t appended = 0;        // 累计写入条数
+    uint64_t bytes = 0;           // 累计写入字节数
+    uint64_t commits = 0;         // 累计刷盘（组提交）次数
+    uint64_t maxBatch = 0;        // 单次组提交的最大条数
+    size_t pending = 0;           // 等待写入的条数
+    size_t segments = 0;          // 当前段文件数
+    size_t conversations = 0;     // 已索引的会话数
+    uint64_t lastSequence = 0;    // 最后一条已落盘消息的序号
+};
+
+/**
+ * 读取出的消息
+ */
+struct StoredMessage {
+    uint64_t sequence = 0;    // 全局递增序号
+    int64_t timestamp = 0;    // 写入时间（秒）
+    std::string body;         // 写入时的消息体（RECEIVE_MESSAGE 的 JSON）
+};
+
+/**
+ * 持久化消息存储：追加写的分段日志
+ *
+ * - 段文件固定大小，创建时预分配并 mmap，记录顺序追加；写满后滚动到下一个段
+ * - append 只入队并立即返回序号，由专用写线程批量写入后一次 msync（组提交），
+ *   网络线程和工作线程不等待磁盘
+ * - 内存中按会话维护序号 -> 位置的索引：单聊键为排序后的两个 userId，群聊键为 group_id
+ * - 启动时顺序扫描所有段、校验 CRC 重建索引，末尾未写完整的记录被丢弃
+ * - 段内最后一条消息超过保留时长后整段删除
+ * - trim 写一条删除标记记录（键为 "t:" + 会话键，内容为序号），会话中不大于该序号的消息
+ *   立即从索引移除，恢复时按标记重新移除；磁盘空间仍随整段删除回收
+ *
+ * 记录格式（本机字节序，8 字节对齐）：
+ *     length(4) crc(4) sequence(8) timestamp(8) keyLength(2) reserved(2) bodyLength(4) key body
+ * crc 覆盖 sequence 起的全部字节，length 为 0 表示段内已无更多记录。
+ */
+class MessageStore {
+public:
+    /**
+     * 写入落盘（或失败）后的回调，在写线程中调用，不应阻塞
+     */
+    using AppendCallback = std::function<void(uint64_t sequence, bool ok)>;
+
+    static MessageStore& getInstance();
+
+    /**
+     * 打开存储目录并恢复索引，启动写线程
+     */
+    bool open(const MessageStoreOptions& options);
+
+    /**
+     * 写完队列中剩余的消息后关闭
+     */
+    void close();
+
+    bool isOpen() const { return open_.load(std::memory_order_acquire); }
+
+    /**
+     * 最后一条已落盘消息的序号
+     */
+    uint64_t lastSequence() const { return lastSequence_.load(std::memory_order_acquire); }
+
+    /**
+     * 追加一条消息（非阻塞）
+     *
+     * @param conversation 会话键（singleKey / groupKey）
+     * @param body 消息体
+     * @param callback 落盘后回调，可为空
+     * @return 分配的序号；存储未打开或消息过大时返回 0
+     */
+    uint64_t append(std::string conversation, std::string body, AppendCallback callback = nullptr);
+
+    /**
+     * 读取会话中序号大于 afterSequence 的消息，按序号升序，最多 limit 条
+     */
+    std::vector<StoredMessage> readAfter(const std::string& conversation, uint64_t afterSequence, size_t limit) const;
+
+    /**
+     * 读取会话中序号小于 beforeSequence 的最近 limit 条消息，按序号升序
+     */
+    std::vector<StoredMessage> readBefore(const std::string& conversation, uint64_t beforeSequence, size_t limit) const;
+
+    /**
+     * 删除会话中序号不大于 throughSequence 的消息（只前进不后退，非阻塞）
+     *
+     * @return 是否前进了删除位置
+     */
+    bool trim(const std::string& conversation, uint64_t throughSequence);
+
+    /**
+     * 会话已删除到的序号，未删除过为 0
+     */
+    uint64_t trimmedThrough(const std::string& conversation) const;
+
+    /**
+     * 单聊会话键：两个 userId 排序后拼接，双方得到同一个键
+     */
+    static std::string singleKey(const std::string& userA, const std::string& userB);
+
+    static std::string groupKey(const std::string& groupId);
+
+    /**
+     * 离线收件箱：用户不在线时收到的单聊消息
+     */
+    static std::string inboxKey(const std::string& userId);
+
+
+    MessageStoreStats getStats() const;
+
+private:
+    MessageStore() = default;
+    ~MessageStore();
+    MessageStore(const MessageStore&) = delete;
+    MessageStore& operator=(const MessageStore&) = delete;
+
+    struct Segment {
+        uint32_t id = 0;              // 递增编号，也是文件名
+        int fd = -1;
+        uint8_t* data = nullptr;      // mmap 映射
+        size_t size = 0;
+        size_t writeOffset = 0;       // 下一条记录的写入位置
+        int64_t lastTimestamp = 0;    // 段内最后一条消息的时间，用于保留策略
+    };
+
+    struct Location {
+        uint64_t sequence;
+        uint32_t segment;
+        uint32_t offset;
+    };
+
+    struct Pending {
+        uint64_t sequence;
+        int64_t timestamp;
+        std::string conversation;
+        std::string body;
+        AppendCallback callback;
+    };
+
+    bool recover();
+    bool scanSegment(Segment& segment);
+    Segment* createSegment(uint32_t id);
+    void closeSegment(Segment& segment);
+
+    /**
+     * 写线程：取出队列中所有待写消息，写入后一次刷盘
+     */
+    void writerLoop();
+    void writeBatch(std::deque<Pending>& batch);
+
+    /**
+     * 当前段剩余空间不足时刷盘并切换到新段
+     */
+    Segment* ensureSpace(size_t recordSize);
+    void applyRetention();
+
+    /**
+     * 记录按键建立索引；删除标记更新删除位置并移除已删除的消息（调用方持有索引写锁）
+     */
+    void indexRecordLocked(const std::string& key, const Location& location, std::string_view body);
+    void trimLocked(const std::string& conversation, uint64_t throughSequence);
+
+    std::vector<StoredMessage> readRange(const std::vector<Location>& locations, size_t begin, size_t end) const;
+    const Segment* findSegment(uint32_t id) const;
+
+    MessageStoreOptions options_;
+    std::atomic<bool> open_{false};
+
+    // 写入队列
+    mutable std::mutex queueMutex_;
+    std::condition_variable queueCond_;
+    std::deque<Pending> queue_;
+    uint64_t nextSequence_ = 1;
+    bool stopping_ = false;
+    std::thread writer_;
+
+    // 段与索引：写线程修改时持有写锁，读取时持有读锁
+    mutable std::shared_mutex indexMutex_;
+    std::deque<std::unique_ptr<Segment>> segments_;  // 按编号升序，最后一个为当前写入段
+    std::unordered_map<std::string, std::vector<Location>> conversations_;
+    std::unordered_map<std::string, uint64_t> trimmed_;  // 会话 -> 已删除到的序号
+
+    std::atomic<uint64_t> appended_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> commits_{0};
+    std::atomic<uint64_t> maxBatch_{0};
+    std::atomic<uint64_t> lastSequence_{0};
+};
+
+}  // namespace im
+
+#endif  // MESSAGE_STORE_H
@@ -0,0 +1,129 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace im {
+
+/**
+ * 只可移动的任务：不超过 INLINE_SIZE 字节的可调用对象直接存放在任务内部，
+ * 更大的才在堆上分配（Reactor 提交的读任务只捕获 this 和一个 shared_ptr，不分配）
+ *
+ * 与 std::function 不同，不要求可调用对象可复制，移动后源任务变为空。
+ */
+class Task {
+public:
+    static constexpr size_t INLINE_SIZE = 48;
+
+    Task() noexcept = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& callable) {
+        using Fn = std::decay_t<F>;
+        if constexpr (fitsInline<Fn>()) {
+            new (&storage_) Fn(std::forward<F>(callable));
+            ops_ = &InlineOps<Fn>::OPS;
+        } else {
+            *reinterpret_cast<Fn**>(&storage_) = new Fn(std::forward<F>(callable));
+            ops_ = &HeapOps<Fn>::OPS;
+        }
+    }
+
+    Task(Task&& other) noexcept {
+        moveFrom(other);
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        reset();
+    }
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    void operator()() {
+        ops_->invoke(&storage_);
+    }
+
+    /**
+     * 释放可调用对象（及其捕获的资源），任务变为空
+     */
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* from, void* to) noexcept;  // 移动到 to 并销毁 from
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename Fn>
+    static constexpr bool fitsInline() {
+        return sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template<typename Fn>
+    struct InlineOps {
+        static void invoke(void* storage) {
+            (*std::launder(reinterpret_cast<Fn*>(storage)))();
+        }
+        static void move(void* from, void* to) noexcept {
+            Fn* source = std::launder(reinterpret_cast<Fn*>(from));
+            new (to) Fn(std::move(*source));
+            source->~Fn();
+        }
+        static void destroy(void* storage) noexcept {
+            std::launder(reinterpret_cast<Fn*>(storage))->~Fn();
+        }
+        static constexpr Ops OPS{&invoke, &move, &destroy};
+    };
+
+    template<typename Fn>
+    struct HeapOps {
+        static void invoke(void* storage) {
+            (**reinterpret_cast<Fn**>(storage))();
+        }
+        static void move(void* from, void* to) noexcept {
+            *reinterpret_cast<Fn**>(to) = *reinterpret_cast<Fn**>(from);
+        }
+        static void destroy(void* storage) noexcept {
+            delete *reinterpret_cast<Fn**>(storage);
+        }
+        static constexpr Ops OPS{&invoke, &move, &destroy};
+    };
+
+    void moveFrom(Task& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(&other.storage_, &storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+};
+
+}  // namespace im
+
+#endif  // TASK_H
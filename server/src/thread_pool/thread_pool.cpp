@@ -1,11 +1,52 @@
 #include "thread_pool.h"
-#include <chrono>
+#include "utils/logger.h"
+
+#include <algorithm>
 
 namespace im {
 
-ThreadPool::ThreadPool(size_t numThreads) : stop_(false) {
+namespace {
+
+// 空闲时先自旋的次数：前一半用 CPU pause，后一半让出时间片
+constexpr int SPIN_COUNT = 128;
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// 当前线程所属的线程池及其工作线程序号（非工作线程为空）
+thread_local ThreadPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+// 选择窃取对象用的线程私有随机数（xorshift）
+thread_local uint32_t stealSeed = 0;
+
+uint32_t nextRandom() {
+    uint32_t x = stealSeed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    stealSeed = x;
+    return x;
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t numThreads, bool workStealing)
+    : workStealing_(workStealing), queue_(QUEUE_CAPACITY), stop_(false) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // 先建好所有工作线程的状态，窃取方会访问其他线程的队列
+    for (size_t i = 0; i < numThreads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
     for (size_t i = 0; i < numThreads; ++i) {
-        workers_.emplace_back([this] { worker(); });
+        workers_[i]->thread = std::thread([this, i] { worker(i); });
     }
 }
 
@@ -17,39 +58,149 @@ void ThreadPool::stop() {
     if (stop_.exchange(true)) {
         return;  // 已经停止
     }
-    
-    // 通知所有等待的线程
+
+    // 通知所有等待的线程（先经过 sleepMutex_，保证正在准备休眠的线程能看到 stop_）
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
     condition_.notify_all();
-    
+
     // 等待所有线程退出
     // 注意：由于 socket 是非阻塞的，任务中的 recv 不会无限阻塞
     for (auto& worker : workers_) {
-        if (worker.joinable()) {
-            worker.join();
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // 本地队列只存任务指针，线程退出后仍留在队列中的任务（停止期间提交的）在这里释放，不再执行
+    size_t dropped = 0;
+    for (auto& worker : workers_) {
+        Task* task = nullptr;
+        while (worker->deque.pop(task)) {
+            delete task;
+            ++dropped;
+        }
+    }
+    if (dropped > 0) {
+        LOG_WARN("[线程池] 停止时丢弃未执行的本地任务: ", dropped);
+    }
+}
+
+ThreadPool::Stats ThreadPool::getStats() const {
+    Stats stats{workStealing_, queue_.size() + overflowSize_.load(std::memory_order_relaxed), {}};
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        const Worker& worker = *workers_[i];
+        stats.workers.push_back({i, worker.deque.size(), worker.executed.load(std::memory_order_relaxed),
+                                 worker.steals.load(std::memory_order_relaxed)});
+    }
+    return stats;
+}
+
+void ThreadPool::push(Task task) {
+    if (workStealing_ && currentPool == this) {
+        // 任务中提交的任务：放入本线程的本地队列
+        workers_[currentIndex]->deque.push(new Task(std::move(task)));
+    } else if (!queue_.tryPush(std::move(task))) {
+        std::lock_guard<std::mutex> lock(overflowMutex_);
+        overflow_.push_back(std::move(task));
+        overflowSize_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 与 worker() 中“先登记休眠、再检查队列”配对：两边至少有一方能看到对方
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        condition_.notify_one();
+    }
+}
+
+bool ThreadPool::tryPop(Task& task) {
+    if (queue_.tryPop(task)) {
+        return true;
+    }
+    if (overflowSize_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    if (overflow_.empty()) {
+        return false;
+    }
+    task = std::move(overflow_.front());
+    overflow_.pop_front();
+    overflowSize_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::trySteal(size_t self, Task& task) {
+    size_t count = workers_.size();
+    size_t start = nextRandom() % count;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        Task* stolen;
+        if (victim != self && workers_[victim]->deque.steal(stolen)) {
+            task = std::move(*stolen);
+            delete stolen;
+            workers_[self]->steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
         }
     }
-    workers_.clear();
+    return false;
 }
 
-void ThreadPool::worker() {
+bool ThreadPool::findTask(size_t self, Task& task) {
+    if (!workStealing_) {
+        return tryPop(task);
+    }
+    // 本地队列优先（后进先出，缓存更热），其次全局队列，最后窃取
+    Task* local;
+    if (workers_[self]->deque.pop(local)) {
+        task = std::move(*local);
+        delete local;
+        return true;
+    }
+    return tryPop(task) || trySteal(self, task);
+}
+
+void ThreadPool::worker(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+    stealSeed = static_cast<uint32_t>(index * 2654435761u) | 1;
+    Worker& self = *workers_[index];
+
+    Task task;
     while (true) {
-        std::function<void()> task;
-        
-        {
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
-            
-            if (stop_ && tasks_.empty()) {
-                return;
+        bool found = findTask(index, task);
+        for (int spin = 0; !found && spin < SPIN_COUNT; ++spin) {
+            if (spin < SPIN_COUNT / 2) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+            found = findTask(index, task);
+        }
+
+        if (!found) {
+            if (stop_) {
+                return;  // 已停止且任务已取完
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            sleepers_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            found = findTask(index, task);
+            if (!found && !stop_) {
+                condition_.wait(lock);
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            if (!found) {
+                continue;
             }
-            
-            task = std::move(tasks_.front());
-            tasks_.pop();
         }
-        
+
         task();
+        task.reset();  // 及时释放捕获的连接等资源
+        self.executed.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
 }  // namespace im
-
@@ -3,40 +3,98 @@
 
 #include <thread>
 #include <vector>
-#include <queue>
-#include <functional>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <memory>
+#include "thread_pool/mpmc_queue.h"
+#include "thread_pool/task.h"
+#include "thread_pool/work_stealing_deque.h"
 
 namespace im {
 
+/**
+ * 工作线程池
+ *
+ * 任务放在无锁环形队列中，提交和取任务都不加锁；环形队列满时退到加锁的溢出队列。
+ * 空闲的工作线程先自旋一小段时间，仍取不到任务才休眠，提交方只在有线程休眠时才去唤醒。
+ * 各任务之间不保证执行顺序（同一连接的任务由调用方串行提交）。
+ *
+ * 工作窃取模式下每个工作线程另有一个 Chase-Lev 双端队列：任务中再提交的任务放入
+ * 当前线程的本地队列并优先在本线程执行，空闲线程先取全局队列，再从其他线程的本地队列窃取。
+ */
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency());
+    static constexpr size_t QUEUE_CAPACITY = 1 << 16;
+
+    struct WorkerStats {
+        size_t index;
+        size_t localDepth;   // 本地队列中的任务数
+        uint64_t executed;   // 已执行任务数
+        uint64_t steals;     // 从其他线程窃取的任务数
+    };
+
+    struct Stats {
+        bool workStealing;
+        size_t globalDepth;  // 全局队列（含溢出队列）中的任务数
+        std::vector<WorkerStats> workers;
+    };
+
+    /**
+     * @param numThreads 工作线程数，0 表示按 CPU 核数
+     * @param workStealing 是否启用工作窃取模式
+     */
+    explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency(), bool workStealing = false);
     ~ThreadPool();
-    
+
     /**
      * 提交任务
-     * 
-     * @param task 任务函数
+     *
+     * @param task 任务函数（只需可移动）
      */
     template<typename F>
     void submit(F&& task);
-    
+
     /**
-     * 停止线程池
+     * 停止线程池（已提交的任务执行完后工作线程退出）
      */
     void stop();
 
+    /**
+     * 获取各工作线程的执行、窃取次数与队列深度
+     */
+    Stats getStats() const;
+
 private:
-    std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-    std::mutex queueMutex_;
+    struct Worker {
+        std::thread thread;
+        WorkStealingDeque<Task*> deque;  // 仅工作窃取模式使用
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> steals{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    const bool workStealing_;
+    MpmcQueue<Task> queue_;
+
+    // 环形队列满时的溢出队列
+    std::mutex overflowMutex_;
+    std::deque<Task> overflow_;
+    std::atomic<size_t> overflowSize_{0};
+
+    // 休眠的工作线程数，提交方据此决定是否需要唤醒
+    std::mutex sleepMutex_;
     std::condition_variable condition_;
+    std::atomic<size_t> sleepers_{0};
+
     std::atomic<bool> stop_;
-    
-    void worker();
+
+    void push(Task task);
+    bool tryPop(Task& task);
+    bool trySteal(size_t self, Task& task);
+    bool findTask(size_t self, Task& task);
+    void worker(size_t index);
 };
 
 template<typename F>
@@ -44,17 +102,9 @@ void ThreadPool::submit(F&& task) {
     if (stop_) {
         return;  // 线程池已停止，拒绝新任务
     }
-    {
-        std::unique_lock<std::mutex> lock(queueMutex_);
-        if (stop_) {
-            return;  // 双重检查
-        }
-        tasks_.emplace(std::forward<F>(task));
-    }
-    condition_.notify_one();
+    push(Task(std::forward<F>(task)));
 }
 
 }  // namespace im
 
 #endif  // THREAD_POOL_H
-
@@ -0,0 +1,138 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace im {
+
+/**
+ * Chase-Lev 工作窃取双端队列
+ *
+ * 只有所属线程可以 push / pop（在底部，后进先出），其他线程只能 steal（从顶部，先进先出）。
+ * 底部满时扩容为两倍，旧数组保留到析构时再释放（窃取方可能仍在读）。
+ * 元素按值原子读写，T 需要是可平凡复制的小类型（如指针）。析构时不处理剩余元素，
+ * 元素为指向堆对象的指针时，所有者需在析构前 pop 出并释放。
+ */
+template<typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "元素需可平凡复制");
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        arrays_.push_back(std::make_unique<Array>(size));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * 放入底部（仅所属线程调用）
+     */
+    void push(T value) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(array->mask)) {
+            array = grow(array, top, bottom);
+        }
+        array->put(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * 从底部取出（仅所属线程调用），为空时返回 false
+     */
+    bool pop(T& value) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);  // 空
+            return false;
+        }
+        value = array->get(bottom);
+        if (top == bottom) {
+            // 只剩最后一个：与窃取方竞争
+            bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * 从顶部窃取（任意线程调用），为空或与其他线程竞争失败时返回 false
+     */
+    bool steal(T& value) {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        Array* array = array_.load(std::memory_order_acquire);
+        value = array->get(top);
+        return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    }
+
+    /**
+     * 当前元素数（并发下为近似值）
+     */
+    size_t size() const {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+private:
+    struct Array {
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Array(size_t size) : mask(size - 1), slots(new std::atomic<T>[size]) {}
+
+        // 槽本身按 acquire / release 读写，使元素指向的数据随槽一起发布给窃取方
+        T get(int64_t index) const {
+            return slots[index & mask].load(std::memory_order_acquire);
+        }
+        void put(int64_t index, T value) {
+            slots[index & mask].store(value, std::memory_order_release);
+        }
+    };
+
+    Array* grow(Array* array, int64_t top, int64_t bottom) {
+        auto bigger = std::make_unique<Array>((array->mask + 1) * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, array->get(i));
+        }
+        array = bigger.get();
+        arrays_.push_back(std::move(bigger));
+        array_.store(array, std::memory_order_release);
+        return array;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Array*> array_{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_;  // 仅所属线程修改
+};
+
+}  // namespace im
+
+#endif  // WORK_STEALING_DEQUE_H
@@ -0,0 +1,119 @@
+#include "id_generator.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+
+namespace im {
+
+namespace {
+
+uint64_t currentMs() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    auto ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+    return ms > IdGenerator::EPOCH_MS ? ms - IdGenerator::EPOCH_MS : 0;
+}
+
+}  // namespace
+
+/**
+ * 线程局部状态：首次使用时占用槽位，线程退出时归还
+ */
+struct IdThreadState {
+    uint32_t slot = 0;
+    uint64_t lastMs = 0;
+    uint32_t sequence = 0;
+    bool ready = false;
+
+    ~IdThreadState() {
+        if (ready && slot != IdGenerator::SHARED_SLOT) {
+            IdGenerator::getInstance().releaseSlot(slot, lastMs);
+        }
+    }
+};
+
+namespace {
+thread_local IdThreadState t_idState;
+}  // namespace
+
+IdGenerator& IdGenerator::getInstance() {
+    static IdGenerator instance;
+    return instance;
+}
+
+void IdGenerator::setNodeId(uint32_t nodeId) {
+    if (nodeId > MAX_NODE_ID) {
+        LOG_WARN("[ID 生成] 节点 ID 超出范围，取低 ", NODE_BITS, " 位: node_id=", nodeId);
+    }
+    nodeId_.store(nodeId & MAX_NODE_ID, std::memory_order_relaxed);
+}
+
+uint64_t IdGenerator::next() {
+    IdThreadState& state = t_idState;
+    if (!state.ready) {
+        state.slot = acquireSlot(state.lastMs);
+        // 接手槽位时从上一个占用者的最大时间戳之后开始
+        state.sequence = MAX_SEQUENCE;
+        state.ready = true;
+    }
+
+    uint64_t now = currentMs();
+    if (state.slot == SHARED_SLOT) {
+        return nextShared(now);
+    }
+
+    if (now > state.lastMs) {
+        state.lastMs = now;
+        state.sequence = 0;
+    } else if (state.sequence < MAX_SEQUENCE) {
+        // 同一毫秒，或时钟回拨：沿用已发出的最大时间戳
+        ++state.sequence;
+    } else {
+        ++state.lastMs;
+        state.sequence = 0;
+    }
+    return compose(state.lastMs, state.slot, state.sequence);
+}
+
+uint64_t IdGenerator::nextShared(uint64_t now) {
+    uint64_t current = shared_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        uint64_t lastMs = current >> SEQUENCE_BITS;
+        uint32_t sequence = static_cast<uint32_t>(current & MAX_SEQUENCE);
+        if (now > lastMs) {
+            next = now << SEQUENCE_BITS;
+        } else if (sequence < MAX_SEQUENCE) {
+            next = current + 1;
+        } else {
+            next = (lastMs + 1) << SEQUENCE_BITS;
+        }
+    } while (!shared_.compare_exchange_weak(current, next, std::memory_order_relaxed));
+    return compose(next >> SEQUENCE_BITS, SHARED_SLOT, static_cast<uint32_t>(next & MAX_SEQUENCE));
+}
+
+uint64_t IdGenerator::compose(uint64_t ms, uint32_t slot, uint32_t sequence) const {
+    return (ms << (NODE_BITS + SLOT_BITS + SEQUENCE_BITS)) |
+           (static_cast<uint64_t>(nodeId_.load(std::memory_order_relaxed)) << (SLOT_BITS + SEQUENCE_BITS)) |
+           (static_cast<uint64_t>(slot) << SEQUENCE_BITS) | sequence;
+}
+
+uint32_t IdGenerator::acquireSlot(uint64_t& lastMs) {
+    for (uint32_t i = 0; i < SHARED_SLOT; ++i) {
+        bool expected = false;
+        if (!slots_[i].used.load(std::memory_order_relaxed) &&
+            slots_[i].used.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            lastMs = slots_[i].lastMs.load(std::memory_order_relaxed);
+            return i;
+        }
+    }
+    LOG_WARN("[ID 生成] 线程槽位已用尽，使用共享槽位");
+    lastMs = 0;
+    return SHARED_SLOT;
+}
+
+void IdGenerator::releaseSlot(uint32_t slot, uint64_t lastMs) {
+    slots_[slot].lastMs.store(lastMs, std::memory_order_relaxed);
+    slots_[slot].used.store(false, std::memory_order_release);
+}
+
+}  // namespace im
@@ -0,0 +1,83 @@
+#ifndef ID_GENERATOR_H
+#define ID_GENERATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace im {
+
+/**
+ * 全局唯一、按时间递增的消息 ID（Snowflake 风格），不访问数据库
+ *
+ * 64 位布局（最高位恒为 0）：
+ *     毫秒时间戳(40，自 2025-01-01 起约 34 年) | 节点(6) | 线程槽位(6) | 序号(11)
+ * 每个线程每毫秒 2048 个，即单线程 200 万/秒以内 ID 时间戳与时钟一致
+ *
+ * - 每个线程首次调用时占用一个槽位，之后只读写线程局部状态，无锁无原子操作；
+ *   槽位用尽时退化为共享槽位上的 CAS
+ * - 同一毫秒内序号用完时借用下一毫秒，突发时 ID 暂时领先于时钟，空闲后自然追平
+ * - 时钟回拨时沿用已发出的最大时间戳继续递增，进程内不会重复；
+ *   线程退出后槽位的最大时间戳保留给下一个占用者
+ */
+class IdGenerator {
+public:
+    static constexpr int NODE_BITS = 6;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SEQUENCE_BITS = 11;
+    static constexpr uint32_t MAX_NODE_ID = (1u << NODE_BITS) - 1;
+    static constexpr uint64_t EPOCH_MS = 1735689600000ULL;  // 2025-01-01 00:00:00 UTC
+
+    static IdGenerator& getInstance();
+
+    /**
+     * 设置节点 ID（0 ~ 63），多实例部署时每个实例必须不同；应在处理请求前调用
+     */
+    void setNodeId(uint32_t nodeId);
+    uint32_t nodeId() const { return nodeId_.load(std::memory_order_relaxed); }
+
+    /**
+     * 生成下一个 ID
+     */
+    uint64_t next();
+
+    /**
+     * ID 中的毫秒时间戳（Unix 毫秒）
+     */
+    static int64_t timestampOf(uint64_t id) {
+        return static_cast<int64_t>((id >> (NODE_BITS + SLOT_BITS + SEQUENCE_BITS)) + EPOCH_MS);
+    }
+
+private:
+    static constexpr size_t SLOT_COUNT = size_t(1) << SLOT_BITS;
+    static constexpr uint32_t SHARED_SLOT = SLOT_COUNT - 1;  // 槽位用尽的线程共用
+    static constexpr uint32_t MAX_SEQUENCE = (1u << SEQUENCE_BITS) - 1;
+
+    friend struct IdThreadState;
+
+    IdGenerator() = default;
+    IdGenerator(const IdGenerator&) = delete;
+    IdGenerator& operator=(const IdGenerator&) = delete;
+
+    uint64_t compose(uint64_t ms, uint32_t slot, uint32_t sequence) const;
+    uint64_t nextShared(uint64_t now);
+
+    /**
+     * 占用空闲槽位，返回该槽位上次发出的最大时间戳；没有空闲槽位时返回 SHARED_SLOT
+     */
+    uint32_t acquireSlot(uint64_t& lastMs);
+    void releaseSlot(uint32_t slot, uint64_t lastMs);
+
+    struct alignas(64) Slot {
+        std::atomic<bool> used{false};
+        std::atomic<uint64_t> lastMs{0};
+    };
+
+    std::atomic<uint32_t> nodeId_{0};
+    Slot slots_[SLOT_COUNT];
+    alignas(64) std::atomic<uint64_t> shared_{0};  // 共享槽位状态：毫秒 << SEQUENCE_BITS | 序号
+};
+
+}  // namespace im
+
+#endif  // ID_GENERATOR_H
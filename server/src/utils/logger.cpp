@@ -1,50 +1,348 @@
 #include "logger.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace im {
 
-std::string Logger::getCurrentTime() {
-    auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
-    
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return oss.str();
+namespace {
+
+using Clock = std::chrono::system_clock;
+
+struct LogRecord {
+    Logger::Level level = Logger::Level::INFO;
+    Clock::time_point time;
+    std::string message;
+};
+
+/**
+ * 单生产者单消费者环形队列：生产者是写日志的业务线程，消费者是后台写线程
+ */
+class LogQueue {
+public:
+    static constexpr size_t CAPACITY = 8192;  // 必须是 2 的幂
+
+    bool push(LogRecord&& record) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == CAPACITY) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == CAPACITY) {
+                return false;
+            }
+        }
+        slots_[tail & (CAPACITY - 1)] = std::move(record);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 是否已过半，用于提前唤醒写线程；每 64 条才读取一次 head，减少跨核访问
+    bool nearlyFull() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if ((tail & 63) != 0) {
+            return false;
+        }
+        headCache_ = head_.load(std::memory_order_acquire);
+        return tail - headCache_ >= CAPACITY / 2;
+    }
+
+    bool pop(LogRecord& record) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        record = std::move(slots_[head & (CAPACITY - 1)]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    // 生产者线程已退出，写线程取空后即可移除
+    std::atomic<bool> closed{false};
+
+private:
+    std::unique_ptr<LogRecord[]> slots_{new LogRecord[CAPACITY]};
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t headCache_ = 0;  // 生产者缓存的 head，减少跨核读取
+};
+
+// 队列满时让出 CPU 的重试次数，仍然满则丢弃并计数
+constexpr int PUSH_RETRY_COUNT = 64;
+
+// 写线程单轮最多取出的记录数，避免某个线程的队列独占写线程
+constexpr size_t MAX_RECORDS_PER_QUEUE = 1024;
+
+// 写线程空闲时的等待间隔
+constexpr auto IDLE_WAIT = std::chrono::milliseconds(5);
+
+/**
+ * 按秒缓存格式化后的时间，同一秒内的记录直接复用
+ */
+struct TimeCache {
+    std::time_t second = -1;
+    char text[32] = {0};
+};
+
+struct LoggerState {
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<LogQueue>> queues;
+
+    std::atomic<bool> running{false};
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCond;
+
+    // 以下仅由写线程访问
+    Logger::Options options;
+    FILE* file = nullptr;
+    size_t fileSize = 0;
+
+    // 写线程未运行时的同步写路径
+    std::mutex syncMutex;
+    TimeCache syncTime;
+
+    std::atomic<uint64_t> dropped{0};
+};
+
+LoggerState& state() {
+    static LoggerState* instance = new LoggerState();  // 不析构，保证退出阶段仍可写日志
+    return *instance;
 }
 
-std::string Logger::levelToString(Level level) {
+/**
+ * 线程退出时标记其队列关闭，由写线程取空后回收
+ */
+struct ThreadQueueHolder {
+    std::shared_ptr<LogQueue> queue;
+
+    ~ThreadQueueHolder() {
+        if (queue) {
+            queue->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+LogQueue& threadQueue() {
+    thread_local ThreadQueueHolder holder;
+    if (!holder.queue) {
+        holder.queue = std::make_shared<LogQueue>();
+        LoggerState& s = state();
+        std::lock_guard<std::mutex> lock(s.registryMutex);
+        s.queues.push_back(holder.queue);
+    }
+    return *holder.queue;
+}
+
+const char* levelToString(Logger::Level level) {
     switch (level) {
-        case Level::DEBUG: return "DEBUG";
-        case Level::INFO:  return "INFO ";
-        case Level::WARN:  return "WARN ";
-        case Level::ERROR: return "ERROR";
+        case Logger::Level::DEBUG: return "DEBUG";
+        case Logger::Level::INFO:  return "INFO ";
+        case Logger::Level::WARN:  return "WARN ";
+        case Logger::Level::ERROR: return "ERROR";
         default: return "UNKNOWN";
     }
 }
 
-void Logger::log(Level level, const std::string& message) {
-    std::cout << "[" << getCurrentTime() << "] "
-              << "[" << levelToString(level) << "] "
-              << message << std::endl;
+void appendRecord(TimeCache& timeCache, std::string& out, const LogRecord& record) {
+    std::time_t second = Clock::to_time_t(record.time);
+    if (second != timeCache.second) {
+        std::tm tm;
+        localtime_r(&second, &tm);
+        std::strftime(timeCache.text, sizeof(timeCache.text), "%Y-%m-%d %H:%M:%S", &tm);
+        timeCache.second = second;
+    }
+    out.push_back('[');
+    out.append(timeCache.text);
+    out.append("] [");
+    out.append(levelToString(record.level));
+    out.append("] ");
+    out.append(record.message);
+    out.push_back('\n');
 }
 
-void Logger::debug(const std::string& message) {
-    log(Level::DEBUG, message);
+void openLogFile(LoggerState& s) {
+    s.file = std::fopen(s.options.filePath.c_str(), "a");
+    s.fileSize = 0;
+    if (s.file) {
+        std::fseek(s.file, 0, SEEK_END);
+        long size = std::ftell(s.file);
+        s.fileSize = size > 0 ? static_cast<size_t>(size) : 0;
+    } else {
+        std::fprintf(stderr, "无法打开日志文件 %s，改为输出到标准输出\n", s.options.filePath.c_str());
+    }
 }
 
-void Logger::info(const std::string& message) {
-    log(Level::INFO, message);
+void rotateLogFile(LoggerState& s) {
+    std::fclose(s.file);
+    s.file = nullptr;
+    const std::string& path = s.options.filePath;
+    for (int i = s.options.maxFiles - 1; i >= 1; --i) {
+        std::rename((path + "." + std::to_string(i)).c_str(),
+                    (path + "." + std::to_string(i + 1)).c_str());
+    }
+    if (s.options.maxFiles > 0) {
+        std::rename(path.c_str(), (path + ".1").c_str());
+    } else {
+        std::remove(path.c_str());
+    }
+    openLogFile(s);
 }
 
-void Logger::warn(const std::string& message) {
-    log(Level::WARN, message);
+void writeBatch(LoggerState& s, const std::string& batch) {
+    FILE* out = s.file ? s.file : stdout;
+    std::fwrite(batch.data(), 1, batch.size(), out);
+    std::fflush(out);
+    if (s.file) {
+        s.fileSize += batch.size();
+        if (s.fileSize >= s.options.maxFileSize) {
+            rotateLogFile(s);
+        }
+    }
 }
 
-void Logger::error(const std::string& message) {
-    log(Level::ERROR, message);
+void writerLoop() {
+    LoggerState& s = state();
+    std::vector<std::shared_ptr<LogQueue>> queues;
+    std::string batch;
+    LogRecord record;
+    TimeCache timeCache;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(s.registryMutex);
+            queues = s.queues;
+        }
+
+        size_t count = 0;
+        bool hasClosed = false;
+        for (auto& queue : queues) {
+            for (size_t i = 0; i < MAX_RECORDS_PER_QUEUE && queue->pop(record); ++i) {
+                appendRecord(timeCache, batch, record);
+                ++count;
+            }
+            hasClosed = hasClosed || queue->closed.load(std::memory_order_acquire);
+        }
+
+        uint64_t dropped = s.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            appendRecord(timeCache, batch,
+                         LogRecord{Logger::Level::WARN, Clock::now(),
+                                   "日志队列已满，丢弃 " + std::to_string(dropped) + " 条日志"});
+        }
+
+        if (!batch.empty()) {
+            writeBatch(s, batch);
+            batch.clear();
+        }
+
+        if (hasClosed) {
+            // 回收已退出线程的队列；closed 之后不会再有新记录，取空即可移除
+            std::lock_guard<std::mutex> lock(s.registryMutex);
+            s.queues.erase(std::remove_if(s.queues.begin(), s.queues.end(),
+                                          [](const std::shared_ptr<LogQueue>& queue) {
+                                              return queue->closed.load(std::memory_order_acquire) &&
+                                                     queue->empty();
+                                          }),
+                           s.queues.end());
+        }
+
+        if (count == 0) {
+            if (!s.running.load(std::memory_order_acquire)) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(s.wakeMutex);
+            s.wakeCond.wait_for(lock, IDLE_WAIT);
+        }
+    }
 }
 
-}  // namespace im
+}  // namespace
 
+void Logger::init(const Options& options) {
+    LoggerState& s = state();
+    if (s.running.load()) {
+        return;
+    }
+    setLevel(options.level);
+    s.options = options;
+    if (!s.options.filePath.empty()) {
+        openLogFile(s);
+    }
+    s.running.store(true, std::memory_order_release);
+    s.writer = std::thread(writerLoop);
+}
+
+void Logger::shutdown() {
+    LoggerState& s = state();
+    if (!s.running.exchange(false)) {
+        return;
+    }
+    s.wakeCond.notify_all();
+    if (s.writer.joinable()) {
+        s.writer.join();
+    }
+    if (s.file) {
+        std::fclose(s.file);
+        s.file = nullptr;
+    }
+}
+
+Logger::Level Logger::parseLevel(const std::string& name, Level fallback) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower == "debug") return Level::DEBUG;
+    if (lower == "info") return Level::INFO;
+    if (lower == "warn" || lower == "warning") return Level::WARN;
+    if (lower == "error") return Level::ERROR;
+    return fallback;
+}
+
+void Logger::log(Level level, std::string message) {
+    LoggerState& s = state();
+    LogRecord record{level, Clock::now(), std::move(message)};
+
+    if (s.running.load(std::memory_order_acquire)) {
+        // 信号处理函数打断本线程的入队时不能重入同一个 SPSC 队列，只计入丢弃数
+        thread_local bool pushing = false;
+        if (pushing) {
+            s.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pushing = true;
+        LogQueue& queue = threadQueue();
+        bool pushed = false;
+        for (int i = 0; i < PUSH_RETRY_COUNT && !pushed; ++i) {
+            pushed = queue.push(std::move(record));
+            if (!pushed) {
+                std::this_thread::yield();
+            }
+        }
+        pushing = false;
+        if (queue.nearlyFull()) {
+            s.wakeCond.notify_one();
+        }
+        if (!pushed) {
+            s.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // 写线程未运行（启动前或关闭后）：同步写标准输出
+    std::lock_guard<std::mutex> lock(s.syncMutex);
+    std::string line;
+    appendRecord(s.syncTime, line, record);
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    std::fflush(stdout);
+}
+
+}  // namespace im
@@ -1,14 +1,34 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
 #include <string>
-#include <iostream>
-#include <sstream>
-#include <iomanip>
-#include <ctime>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * 编译期最低日志级别（0=DEBUG 1=INFO 2=WARN 3=ERROR）
+ *
+ * 低于该级别的 LOG_* 调用在编译期被剔除，参数既不求值也不格式化。
+ * 由 CMake 设置，Release 构建默认为 2。
+ */
+#ifndef IM_LOG_MIN_LEVEL
+#define IM_LOG_MIN_LEVEL 0
+#endif
 
 namespace im {
 
+/**
+ * 异步日志
+ *
+ * 前端：LOG_* 宏先做编译期与运行期级别过滤，通过后才对参数求值并拼接；
+ * 后端：每个线程一个无锁 SPSC 队列，后台写线程批量取出后写入文件（按大小轮转）或标准输出。
+ * init() 之前与 shutdown() 之后退化为同步写标准输出。
+ */
 class Logger {
 public:
     enum class Level {
@@ -17,19 +37,91 @@ public:
         WARN,
         ERROR
     };
-    
-    static void log(Level level, const std::string& message);
-    static void debug(const std::string& message);
-    static void info(const std::string& message);
-    static void warn(const std::string& message);
-    static void error(const std::string& message);
+
+    struct Options {
+        Level level = Level::INFO;
+        std::string filePath;                   // 为空时写标准输出
+        size_t maxFileSize = 64 << 20;          // 单个日志文件上限，超过后轮转
+        int maxFiles = 5;                       // 保留的历史文件数：file.1 ... file.N
+    };
+
+    /**
+     * 启动后台写线程
+     */
+    static void init(const Options& options);
+
+    /**
+     * 写出队列中剩余的日志并停止后台写线程
+     */
+    static void shutdown();
+
+    static void setLevel(Level level) {
+        level_.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    static bool isEnabled(Level level) {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 解析级别名称（debug/info/warn/error，不区分大小写），无法识别时返回 fallback
+     */
+    static Level parseLevel(const std::string& name, Level fallback);
+
+    /**
+     * 提交一条已格式化的日志，调用方负责级别过滤（一般通过 LOG_* 宏）
+     */
+    static void log(Level level, std::string message);
+
+    /**
+     * 依次拼接参数：字符串、字符、布尔、整数与浮点数
+     */
+    template <typename... Args>
+    static std::string format(Args&&... args) {
+        std::string out;
+        (append(out, std::forward<Args>(args)), ...);
+        return out;
+    }
+
+    static std::string format(std::string&& message) {
+        return std::move(message);
+    }
 
 private:
-    static std::string getCurrentTime();
-    static std::string levelToString(Level level);
+    static void append(std::string& out, std::string_view value) { out.append(value); }
+    static void append(std::string& out, const char* value) { out.append(value); }
+    static void append(std::string& out, char value) { out.push_back(value); }
+    static void append(std::string& out, bool value) { out.append(value ? "true" : "false"); }
+
+    template <typename T>
+    static std::enable_if_t<std::is_arithmetic_v<T>> append(std::string& out, T value) {
+        char buf[32];
+        if constexpr (std::is_floating_point_v<T>) {
+            int n = std::snprintf(buf, sizeof(buf), "%g", static_cast<double>(value));
+            out.append(buf, n > 0 ? static_cast<size_t>(n) : 0);
+        } else {
+            auto result = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, result.ptr);
+        }
+    }
+
+    static inline std::atomic<int> level_{static_cast<int>(Level::INFO)};
 };
 
 }  // namespace im
 
-#endif  // LOGGER_H
+#define IM_LOG(level, ...)                                                              \
+    do {                                                                                \
+        if constexpr (static_cast<int>(level) >= IM_LOG_MIN_LEVEL) {                    \
+            if (::im::Logger::isEnabled(level)) {                                       \
+                ::im::Logger::log(level, ::im::Logger::format(__VA_ARGS__));            \
+            }                                                                           \
+        }                                                                               \
+    } while (0)
 
+#define LOG_DEBUG(...) IM_LOG(::im::Logger::Level::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  IM_LOG(::im::Logger::Level::INFO, __VA_ARGS__)
+#define LOG_WARN(...)  IM_LOG(::im::Logger::Level::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) IM_LOG(::im::Logger::Level::ERROR, __VA_ARGS__)
+
+#endif  // LOGGER_H
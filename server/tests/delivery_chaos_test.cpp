@@ -0,0 +1,189 @@
+#include "test.h"
+#include "test_client.h"
+#include "handler/message_handler.h"
+#include "protocol/encoder.h"
+#include "protocol/json_reader.h"
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_map>
+
+namespace im {
+
+namespace {
+
+constexpr size_t MESSAGE_COUNT = 2000;
+constexpr size_t BATCH_SIZE = 100;
+
+std::string sendBody(size_t index) {
+    return R"({"to_user_id":"bob","content":"m)" + std::to_string(index) + R"(","client_msg_id":"c)" +
+           std::to_string(index) + R"("})";
+}
+
+/**
+ * 从应答中取出 client_msg_id / content 与 msg_id
+ */
+void parseMessage(std::string_view body, std::string_view idKey, std::string& id, int64_t& msgId) {
+    JsonReader reader(body);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key == idKey) {
+            value.copyTo(id);
+        } else if (key == "msg_id") {
+            value.getInt(msgId);
+        }
+    }
+}
+
+/**
+ * 新连接并以 userId 登录；接收方登录后与 LoginHandler 一样重发上次未确认的消息
+ */
+std::unique_ptr<TestClient> reconnect(TestServer& server, const std::string& userId) {
+    auto client = std::make_unique<TestClient>(server.port());
+    int fd = server.authenticateNext(userId);
+    CHECK(fd >= 0);
+    if (userId == "bob") {
+        MessageHandler::retransmitPending(server.server(), fd, userId);
+    }
+    return client;
+}
+
+}  // namespace
+
+/**
+ * 发送方与接收方的连接在收发途中被随机断开：
+ * - 发送方重连后重发所有未确认的 client_msg_id，去重窗口保证每条只转发一次、msg_id 不变
+ * - 接收方重连后收到所有未确认的投递（可能重复，客户端按 msg_id 去重）
+ * 最终每条消息恰好以一个 msg_id 到达接收方，全部确认后不再有待确认投递
+ */
+IM_TEST(delivery_chaos) {
+    TestServer server;
+    std::mt19937 random(17);
+
+    std::unique_ptr<TestClient> alice = reconnect(server, "alice");
+    std::unique_ptr<TestClient> bob = reconnect(server, "bob");
+
+    std::map<std::string, int64_t> acked;           // client_msg_id -> msg_id（发送方视角）
+    std::unordered_map<int64_t, std::string> seen;  // msg_id -> content（接收方按 msg_id 去重后）
+    size_t duplicateFrames = 0;
+    size_t aliceDrops = 0;
+    size_t bobDrops = 0;
+    PacketView packet;
+
+    // 接收方读到的每一帧：按 msg_id 去重，按需回 DELIVERY_ACK
+    auto onReceive = [&](const PacketView& frame, bool ack) {
+        CHECK(frame.type == MessageType::RECEIVE_MESSAGE);
+        std::string content;
+        int64_t msgId = 0;
+        parseMessage(frame.data, "content", content, msgId);
+        CHECK(msgId != 0);
+        auto [it, inserted] = seen.emplace(msgId, content);
+        if (!inserted) {
+            CHECK(it->second == content);
+            ++duplicateFrames;
+        }
+        if (ack) {
+            bob->send(MessageType::DELIVERY_ACK, R"({"msg_id":")" + std::to_string(msgId) + R"("})");
+        }
+    };
+
+    for (size_t batchStart = 0; batchStart < MESSAGE_COUNT; batchStart += BATCH_SIZE) {
+        std::vector<uint8_t> stream;
+        for (size_t i = batchStart; i < batchStart + BATCH_SIZE; ++i) {
+            std::vector<uint8_t> frame = MessageEncoder::encode(MessageType::SEND_MESSAGE, sendBody(i));
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        // 一半的批次：发送方只写出一部分（可能断在包中间），读到部分确认后断开
+        if (random() % 2 == 0) {
+            alice->sendRaw(stream.data(), random() % stream.size());
+            for (size_t n = random() % BATCH_SIZE; n > 0 && alice->receive(packet, std::chrono::milliseconds(20));
+                 --n) {
+                std::string clientMsgId;
+                int64_t msgId = 0;
+                parseMessage(packet.data, "client_msg_id", clientMsgId, msgId);
+                acked.emplace(clientMsgId, msgId);
+            }
+            alice = reconnect(server, "alice");
+            ++aliceDrops;
+        }
+
+        // 重发本批所有未确认的消息，直到全部确认；重复确认的 msg_id 必须与首次一致
+        for (int round = 0; round < 5; ++round) {
+            std::set<std::string> waiting;
+            for (size_t i = batchStart; i < batchStart + BATCH_SIZE; ++i) {
+                std::string clientMsgId = "c" + std::to_string(i);
+                if (!acked.count(clientMsgId)) {
+                    waiting.insert(clientMsgId);
+                    CHECK(alice->send(MessageType::SEND_MESSAGE, sendBody(i)));
+                }
+            }
+            while (!waiting.empty() && alice->receive(packet)) {
+                CHECK(packet.type == MessageType::SEND_MESSAGE_ACK);
+                std::string clientMsgId;
+                int64_t msgId = 0;
+                parseMessage(packet.data, "client_msg_id", clientMsgId, msgId);
+                auto [it, inserted] = acked.emplace(clientMsgId, msgId);
+                CHECK_EQ(it->second, msgId);
+                waiting.erase(clientMsgId);
+            }
+            if (waiting.empty()) {
+                break;
+            }
+        }
+
+        // 接收方：读一部分、只确认其中一部分，一半的批次随后断开重连
+        for (size_t n = random() % (BATCH_SIZE * 2); n > 0 && bob->receive(packet, std::chrono::milliseconds(20));
+             --n) {
+            onReceive(packet, random() % 2 == 0);
+        }
+        if (random() % 2 == 0) {
+            bob = reconnect(server, "bob");
+            ++bobDrops;
+        }
+
+        // 每个用户的待确认记录有上限，超出时最早的被淘汰（之后只能从历史拉取）；
+        // 积压超过上限的一半时接收方读完并确认，让本测试只覆盖可重发的范围
+        if (server.server().deliveries().size() > DeliveryTracker::MAX_PER_USER / 2) {
+            while (bob->receive(packet, std::chrono::milliseconds(50))) {
+                onReceive(packet, true);
+            }
+        }
+    }
+    CHECK_EQ(acked.size(), MESSAGE_COUNT);
+
+    // 接收方读完并确认全部消息；确认丢失的会在下次登录时重发
+    for (int round = 0; round < 5 && server.server().deliveries().size() > 0; ++round) {
+        while (bob->receive(packet, std::chrono::milliseconds(200))) {
+            onReceive(packet, true);
+        }
+        for (int wait = 0; wait < 100 && server.server().deliveries().size() > 0; ++wait) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (server.server().deliveries().size() > 0) {
+            bob = reconnect(server, "bob");
+        }
+    }
+
+    CHECK(aliceDrops > 0);
+    CHECK(bobDrops > 0);
+    CHECK_EQ(server.server().deliveries().size(), size_t(0));
+    CHECK_EQ(server.server().sendDedup().size(), MESSAGE_COUNT);
+    CHECK_EQ(seen.size(), MESSAGE_COUNT);
+
+    // 恰好一次：每个 client_msg_id 对应的 msg_id 到达接收方，内容一致，且没有多余的 msg_id
+    std::set<int64_t> distinct;
+    for (const auto& [clientMsgId, msgId] : acked) {
+        auto it = seen.find(msgId);
+        CHECK(it != seen.end());
+        CHECK(it->second == "m" + clientMsgId.substr(1));
+        distinct.insert(msgId);
+    }
+    CHECK_EQ(distinct.size(), MESSAGE_COUNT);
+    std::printf("发送方断开 %zu 次，接收方断开 %zu 次，接收方收到重复帧 %zu 个\n", aliceDrops, bobDrops,
+                duplicateFrames);
+}
+
+}  // namespace im
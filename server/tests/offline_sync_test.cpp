@@ -0,0 +1,132 @@
+#include "test.h"
+#include "test_client.h"
+#include "handler/offline_handler.h"
+#include "protocol/json_reader.h"
+#include "store/message_store.h"
+#include <filesystem>
+#include <future>
+#include <stdlib.h>
+#include <vector>
+
+namespace im {
+
+namespace {
+
+constexpr size_t MESSAGE_COUNT = 5;
+
+/**
+ * 取出一页同步响应中的序号
+ */
+std::vector<int64_t> parseSequences(std::string_view body) {
+    std::vector<int64_t> sequences;
+    JsonReader reader(body);
+    std::string_view key;
+    JsonValue value;
+    while (reader.next(key, value)) {
+        if (key != "messages") {
+            continue;
+        }
+        JsonArrayReader messages(value);
+        JsonValue element;
+        while (messages.next(element)) {
+            JsonReader fields(element.raw());
+            std::string_view field;
+            JsonValue seq;
+            int64_t sequence = 0;
+            while (fields.next(field, seq)) {
+                if (field == "seq") {
+                    seq.getInt(sequence);
+                }
+            }
+            sequences.push_back(sequence);
+        }
+    }
+    return sequences;
+}
+
+/**
+ * 接收下一页同步响应；超时返回空
+ */
+std::vector<int64_t> receivePage(TestClient& client, std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    PacketView packet;
+    while (client.receive(packet, timeout)) {
+        if (packet.type == MessageType::OFFLINE_SYNC_RESPONSE) {
+            return parseSequences(packet.data);
+        }
+    }
+    return {};
+}
+
+}  // namespace
+
+/**
+ * 推送后未确认的页面可以从客户端上报的位置重新拉取，收件箱只删除到确认的位置；
+ * 未上报序号的重复登录不会再次收到已推送的页面
+ */
+IM_TEST(offline_resume) {
+    char pattern[] = "/tmp/imtest.XXXXXX";
+    CHECK(mkdtemp(pattern) != nullptr);
+    MessageStoreOptions options;
+    options.directory = pattern;
+    MessageStore& store = MessageStore::getInstance();
+    CHECK(store.open(options));
+
+    TestServer server;
+    const std::string userId = "carol";
+    for (size_t i = 0; i < MESSAGE_COUNT; ++i) {
+        OfflineHandler::store(server.server(), userId, R"({"content":"m)" + std::to_string(i) + R"("})");
+    }
+    std::promise<void> durable;
+    store.append("u:test:marker", "{}", [&durable](uint64_t, bool) { durable.set_value(); });
+    durable.get_future().wait();
+
+    // 第一次登录推送整页，但客户端在收到前断开（页面丢失）
+    std::vector<int64_t> all;
+    {
+        TestClient client(server.port());
+        int fd = server.authenticateNext(userId);
+        CHECK(fd >= 0);
+        OfflineHandler::syncOnLogin(server.server(), fd, userId, std::nullopt);
+        all = receivePage(client);
+        CHECK_EQ(all.size(), MESSAGE_COUNT);
+    }
+    const std::string inbox = MessageStore::inboxKey(userId);
+    CHECK_EQ(store.trimmedThrough(inbox), 0);
+
+    // 未上报序号再次登录：已推送的页面不重复推送
+    {
+        TestClient client(server.port());
+        int fd = server.authenticateNext(userId);
+        CHECK(fd >= 0);
+        OfflineHandler::syncOnLogin(server.server(), fd, userId, std::nullopt);
+        CHECK(receivePage(client, std::chrono::milliseconds(300)).empty());
+    }
+
+    // 上报上次收到的序号 0：从 0 续传，整页重新送达
+    TestClient client(server.port());
+    int fd = server.authenticateNext(userId);
+    CHECK(fd >= 0);
+    OfflineHandler::syncOnLogin(server.server(), fd, userId, 0);
+    CHECK(receivePage(client) == all);
+
+    // 确认前两条：只删除到确认位置，之后的消息仍可从该位置拉取
+    CHECK(client.send(MessageType::OFFLINE_SYNC_REQUEST, R"({"after_seq":)" + std::to_string(all[1]) + "}"));
+    std::vector<int64_t> rest = receivePage(client);
+    CHECK(rest == std::vector<int64_t>(all.begin() + 2, all.end()));
+    CHECK_EQ(store.trimmedThrough(inbox), all[1]);
+
+    // 再次请求同一位置（上一页丢失）仍能拿到
+    CHECK(client.send(MessageType::OFFLINE_SYNC_REQUEST, R"({"after_seq":)" + std::to_string(all[1]) + "}"));
+    CHECK(receivePage(client) == rest);
+
+    CHECK(client.send(MessageType::OFFLINE_SYNC_REQUEST, R"({"after_seq":)" + std::to_string(all.back()) + "}"));
+    CHECK(receivePage(client).empty());
+    CHECK_EQ(store.trimmedThrough(inbox), all.back());
+
+    client.close();
+    store.close();
+    std::error_code ec;
+    std::filesystem::remove_all(pattern, ec);
+}
+
+}  // namespace im
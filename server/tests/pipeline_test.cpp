@@ -0,0 +1,139 @@
+#include "test.h"
+#include "test_client.h"
+#include "protocol/decoder.h"
+#include "protocol/encoder.h"
+#include <sys/socket.h>
+#include <charconv>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace im {
+
+namespace {
+
+constexpr size_t PACKET_COUNT = 10000;
+
+/**
+ * 第 i 个包：数据体以序号开头，后面补长度不等的填充；每 1000 个包有一个超过 Reactor 暂存区的大包
+ */
+std::string makeBody(size_t index, std::mt19937& random) {
+    std::string body = std::to_string(index);
+    size_t padding = index % 1000 == 999 ? 10000 : random() % 200;
+    body.append(padding, ' ');
+    return body;
+}
+
+uint64_t parseSequence(std::string_view body) {
+    uint64_t value = 0;
+    auto result = std::from_chars(body.data(), body.data() + body.size(), value);
+    if (result.ec != std::errc()) {
+        failTest(__FILE__, __LINE__, "数据体没有序号: " + std::string(body.substr(0, 32)));
+    }
+    return value;
+}
+
+/**
+ * 把 stream 按 [1, maxChunk] 的随机长度分片写入解码器，每片之后取出所有完整的包
+ */
+std::vector<std::string> decodeInChunks(const std::vector<uint8_t>& stream, size_t maxChunk, std::mt19937& random) {
+    MessageDecoder decoder;
+    std::vector<std::string> bodies;
+    size_t offset = 0;
+    while (offset < stream.size()) {
+        size_t remaining = stream.size() - offset;
+        size_t chunk = maxChunk >= stream.size() ? remaining : std::min<size_t>(remaining, 1 + random() % maxChunk);
+        decoder.prepareWrite(chunk);
+        std::memcpy(decoder.writeData(), stream.data() + offset, chunk);
+        decoder.commitWrite(chunk);
+        offset += chunk;
+
+        PacketView packet;
+        while (decoder.nextPacket(packet)) {
+            CHECK(packet.type == MessageType::HEARTBEAT);
+            bodies.emplace_back(packet.data);
+            decoder.consume();
+        }
+        CHECK(!decoder.hasError());
+    }
+    CHECK_EQ(decoder.bufferedBytes(), size_t(0));
+    return bodies;
+}
+
+}  // namespace
+
+/**
+ * 1 万个包首尾相接：一次整体到达与随机分片到达，解码出的包数与顺序都不变
+ */
+IM_TEST(decoder_pipeline) {
+    std::mt19937 random(2);
+    std::vector<uint8_t> stream;
+    for (size_t i = 0; i < PACKET_COUNT; ++i) {
+        std::vector<uint8_t> frame = MessageEncoder::encode(MessageType::HEARTBEAT, makeBody(i, random));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    for (size_t maxChunk : {stream.size(), size_t(7), size_t(4096), size_t(65536)}) {
+        std::vector<std::string> bodies = decodeInChunks(stream, maxChunk, random);
+        CHECK_EQ(bodies.size(), PACKET_COUNT);
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            CHECK_EQ(parseSequence(bodies[i]), i);
+        }
+    }
+}
+
+/**
+ * 经过 EPOLLET 读取循环：心跳（Reactor 直接应答或交给线程池）与需要登录的请求（回 1001）
+ * 交错流水线发送 1 万个，应答的个数与顺序必须与请求一一对应
+ */
+IM_TEST(server_pipeline) {
+    TestServer server;
+
+    std::mt19937 random(3);
+    std::vector<uint8_t> stream;
+    std::vector<MessageType> expected;
+    expected.reserve(PACKET_COUNT);
+    for (size_t i = 0; i < PACKET_COUNT; ++i) {
+        std::vector<uint8_t> frame;
+        if (random() % 4 == 0) {
+            frame = MessageEncoder::encode(MessageType::USER_LIST_REQUEST, "{}");
+            expected.push_back(MessageType::ERROR);
+        } else {
+            frame = MessageEncoder::encode(MessageType::HEARTBEAT, makeBody(i, random));
+            expected.push_back(MessageType::HEARTBEAT_RESPONSE);
+        }
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    TestClient client(server.port());
+    std::thread writer([&client, &stream] { client.sendRaw(stream.data(), stream.size()); });
+
+    size_t received = 0;
+    std::string failure;
+    PacketView packet;
+    while (received < PACKET_COUNT) {
+        if (!client.receive(packet)) {
+            failure = "连接在收到 " + std::to_string(received) + " 个应答后中断或超时";
+            break;
+        }
+        if (packet.type != expected[received]) {
+            failure = "第 " + std::to_string(received) + " 个应答类型不符: " +
+                      std::to_string(static_cast<uint16_t>(packet.type));
+            break;
+        }
+        if (packet.type == MessageType::ERROR && packet.data.find("1001") == std::string_view::npos) {
+            failure = "错误应答不是 1001: " + std::string(packet.data);
+            break;
+        }
+        ++received;
+    }
+
+    // 提前失败时写线程可能仍阻塞在 send 上，先断开再等它退出
+    shutdown(client.fd(), SHUT_RDWR);
+    writer.join();
+    if (!failure.empty()) {
+        failTest(__FILE__, __LINE__, failure);
+    }
+}
+
+}  // namespace im
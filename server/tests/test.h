@@ -0,0 +1,61 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace im {
+
+/**
+ * 最小测试框架：IM_TEST 定义的用例在静态初始化时登记，
+ * imserver_tests <名称> 只运行该用例（ctest 按用例逐个调用），不带参数时运行全部
+ */
+struct TestCase {
+    const char* name;
+    void (*function)();
+};
+
+std::vector<TestCase>& testRegistry();
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*function)()) { testRegistry().push_back({name, function}); }
+};
+
+/**
+ * 断言失败：抛出异常结束当前用例
+ */
+struct TestFailure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+[[noreturn]] inline void failTest(const char* file, int line, const std::string& message) {
+    throw TestFailure(std::string(file) + ":" + std::to_string(line) + ": " + message);
+}
+
+}  // namespace im
+
+#define IM_TEST(name)                                                    \
+    static void name();                                                  \
+    static ::im::TestRegistrar name##_registrar(#name, &name);           \
+    static void name()
+
+#define CHECK(condition)                                                 \
+    do {                                                                 \
+        if (!(condition)) {                                              \
+            ::im::failTest(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+        }                                                                \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                 \
+    do {                                                                                           \
+        const auto& actualValue = (actual);                                                        \
+        const auto& expectedValue = (expected);                                                    \
+        if (!(actualValue == expectedValue)) {                                                     \
+            ::im::failTest(__FILE__, __LINE__,                                                     \
+                           "CHECK_EQ(" #actual ", " #expected "): " + std::to_string(actualValue) + \
+                               " != " + std::to_string(expectedValue));                            \
+        }                                                                                          \
+    } while (0)
+
+#endif  // TEST_H
@@ -0,0 +1,118 @@
+#include "test_client.h"
+#include "test.h"
+#include "protocol/encoder.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace im {
+
+TestServer::TestServer(size_t workerCount, std::chrono::milliseconds presenceWindow,
+                       PresenceService::AudienceResolver presenceAudience) {
+    for (int attempt = 0; attempt < 20; ++attempt) {
+        port_ = 20000 + (getpid() * 7 + attempt * 131) % 30000;
+        auto server = std::make_unique<EpollServer>(port_, 1, workerCount);
+        server->setPresenceWindow(presenceWindow);
+        server->setPresenceAudience(presenceAudience);
+        if (server->start()) {
+            server_ = std::move(server);
+            break;
+        }
+    }
+    if (!server_) {
+        failTest(__FILE__, __LINE__, "无法绑定测试端口");
+    }
+    loop_ = std::thread([this] { server_->run(); });
+}
+
+TestServer::~TestServer() {
+    server_->stop();
+    loop_.join();
+}
+
+int TestServer::authenticateNext(const std::string& userId, const std::string& username) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (const auto& connection : server_->getConnectionStats()) {
+            if (connection.userId.empty()) {
+                server_->setClientAuthenticated(connection.fd, userId, username);
+                return connection.fd;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return -1;
+}
+
+TestClient::TestClient(int port) {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(fd_ >= 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+}
+
+TestClient::~TestClient() {
+    close();
+}
+
+bool TestClient::sendRaw(const uint8_t* data, size_t length) {
+    size_t offset = 0;
+    while (offset < length) {
+        ssize_t sent = ::send(fd_, data + offset, length - offset, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool TestClient::send(MessageType type, std::string_view body) {
+    std::vector<uint8_t> frame = MessageEncoder::encode(type, body);
+    return sendRaw(frame.data(), frame.size());
+}
+
+bool TestClient::receive(PacketView& packet, std::chrono::milliseconds timeout) {
+    if (holding_) {
+        decoder_.consume();
+        holding_ = false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!decoder_.nextPacket(packet)) {
+        if (decoder_.hasError()) {
+            return false;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        pollfd pfd{fd_, POLLIN, 0};
+        if (remaining.count() < 0 || poll(&pfd, 1, static_cast<int>(remaining.count())) <= 0) {
+            return false;
+        }
+        decoder_.prepareWrite(65536);
+        ssize_t bytesRead = recv(fd_, decoder_.writeData(), 65536, 0);
+        if (bytesRead <= 0) {
+            return false;
+        }
+        decoder_.commitWrite(static_cast<size_t>(bytesRead));
+    }
+    holding_ = true;
+    return true;
+}
+
+void TestClient::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+}  // namespace im
@@ -0,0 +1,79 @@
+#ifndef TEST_CLIENT_H
+#define TEST_CLIENT_H
+
+#include "protocol/decoder.h"
+#include "protocol/message.h"
+#include "server/epoll_server.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <thread>
+
+namespace im {
+
+/**
+ * 在回环地址上运行的测试服务器：绑定一个空闲端口（被占用时换一个），事件循环在独立线程中运行
+ */
+class TestServer {
+public:
+    explicit TestServer(size_t workerCount = 2, std::chrono::milliseconds presenceWindow = std::chrono::milliseconds(0),
+                        PresenceService::AudienceResolver presenceAudience = nullptr);
+    ~TestServer();
+
+    EpollServer& server() { return *server_; }
+    int port() const { return port_; }
+
+    /**
+     * 等待一个尚未登录的连接出现，把它认证为 userId（代替走数据库的登录流程）
+     *
+     * @return 服务端 fd，超时返回 -1
+     */
+    int authenticateNext(const std::string& userId, const std::string& username = "");
+
+private:
+    int port_ = 0;
+    std::unique_ptr<EpollServer> server_;
+    std::thread loop_;
+};
+
+/**
+ * 阻塞式测试客户端：按帧发送，用 MessageDecoder 按帧接收
+ */
+class TestClient {
+public:
+    explicit TestClient(int port);
+    ~TestClient();
+
+    TestClient(const TestClient&) = delete;
+    TestClient& operator=(const TestClient&) = delete;
+
+    int fd() const { return fd_; }
+
+    /**
+     * 写出全部字节，连接已断开时返回 false
+     */
+    bool sendRaw(const uint8_t* data, size_t length);
+    bool send(MessageType type, std::string_view body);
+
+    /**
+     * 接收下一帧，视图在下次调用 receive 之前有效；超时或连接关闭返回 false
+     * （timeout 为 0 时只取已到达的数据，不等待）
+     */
+    bool receive(PacketView& packet, std::chrono::milliseconds timeout = std::chrono::seconds(10));
+
+    /**
+     * 直接关闭 Socket（接收缓冲区中有未读数据时内核会发 RST），模拟连接中途断开
+     */
+    void close();
+
+private:
+    int fd_ = -1;
+    MessageDecoder decoder_;
+    bool holding_ = false;  // 上次返回的帧尚未 consume
+};
+
+}  // namespace im
+
+#endif  // TEST_CLIENT_H
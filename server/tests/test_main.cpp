@@ -0,0 +1,46 @@
+#include "test.h"
+#include "utils/logger.h"
+#include <signal.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace im {
+
+std::vector<TestCase>& testRegistry() {
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+}  // namespace im
+
+int main(int argc, char* argv[]) {
+    // 测试只关心警告以上的日志；对端关闭时写入返回 EPIPE 而不是终止进程
+    im::Logger::setLevel(im::Logger::Level::WARN);
+    signal(SIGPIPE, SIG_IGN);
+
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int ran = 0;
+    int failed = 0;
+    for (const auto& test : im::testRegistry()) {
+        if (filter && std::strcmp(filter, test.name) != 0) {
+            continue;
+        }
+        ++ran;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            test.function();
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+            std::printf("[通过] %s (%lld ms)\n", test.name, static_cast<long long>(elapsed.count()));
+        } catch (const std::exception& e) {
+            ++failed;
+            std::printf("[失败] %s: %s\n", test.name, e.what());
+        }
+    }
+    if (ran == 0) {
+        std::printf("没有匹配的测试: %s\n", filter ? filter : "");
+        return 1;
+    }
+    return failed == 0 ? 0 : 1;
+}